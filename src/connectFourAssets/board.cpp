@@ -7,6 +7,13 @@
  */
 
 #include "board.hpp"
+#include "evalConfig.hpp"
+#include "evalWeights.hpp"
+#include "evalKernel.hpp"
+#include "openingBook.hpp"
+#include "patternEval.hpp"
+#include "tablebase.hpp"
+#include "zobrist.hpp"
 #include <iostream>
 #include <omp.h>
 
@@ -20,12 +27,22 @@ Board::Board(uint_fast8_t width, uint_fast8_t height, uint_fast8_t winningStreak
     // Iniitalize the next row for all columns to 0
     this->next_row = new uint_fast8_t[width];
     for (uint_fast8_t i = 0; i < width; i++) this->next_row[i] = 0;
+
+    this->zobrist = new uint64_t[2 * width * height];
+    Zobrist::fillTable(this->zobrist, width * height);
+    this->mirrorZobrist = new uint64_t[2 * width * height];
+    Zobrist::fillMirrorTable(this->mirrorZobrist, width, height);
+    this->positionKey = Zobrist::kEmptyKey;
+    this->mirrorPositionKey = Zobrist::kEmptyKey;
 }
 
 Board::~Board()
 {
     delete[] this->board;
     delete[] this->next_row;
+    delete[] this->zobrist;
+    delete[] this->mirrorZobrist;
+    delete this->patternEvaluator;
 }
 
 int Board::AddPiece(Player player, uint_fast8_t column)
@@ -49,7 +66,8 @@ int Board::AddPiece(Player player, uint_fast8_t column)
     }
 
     // Set the status of the position of the board. 
-    this->board[this->width * this->next_row[column] + column] = player == Player::Red ? SlotStatus::Red : SlotStatus::Yellow;
+    this->makeMove(this->width * this->next_row[column] + column,
+                   player == Player::Red ? SlotStatus::Red : SlotStatus::Yellow);
     this->next_row[column] += 1; 
 
     // Now, check if the game is over and if we have a winner
@@ -193,6 +211,36 @@ Player Board::DetermineWinner()
     return Player::None;
 }
 
+bool Board::isWinningMove(int index)
+{
+    const SlotStatus color = this->board[index];
+    if (color == SlotStatus::Empty) return false;
+
+    const int row = index / this->width;
+    const int column = index % this->width;
+    // Horizontal, vertical and both diagonals, walked both ways from the slot
+    const int rowStep[4] = {0, 1, 1, 1};
+    const int columnStep[4] = {1, 0, 1, -1};
+    for (int dir = 0; dir < 4; dir++)
+    {
+        int streak = 1;
+        for (int sign = -1; sign <= 1; sign += 2)
+        {
+            int r = row + sign * rowStep[dir];
+            int c = column + sign * columnStep[dir];
+            while (r >= 0 && r < this->height && c >= 0 && c < this->width &&
+                   this->board[this->width * r + c] == color)
+            {
+                streak++;
+                r += sign * rowStep[dir];
+                c += sign * columnStep[dir];
+            }
+        }
+        if (streak >= this->winningStreakSize) return true;
+    }
+    return false;
+}
+
 bool Board::IsFull()
 {
     const uint_fast8_t totalSlots = this->width * this->height;
@@ -222,10 +270,32 @@ void Board::Reset()
         this->next_row[i] = 0;
     }
 
+    this->positionKey = Zobrist::kEmptyKey;
+    this->mirrorPositionKey = Zobrist::kEmptyKey;
     this->winner = Player::None;
     this->isGameOver = false;
 }
 
+int Board::EvaluateBoard(Player player) {
+    if (EvalConfig::heuristic() == EvalConfig::Heuristic::Pattern &&
+        PatternEvaluator::supportsGeometry(this->width, this->height, this->winningStreakSize)) {
+        if (!this->patternEvaluator)
+            this->patternEvaluator = new PatternEvaluator(this->width, this->height, this->winningStreakSize);
+        return this->patternEvaluator->evaluate(this->board, player);
+    }
+
+    // The vectorized kernel is a drop-in for the scalar evaluation below
+    if (EvalKernel::supportsGeometry(this->width, this->height, this->winningStreakSize)) {
+        return EvalKernel::evaluate(this->board, this->width, this->height,
+                                    this->winningStreakSize, player);
+    }
+    return this->EvaluateBoardScalar(player);
+}
+
+bool Board::evalMirrorSymmetric() {
+    return EvalConfig::mirrorSymmetric(this->width, this->height, this->winningStreakSize);
+}
+
 /**
  * SATVIK: The evaluation function can be enhanced. A static evaluation function
  * is easier to implement but a threat based function will be more intelligent.
@@ -233,7 +303,7 @@ void Board::Reset()
  * for either case.
  *
  */
-int Board::EvaluateBoard(Player player) {
+int Board::EvaluateBoardScalar(Player player) {
     // Heuristics for finding the score of the current board
     
     /**
@@ -266,16 +336,17 @@ int Board::EvaluateBoard(Player player) {
     
     /**
      * Streaks of a longer length should have a higher impact on the score-
-     * An polynomial distribution can be used.
+     * An polynomial distribution can be used. The weights are in evalWeights.hpp.
      */
 
+    const int32_t* weights = EvalWeights::streakTable();
     uint32_t score_for = 0;
     uint32_t score_against = 0;
     uint32_t score = 0;
     for(int streak = this->winningStreakSize; streak >= 2; streak--) {
         	score_for = this->checkStreak(color_for, streak);
         	score_against = this->checkStreak(color_against, streak);
-        	score += (score_for - score_against) * streak * streak * streak;
+        	score += (score_for - score_against) * (uint32_t)weights[streak];
     }
 
     return score;
@@ -387,6 +458,31 @@ bool Board::isLegalMove(int index) {
     return true;
 }
 
+int Board::bookMove(Player player) {
+    const OpeningBook& book = OpeningBook::shared();
+    if(!book.matches(this->width, this->height, this->winningStreakSize)) return -1;
+    // Mirror images share an entry if the heuristic the book was built with
+    // scores them the same
+    uint64_t key = book.canonicalKeys() ? this->canonicalKey() : this->positionKey;
+    BookEntry entry;
+    if(!book.lookup(Zobrist::scoredKey(key, player), entry)) return -1;
+    // The entry belongs to the orientation of the key
+    int column = entry.column;
+    if(this->positionKey != key) column = this->width - 1 - column;
+    if(column >= this->width) return -1;
+    for(int row = this->height - 1; row >= 0; row--) {
+        int index = row * this->width + column;
+        if(this->board[index] == SlotStatus::Empty) return index;
+    }
+    return -1;
+}
+
+int Board::tablebaseMove(Player player) {
+    const Tablebase& tablebase = Tablebase::shared();
+    if(!tablebase.matches(this->width, this->height, this->winningStreakSize)) return -1;
+    return tablebase.bestMove(this->board, player);
+}
+
 SlotStatus* Board::getBoard() {
     return this->board;
 }
@@ -432,7 +528,8 @@ int Board::playMove(int column, Player player) {
 }
 
 void Board::playMove(int index, SlotStatus color) {
-    this->board[index] = color;
+    if(this->board[index] != SlotStatus::Empty) this->undoMove(index);
+    if(color != SlotStatus::Empty) this->makeMove(index, color);
 }
 
 int Board::conv2DTo1D(int row, int column) {
@@ -15,14 +15,25 @@
 #include <cstdint>
 #include <sstream>
 #include <climits>
+#include <string>
+#include <vector>
 
 #define DEBUG 1
 
+class PatternEvaluator;
+
 class Board {
 
     protected:
         SlotStatus *board;
     private: 
+        // Zobrist values of this geometry, red at 2 * index and yellow at
+        // 2 * index + 1 (see zobrist.hpp)
+        uint64_t *zobrist;
+        // Same layout, with the values of the mirrored slots
+        uint64_t *mirrorZobrist;
+        uint64_t positionKey;
+        uint64_t mirrorPositionKey;
         uint_fast8_t *next_row;
         uint_fast8_t width;
         uint_fast8_t height;
@@ -30,11 +41,13 @@ class Board {
         
         bool isGameOver = false;
         Player winner = Player::None;
+        // Built on first use of the pattern heuristic
+        PatternEvaluator *patternEvaluator = nullptr;
         bool determineIfPlayerIsWinner(Player player);
 
     public:
         Board(uint_fast8_t width = 7, uint_fast8_t height = 6, uint_fast8_t winningStreakSize = 4);
-        ~Board();
+        virtual ~Board();
 
         // Allows a player to drop their piece into the specified column.
         // Note that the column is 0-indexed.
@@ -68,6 +81,16 @@ class Board {
          */
         virtual int EvaluateBoard(Player player);
 
+        /**
+         * @brief      Scalar reference for EvaluateBoard. EvaluateBoard runs the
+         * vectorized kernel in evalKernel.hpp, which must match this bit for bit.
+         *
+         * @param[in]  player  Current player
+         *
+         * @return     The score of the given board
+         */
+        int EvaluateBoardScalar(Player player);
+
         /**
          * @brief      Checks the number of consecutive pieces in the horizontal
          * vertial and diagonal directions 
@@ -84,6 +107,17 @@ class Board {
         uint32_t checkVertStreak(SlotStatus color, int streak); 
         uint32_t checkDiagStreak(SlotStatus color, int streak); 
 
+        /**
+         * @brief      Determines whether the piece on the specified index is part
+         * of a winning streak. Only looks at the lines through that slot, so a
+         * search that stops at the first win can use it as its terminal check.
+         *
+         * @param[in]  index  The index of the last piece played
+         *
+         * @return     True if the piece completes a winning streak
+         */
+        bool isWinningMove(int index);
+
         /**
          * @brief      Determines whether the specified index is legal move.
          *
@@ -93,6 +127,80 @@ class Board {
          */
         bool isLegalMove(int index);
 
+        /**
+         * @brief      Looks the position up in the shared opening book.
+         *
+         * @param[in]  player  The player to move
+         *
+         * @return     The index of the book move, -1 if the position is not in
+         * the book or no book for this geometry is open
+         */
+        int bookMove(Player player);
+
+        /**
+         * @brief      Looks the position up in the shared tablebase.
+         *
+         * @param[in]  player  The player to move
+         *
+         * @return     The index of a move that keeps the exact game value, -1
+         * if no tablebase for this geometry is open
+         */
+        int tablebaseMove(Player player);
+
+        /**
+         * @brief      64 bit Zobrist key of the current position. Kept up to date
+         * (with the mirror key) by every method that adds or removes a piece.
+         */
+        uint64_t key() { return positionKey; }
+
+        /**
+         * @brief      Key of the position mirrored left to right.
+         */
+        uint64_t mirrorKey() { return mirrorPositionKey; }
+
+        /**
+         * @brief      Key shared by the position and its mirror image. Stores of
+         * values that do not change under mirroring should use this one.
+         */
+        uint64_t canonicalKey() { return positionKey < mirrorPositionKey ? positionKey : mirrorPositionKey; }
+
+        /**
+         * @brief      Determines if the position is its own mirror image, where
+         * mirrored moves lead to equivalent positions.
+         */
+        bool isSymmetric() { return positionKey == mirrorPositionKey; }
+
+        /**
+         * @brief      Determines if EvaluateBoard scores a position and its
+         * mirror image the same, so that stores can use canonicalKey.
+         */
+        bool evalMirrorSymmetric();
+
+        /**
+         * @brief      Drops a piece on the slot index and updates the key. The
+         * search uses this and undoMove instead of writing to the board.
+         *
+         * @param[in]  index  The index of an empty slot
+         * @param[in]  color  The color of the piece
+         */
+        void makeMove(int index, SlotStatus color) {
+            this->board[index] = color;
+            this->positionKey ^= this->zobrist[2 * index + (color == SlotStatus::Yellow)];
+            this->mirrorPositionKey ^= this->mirrorZobrist[2 * index + (color == SlotStatus::Yellow)];
+        }
+
+        /**
+         * @brief      Takes back the piece on the slot index and updates the key.
+         *
+         * @param[in]  index  The index of an occupied slot
+         */
+        void undoMove(int index) {
+            const int entry = 2 * index + (this->board[index] == SlotStatus::Yellow);
+            this->positionKey ^= this->zobrist[entry];
+            this->mirrorPositionKey ^= this->mirrorZobrist[entry];
+            this->board[index] = SlotStatus::Empty;
+        }
+
         /**
          * @brief      Gets the board handle.
          *
@@ -124,4 +232,33 @@ class Board {
 
 };
 
+/**
+ * @brief      Resets the board and plays up to plies random moves on it, Red
+ * first, stopping early at a win or a full board. The random positions of
+ * the diagnostics and of self-play all come from here.
+ *
+ * @param      moves  Set to the columns played as 1 based digits if not null
+ *
+ * @return     The player to move
+ */
+template <class Rng>
+Player randomPosition(Board& board, Rng& rng, int plies, std::string* moves = nullptr) {
+    const int width = board.getWidth();
+    board.Reset();
+    if (moves) moves->clear();
+    Player turn = Player::Red;
+    for (int p = 0; p < plies && !board.IsFull(); p++) {
+        // Columns that still have room have an empty top slot
+        std::vector<int> open;
+        for (int c = 0; c < width; c++)
+            if (board.getBoard()[c] == SlotStatus::Empty) open.push_back(c);
+        int column = open[rng() % open.size()];
+        board.playMove(column + 1, turn);
+        if (moves) *moves += (char)('1' + column);
+        turn = PlayerHelpers::OppositePlayer(turn);
+        if (board.DetermineWinner() != Player::None) break;
+    }
+    return turn;
+}
+
 #endif
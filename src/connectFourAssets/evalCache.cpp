@@ -0,0 +1,26 @@
+/**
+ * @defgroup   EVAL_CACHE
+ *
+ * @brief      Direct mapped cache of leaf evaluations.
+ *
+ * @date       2021
+ */
+
+#include "evalCache.hpp"
+
+EvalCache::EvalCache(size_t sizeKb)
+{
+    size_t entries = 1;
+    while (entries * 2 * sizeof(Entry) <= sizeKb * 1024) entries *= 2;
+    _entries.resize(entries);
+    _mask = entries - 1;
+    clear();
+}
+
+void EvalCache::clear()
+{
+    for (Entry& entry : _entries) {
+        entry.key = 0;
+        entry.score = 0;
+    }
+}
@@ -0,0 +1,80 @@
+/**
+ * @defgroup   EVAL_CACHE
+ *
+ * @brief      Small direct mapped cache of leaf evaluations. Positions reached
+ * again through a transposition at the search horizon reuse the stored score
+ * instead of being evaluated again.
+ *
+ * Each key maps to exactly one slot and a store always overwrites it, so the
+ * cache is lossy but never needs any bookkeeping. It is sized in KB and the
+ * default is meant to stay resident in L2 next to the search.
+ *
+ * @date       2021
+ */
+#ifndef __EVAL_CACHE__
+#define __EVAL_CACHE__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class EvalCache
+{
+    public:
+        /**
+         * @brief      Constructs a new instance.
+         *
+         * @param[in]  sizeKb  The cache size in KB, rounded down to a power of
+         * two number of entries
+         */
+        explicit EvalCache(size_t sizeKb);
+
+        /**
+         * @brief      Looks up a score.
+         *
+         * @param[in]  key    The position key, 0 is never stored
+         * @param      score  Set to the cached score on a hit
+         *
+         * @return     True on a hit
+         */
+        bool probe(uint64_t key, int& score) {
+            ++_probes;
+            const Entry& entry = _entries[key & _mask];
+            if (entry.key != key) return false;
+            ++_hits;
+            score = entry.score;
+            return true;
+        }
+
+        /**
+         * @brief      Stores a score, replacing whatever was in its slot.
+         */
+        void store(uint64_t key, int score) {
+            Entry& entry = _entries[key & _mask];
+            entry.key = key;
+            entry.score = score;
+        }
+
+        // Drops all entries
+        void clear();
+
+        uint64_t hits() const { return _hits; }
+        uint64_t probes() const { return _probes; }
+        double hitRate() const { return _probes ? (double)_hits / _probes : 0.0; }
+        void resetStats() { _hits = 0; _probes = 0; }
+
+        size_t sizeKb() const { return _entries.size() * sizeof(Entry) / 1024; }
+
+    private:
+        struct Entry {
+            uint64_t key;
+            int32_t score;
+        };
+
+        std::vector<Entry> _entries;
+        uint64_t _mask;
+        uint64_t _hits = 0;
+        uint64_t _probes = 0;
+};
+
+#endif
@@ -0,0 +1,109 @@
+/**
+ * @defgroup   EVAL_CONFIG
+ *
+ * @brief      Process wide evaluation settings.
+ *
+ * @date       2021
+ */
+
+#include "evalConfig.hpp"
+#include "patternEval.hpp"
+
+#include <atomic>
+
+namespace
+{
+    std::atomic<int> g_heuristic((int)EvalConfig::Heuristic::Streak);
+    std::atomic<bool> g_rowParity(false);
+    std::atomic<int> g_evalCacheKb(EvalConfig::kDefaultEvalCacheKb);
+    std::atomic<int> g_transpositionKb(EvalConfig::kDefaultTranspositionKb);
+    std::atomic<bool> g_keepTranspositions(false);
+    std::atomic<bool> g_ponder(false);
+    std::atomic<int> g_searchDriver((int)EvalConfig::SearchDriver::Minimax);
+}
+
+EvalConfig::Heuristic EvalConfig::heuristic()
+{
+    return (Heuristic)g_heuristic.load(std::memory_order_relaxed);
+}
+
+void EvalConfig::setHeuristic(Heuristic heuristic)
+{
+    g_heuristic.store((int)heuristic, std::memory_order_relaxed);
+}
+
+bool EvalConfig::rowParity()
+{
+    return g_rowParity.load(std::memory_order_relaxed);
+}
+
+void EvalConfig::setRowParity(bool enabled)
+{
+    g_rowParity.store(enabled, std::memory_order_relaxed);
+}
+
+bool EvalConfig::mirrorSymmetric(int width, int height, int winningStreakSize)
+{
+    return heuristic() == Heuristic::Pattern &&
+           PatternEvaluator::supportsGeometry(width, height, winningStreakSize);
+}
+
+int EvalConfig::evalCacheKb()
+{
+    return g_evalCacheKb.load(std::memory_order_relaxed);
+}
+
+void EvalConfig::setEvalCacheKb(int sizeKb)
+{
+    g_evalCacheKb.store(sizeKb < 0 ? 0 : sizeKb, std::memory_order_relaxed);
+}
+
+int EvalConfig::transpositionKb()
+{
+    return g_transpositionKb.load(std::memory_order_relaxed);
+}
+
+void EvalConfig::setTranspositionKb(int sizeKb)
+{
+    g_transpositionKb.store(sizeKb < 0 ? 0 : sizeKb, std::memory_order_relaxed);
+}
+
+bool EvalConfig::keepTranspositions()
+{
+    return g_keepTranspositions.load(std::memory_order_relaxed);
+}
+
+void EvalConfig::setKeepTranspositions(bool enabled)
+{
+    g_keepTranspositions.store(enabled, std::memory_order_relaxed);
+}
+
+bool EvalConfig::ponder()
+{
+    return g_ponder.load(std::memory_order_relaxed);
+}
+
+void EvalConfig::setPonder(bool enabled)
+{
+    g_ponder.store(enabled, std::memory_order_relaxed);
+}
+
+EvalConfig::SearchDriver EvalConfig::searchDriver()
+{
+    return (SearchDriver)g_searchDriver.load(std::memory_order_relaxed);
+}
+
+void EvalConfig::setSearchDriver(SearchDriver driver)
+{
+    g_searchDriver.store((int)driver, std::memory_order_relaxed);
+}
+
+const char* EvalConfig::searchDriverName(SearchDriver driver)
+{
+    switch (driver) {
+        case SearchDriver::AlphaBeta: return "alphabeta";
+        case SearchDriver::Aspiration: return "aspiration";
+        case SearchDriver::Mtdf: return "mtdf";
+        default: return "minimax";
+    }
+}
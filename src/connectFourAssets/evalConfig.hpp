@@ -0,0 +1,61 @@
+/**
+ * @defgroup   EVAL_CONFIG
+ *
+ * @brief      Process wide evaluation settings. They are set once from the
+ * command line before any solver is built and read by every board.
+ *
+ * @date       2021
+ */
+#ifndef __EVAL_CONFIG__
+#define __EVAL_CONFIG__
+
+namespace EvalConfig
+{
+    // Streak is the original streak counting heuristic with the weights of
+    // evalWeights.hpp, Pattern is the table driven window evaluation in
+    // patternEval.hpp
+    enum class Heuristic {Streak = 0, Pattern};
+
+    Heuristic heuristic();
+    void setHeuristic(Heuristic heuristic);
+
+    // Weight pattern threats by the parity of the row they sit on
+    bool rowParity();
+    void setRowParity(bool enabled);
+
+    // Whether the heuristic boards of this geometry evaluate with scores a
+    // position and its mirror image the same, which lets caches share entries
+    // between them. The streak heuristic does not, checkDiagStreak only walks
+    // the '\' diagonals, and geometries the pattern evaluator cannot handle
+    // fall back to it.
+    bool mirrorSymmetric(int width, int height, int winningStreakSize);
+
+    // Leaf evaluation cache in front of the solvers' horizon evaluations,
+    // sized in KB (0 turns it off)
+    constexpr int kDefaultEvalCacheKb = 256;
+    int evalCacheKb();
+    void setEvalCacheKb(int sizeKb);
+
+    // Transposition table of each solver, sized in KB (0 turns it off). It
+    // is kept across moves, and across games when keepTranspositions is set.
+    constexpr int kDefaultTranspositionKb = 4 * 1024;
+    int transpositionKb();
+    void setTranspositionKb(int sizeKb);
+    bool keepTranspositions();
+    void setKeepTranspositions(bool enabled);
+
+    // Solvers in the tournaments search on the opponent's time
+    bool ponder();
+    void setPonder(bool enabled);
+
+    // Root driver of the minimax solvers. Minimax searches every node, the
+    // others prune with alpha-beta: one full window, an aspiration window
+    // around the previous score, or a sequence of MTD(f) null windows. All of
+    // them pick the same moves.
+    enum class SearchDriver {Minimax = 0, AlphaBeta, Aspiration, Mtdf};
+    SearchDriver searchDriver();
+    void setSearchDriver(SearchDriver driver);
+    const char* searchDriverName(SearchDriver driver);
+}
+
+#endif
@@ -0,0 +1,408 @@
+/**
+ * @defgroup   EVAL_KERNEL
+ *
+ * @brief      Runtime dispatch, scalar (SWAR) and SSE2 paths of the
+ * evaluation and playout kernels. The AVX2 paths live in evalKernelAvx2.cpp so
+ * that only that file is compiled with -mavx2.
+ *
+ * @date       2021
+ */
+
+#include "evalKernel.hpp"
+#include "evalKernelImpl.hpp"
+#include "evalWeights.hpp"
+#include "playoutKernelImpl.hpp"
+
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // 8 cells per 64 bit word. Used when no vector unit is available.
+    struct SwarVec {
+        typedef uint64_t T;
+        enum { lanes = 8 };
+        static constexpr uint64_t kLow = 0x0101010101010101ULL;
+        static constexpr uint64_t kHigh7 = 0x7f7f7f7f7f7f7f7fULL;
+
+        static T load(const uint8_t* p) { T v; std::memcpy(&v, p, sizeof(v)); return v; }
+        static T eq(T a, uint8_t c) {
+            // 0xff in every byte of a that equals c
+            T y = a ^ (kLow * c);
+            T zero = ~(((y & kHigh7) + kHigh7) | y | kHigh7);
+            return (zero >> 7) * 0xff;
+        }
+        static T and_(T a, T b) { return a & b; }
+        static T andnot(T a, T b) { return ~a & b; }
+        static uint32_t count(T a) { return __builtin_popcountll(a & kLow); }
+        static bool any(T a) { return a != 0; }
+    };
+
+#if defined(__SSE2__)
+    struct Sse2Vec {
+        typedef __m128i T;
+        enum { lanes = 16 };
+        static T load(const uint8_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+        static T eq(T a, uint8_t c) { return _mm_cmpeq_epi8(a, _mm_set1_epi8((char)c)); }
+        static T and_(T a, T b) { return _mm_and_si128(a, b); }
+        static T andnot(T a, T b) { return _mm_andnot_si128(a, b); }
+        static uint32_t count(T a) { return __builtin_popcount((uint32_t)_mm_movemask_epi8(a)); }
+        static bool any(T a) { return _mm_movemask_epi8(a) != 0; }
+    };
+#endif
+
+    // One 64 bit board per lane, used by the batch kernel without a vector unit
+    struct Scalar64 {
+        typedef uint64_t T;
+        enum { lanes = 1 };
+        static T load(const uint64_t* p) { return *p; }
+        static void store(uint64_t* p, T a) { *p = a; }
+        static T zero() { return 0; }
+        static T set1(uint64_t v) { return v; }
+        static T shr(T a, int n) { return n >= 64 ? 0 : a >> n; }
+        static T shl(T a, int n) { return n >= 64 ? 0 : a << n; }
+        static T and_(T a, T b) { return a & b; }
+        static T or_(T a, T b) { return a | b; }
+        static T andnot(T a, T b) { return ~a & b; }
+        static T add(T a, T b) { return a + b; }
+        static T popcount(T a) { return __builtin_popcountll(a); }
+        static bool any(T a) { return a != 0; }
+        static T xor_(T a, T b) { return a ^ b; }
+        static T shlv(T a, T n) { return a << n; }
+        static T mul32(T a, T b) { return (a & 0xffffffffULL) * (b & 0xffffffffULL); }
+        // All ones in the lanes that are non zero / equal
+        static T nonzero(T a) { return a ? ~T(0) : 0; }
+        static T eq(T a, T b) { return a == b ? ~T(0) : 0; }
+    };
+
+#if defined(__SSE2__)
+    struct Sse2x64 {
+        typedef __m128i T;
+        enum { lanes = 2 };
+        static T load(const uint64_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+        static void store(uint64_t* p, T a) { _mm_storeu_si128((__m128i*)p, a); }
+        static T zero() { return _mm_setzero_si128(); }
+        static T set1(uint64_t v) { return _mm_set1_epi64x((long long)v); }
+        static T shr(T a, int n) { return _mm_srl_epi64(a, _mm_cvtsi32_si128(n)); }
+        static T shl(T a, int n) { return _mm_sll_epi64(a, _mm_cvtsi32_si128(n)); }
+        static T and_(T a, T b) { return _mm_and_si128(a, b); }
+        static T or_(T a, T b) { return _mm_or_si128(a, b); }
+        static T andnot(T a, T b) { return _mm_andnot_si128(a, b); }
+        static T add(T a, T b) { return _mm_add_epi64(a, b); }
+        static T popcount(T a) {
+            // SSE2 has no byte shuffle, so count bits with the usual SWAR
+            // steps and sum the bytes of each lane with psadbw
+            const __m128i m1 = _mm_set1_epi8(0x55);
+            const __m128i m2 = _mm_set1_epi8(0x33);
+            const __m128i m4 = _mm_set1_epi8(0x0f);
+            a = _mm_sub_epi8(a, _mm_and_si128(_mm_srli_epi64(a, 1), m1));
+            a = _mm_add_epi8(_mm_and_si128(a, m2), _mm_and_si128(_mm_srli_epi64(a, 2), m2));
+            a = _mm_and_si128(_mm_add_epi8(a, _mm_srli_epi64(a, 4)), m4);
+            return _mm_sad_epu8(a, _mm_setzero_si128());
+        }
+        static bool any(T a) { return _mm_movemask_epi8(_mm_cmpeq_epi8(a, _mm_setzero_si128())) != 0xffff; }
+        static T xor_(T a, T b) { return _mm_xor_si128(a, b); }
+        static T shlv(T a, T n) {
+            // No per lane shift before AVX2, shift twice and keep one lane of each
+            T low = _mm_sll_epi64(a, n);
+            T high = _mm_sll_epi64(a, _mm_unpackhi_epi64(n, n));
+            return _mm_castpd_si128(_mm_move_sd(_mm_castsi128_pd(high), _mm_castsi128_pd(low)));
+        }
+        static T mul32(T a, T b) { return _mm_mul_epu32(a, b); }
+        static T eq(T a, T b) {
+            // 64 bit compare from the 32 bit halves
+            T halves = _mm_cmpeq_epi32(a, b);
+            return _mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+        }
+        static T nonzero(T a) { return _mm_xor_si128(eq(a, zero()), _mm_set1_epi32(-1)); }
+    };
+#endif
+
+    // Widest vector any kernel loads, the plane gets this much slack at the end
+    constexpr int kMaxLanes = 32;
+
+    EvalKernel::detail::Layout makeLayout(int width, int height, int winningStreakSize)
+    {
+        EvalKernel::detail::Layout layout;
+        layout.width = width;
+        layout.height = height;
+        layout.streak = winningStreakSize;
+        int diagReach = (width < height ? width : height) - 1;
+        layout.reach = diagReach > winningStreakSize ? diagReach : winningStreakSize;
+        // One more empty column/row than the furthest look-ahead means no
+        // window can wrap into a neighbouring row or leave the allocation.
+        int pad = layout.reach + 1;
+        layout.stride = width + pad;
+        layout.regionStart = pad * layout.stride;
+        layout.regionLen = height * layout.stride;
+        layout.size = (height + 2 * pad) * layout.stride + 2 * kMaxLanes;
+        return layout;
+    }
+
+    // Every thread keeps its own padded plane so the kernel can be called
+    // from the OpenMP solver without locking.
+    struct Scratch {
+        EvalKernel::detail::Layout layout = {};
+        std::vector<uint8_t> cells;
+    };
+
+    const uint8_t* fillPlane(const SlotStatus* board, int width, int height,
+                             int winningStreakSize, const EvalKernel::detail::Layout*& layout)
+    {
+        thread_local Scratch scratch;
+        if (scratch.layout.width != width || scratch.layout.height != height ||
+            scratch.layout.streak != winningStreakSize) {
+            scratch.layout = makeLayout(width, height, winningStreakSize);
+            // The padding is zero (SlotStatus::Empty) and never written again
+            scratch.cells.assign(scratch.layout.size, 0);
+        }
+        layout = &scratch.layout;
+
+        uint8_t* row = scratch.cells.data() + scratch.layout.regionStart;
+        for (int r = 0; r < height; r++, row += scratch.layout.stride) {
+            const SlotStatus* src = board + r * width;
+            for (int c = 0; c < width; c++) row[c] = (uint8_t)src[c];
+        }
+        return scratch.cells.data();
+    }
+
+    EvalKernel::detail::KernelFn kernelFor(EvalKernel::Isa isa)
+    {
+        switch (isa) {
+            case EvalKernel::Isa::AVX2: return EvalKernel::detail::countStreaksAvx2;
+            case EvalKernel::Isa::SSE2: return EvalKernel::detail::countStreaksSse2;
+            default: return EvalKernel::detail::countStreaksScalar;
+        }
+    }
+
+    EvalKernel::detail::BatchKernelFn batchKernelFor(EvalKernel::Isa isa)
+    {
+        switch (isa) {
+            case EvalKernel::Isa::AVX2: return EvalKernel::detail::countBatchAvx2;
+            case EvalKernel::Isa::SSE2: return EvalKernel::detail::countBatchSse2;
+            default: return EvalKernel::detail::countBatchScalar;
+        }
+    }
+
+    // Turns the streak counts of one board into the EvaluateBoard score
+    int scoreFromCounts(const uint32_t* streaksFor, const uint32_t* streaksAgainst,
+                        bool winFor, bool winAgainst, int winningStreakSize)
+    {
+        // Same winner resolution as Board::DetermineWinner, two winners count as none
+        if (winFor != winAgainst) {
+            return winFor ? INT_MAX : INT_MIN;
+        }
+
+        // Keep the unsigned arithmetic of the scalar version so the scores match bit for bit
+        const int32_t* weights = EvalWeights::streakTable();
+        uint32_t score = 0;
+        for (uint32_t streak = winningStreakSize; streak >= 2; streak--) {
+            score += (streaksFor[streak] - streaksAgainst[streak]) * (uint32_t)weights[streak];
+        }
+        return score;
+    }
+
+    EvalKernel::Isa bestIsa()
+    {
+        if (EvalKernel::isaSupported(EvalKernel::Isa::AVX2)) return EvalKernel::Isa::AVX2;
+        if (EvalKernel::isaSupported(EvalKernel::Isa::SSE2)) return EvalKernel::Isa::SSE2;
+        return EvalKernel::Isa::Scalar;
+    }
+
+    std::atomic<int>& activeIsaSlot()
+    {
+        static std::atomic<int> isa((int)bestIsa());
+        return isa;
+    }
+}
+
+void EvalKernel::detail::countStreaksScalar(const uint8_t* cells, const Layout& layout, Counts& counts)
+{
+    countStreaksImpl<SwarVec>(cells, layout, counts);
+}
+
+void EvalKernel::detail::countStreaksSse2(const uint8_t* cells, const Layout& layout, Counts& counts)
+{
+#if defined(__SSE2__)
+    countStreaksImpl<Sse2Vec>(cells, layout, counts);
+#else
+    countStreaksImpl<SwarVec>(cells, layout, counts);
+#endif
+}
+
+void EvalKernel::detail::countBatchScalar(const uint64_t* red, const uint64_t* yellow,
+                                          const BitTables& tables, BatchCounts& counts)
+{
+    countBatchImpl<Scalar64>(red, yellow, tables, counts);
+}
+
+void EvalKernel::detail::countBatchSse2(const uint64_t* red, const uint64_t* yellow,
+                                        const BitTables& tables, BatchCounts& counts)
+{
+#if defined(__SSE2__)
+    countBatchImpl<Sse2x64>(red, yellow, tables, counts);
+#else
+    countBatchImpl<Scalar64>(red, yellow, tables, counts);
+#endif
+}
+
+void PlayoutKernel::detail::advanceScalar(Lanes& lanes, const Tables& tables)
+{
+    advanceImpl<Scalar64>(lanes, tables);
+}
+
+void PlayoutKernel::detail::advanceSse2(Lanes& lanes, const Tables& tables)
+{
+#if defined(__SSE2__)
+    advanceImpl<Sse2x64>(lanes, tables);
+#else
+    advanceImpl<Scalar64>(lanes, tables);
+#endif
+}
+
+bool EvalKernel::isaSupported(Isa isa)
+{
+    switch (isa) {
+        case Isa::Scalar:
+            return true;
+        case Isa::SSE2:
+#if defined(__SSE2__)
+            return true;
+#else
+            return false;
+#endif
+        case Isa::AVX2:
+#if defined(EVAL_KERNEL_AVX2) && (defined(__x86_64__) || defined(__i386__))
+            return __builtin_cpu_supports("avx2");
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+EvalKernel::Isa EvalKernel::activeIsa()
+{
+    return (Isa)activeIsaSlot().load(std::memory_order_relaxed);
+}
+
+void EvalKernel::setIsa(Isa isa)
+{
+    if (!isaSupported(isa)) isa = bestIsa();
+    activeIsaSlot().store((int)isa, std::memory_order_relaxed);
+}
+
+const char* EvalKernel::isaName(Isa isa)
+{
+    switch (isa) {
+        case Isa::AVX2: return "avx2";
+        case Isa::SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+bool EvalKernel::supportsGeometry(int width, int height, int winningStreakSize)
+{
+    return width > 0 && height > 0 && winningStreakSize >= 2 &&
+           winningStreakSize <= kMaxStreak;
+}
+
+int EvalKernel::evaluateWith(Isa isa, const SlotStatus* board, int width, int height,
+                             int winningStreakSize, Player player)
+{
+    const detail::Layout* layout;
+    const uint8_t* cells = fillPlane(board, width, height, winningStreakSize, layout);
+
+    detail::Counts counts;
+    kernelFor(isa)(cells, *layout, counts);
+
+    int forIdx = (player == Player::Red) ? 0 : 1;
+    int againstIdx = 1 - forIdx;
+    return scoreFromCounts(counts.streaks[forIdx], counts.streaks[againstIdx],
+                           counts.wins[forIdx], counts.wins[againstIdx], winningStreakSize);
+}
+
+int EvalKernel::evaluate(const SlotStatus* board, int width, int height,
+                         int winningStreakSize, Player player)
+{
+    return evaluateWith(activeIsa(), board, width, height, winningStreakSize, player);
+}
+
+BatchEvaluator::BatchEvaluator(int width, int height, int winningStreakSize)
+{
+    _tables.width = width;
+    _tables.height = height;
+    _tables.streak = winningStreakSize;
+    _tables.diagReach = (width < height ? width : height) - 1;
+    _tables.reach = _tables.diagReach > winningStreakSize ? _tables.diagReach : winningStreakSize;
+
+    const int dr[4] = {0, 1, 1, 1};
+    const int dc[4] = {1, 0, 1, -1};
+    const int mid = EvalKernel::detail::kMaxReach;
+    for (int dir = 0; dir < 4; dir++) {
+        for (int k = -mid; k <= mid; k++) {
+            _tables.shift[dir][mid + k] = k * (dr[dir] * width + dc[dir]);
+            uint64_t valid = 0;
+            for (int r = 0; r < height; r++) {
+                for (int c = 0; c < width; c++) {
+                    int rr = r + k * dr[dir];
+                    int cc = c + k * dc[dir];
+                    if (rr >= 0 && rr < height && cc >= 0 && cc < width) {
+                        valid |= uint64_t(1) << (r * width + c);
+                    }
+                }
+            }
+            _tables.valid[dir][mid + k] = valid;
+        }
+    }
+}
+
+bool BatchEvaluator::supportsGeometry(int width, int height, int winningStreakSize)
+{
+    return PositionHelpers::fitsBitboard(width, height) &&
+           EvalKernel::supportsGeometry(width, height, winningStreakSize);
+}
+
+void BatchEvaluator::evaluateBatch(const Position* positions, size_t n, int* scores_out) const
+{
+    evaluateBatchWith(EvalKernel::activeIsa(), positions, n, scores_out);
+}
+
+void BatchEvaluator::evaluateBatchWith(EvalKernel::Isa isa, const Position* positions, size_t n,
+                                       int* scores_out) const
+{
+    const int lanes = EvalKernel::detail::kBatchLanes;
+    EvalKernel::detail::BatchKernelFn kernel = batchKernelFor(isa);
+    alignas(32) uint64_t red[lanes];
+    alignas(32) uint64_t yellow[lanes];
+    EvalKernel::detail::BatchCounts counts;
+    uint32_t streaks[2][EvalKernel::kMaxStreak + 1] = {};
+
+    for (size_t block = 0; block < n; block += lanes) {
+        // Regroup the block so each color is contiguous across boards, the
+        // unused lanes of the last block are scored as empty boards
+        int used = (n - block) < (size_t)lanes ? (int)(n - block) : lanes;
+        for (int l = 0; l < lanes; l++) {
+            red[l] = l < used ? positions[block + l].red : 0;
+            yellow[l] = l < used ? positions[block + l].yellow : 0;
+        }
+        kernel(red, yellow, _tables, counts);
+
+        for (int l = 0; l < used; l++) {
+            for (int c = 0; c < 2; c++)
+                for (int S = 2; S <= _tables.streak; S++) streaks[c][S] = (uint32_t)counts.streaks[c][S][l];
+            int forIdx = (positions[block + l].player == Player::Red) ? 0 : 1;
+            int againstIdx = 1 - forIdx;
+            scores_out[block + l] = scoreFromCounts(streaks[forIdx], streaks[againstIdx],
+                                                    counts.wins[forIdx][l] != 0,
+                                                    counts.wins[againstIdx][l] != 0,
+                                                    _tables.streak);
+        }
+    }
+}
@@ -0,0 +1,162 @@
+/**
+ * @defgroup   EVAL_KERNEL
+ *
+ * @brief      Vectorized drop-in replacement for Board::EvaluateBoard.
+ *
+ * The board is copied into a zero padded byte plane so that every streak
+ * direction becomes a constant offset. All windows of the board are then
+ * scored with vector compares against the player colors, and the resulting
+ * lane masks are reduced with popcounts. The padding is wide enough that no
+ * window can wrap around into the next row.
+ *
+ * The scores are bit-identical to Board::EvaluateBoardScalar, including the
+ * way the scalar checkDiagStreak counts the '\' diagonals.
+ *
+ * @date       2021
+ */
+#ifndef __EVAL_KERNEL__
+#define __EVAL_KERNEL__
+
+#include "slotStatus.hpp"
+#include "player.hpp"
+#include "position.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace EvalKernel
+{
+    // Instruction sets the kernel has been compiled for. The best supported
+    // one is selected at runtime from the CPU features.
+    enum class Isa {Scalar = 0, SSE2, AVX2};
+
+    // Longest winning streak the kernel handles, longer ones use the scalar path
+    constexpr int kMaxStreak = 16;
+
+    /**
+     * @brief      Evaluates the board using the active instruction set.
+     *
+     * @param[in]  board              The board (row major, row 0 at the top)
+     * @param[in]  width              The width of the board
+     * @param[in]  height             The height of the board
+     * @param[in]  winningStreakSize  The winning streak size
+     * @param[in]  player             The player the score is computed for
+     *
+     * @return     The same score Board::EvaluateBoardScalar returns
+     */
+    int evaluate(const SlotStatus* board, int width, int height,
+                 int winningStreakSize, Player player);
+
+    /**
+     * @brief      Evaluates the board with an explicit instruction set. Used to
+     * validate every compiled path against the scalar reference.
+     */
+    int evaluateWith(Isa isa, const SlotStatus* board, int width, int height,
+                     int winningStreakSize, Player player);
+
+    /**
+     * @brief      Determines if the geometry can be handled by the kernel.
+     */
+    bool supportsGeometry(int width, int height, int winningStreakSize);
+
+    // Runtime dispatch helpers
+    bool isaSupported(Isa isa);
+    Isa activeIsa();
+    void setIsa(Isa isa);
+    const char* isaName(Isa isa);
+
+    namespace detail
+    {
+        // Geometry of the padded byte plane handed to the kernels
+        struct Layout {
+            int width;
+            int height;
+            int streak;
+            int reach;          // furthest offset (in cells) a window looks ahead
+            int stride;         // bytes per padded row
+            int regionStart;    // first byte of the first board row
+            int regionLen;      // bytes covered by the board rows
+            int size;           // total bytes including the padding
+        };
+
+        // Raw counts produced by a kernel for both colors (index 0 is red)
+        struct Counts {
+            uint32_t streaks[2][kMaxStreak + 1];
+            bool wins[2];
+        };
+
+        typedef void (*KernelFn)(const uint8_t* cells, const Layout& layout, Counts& counts);
+
+        void countStreaksScalar(const uint8_t* cells, const Layout& layout, Counts& counts);
+        void countStreaksSse2(const uint8_t* cells, const Layout& layout, Counts& counts);
+        void countStreaksAvx2(const uint8_t* cells, const Layout& layout, Counts& counts);
+
+        // Boards scored per batch kernel call, the AVX2 path holds four per register
+        constexpr int kBatchLanes = 8;
+        // Furthest a window can look ahead on a board of at most 64 slots
+        constexpr int kMaxReach = kMaxStreak;
+
+        // Shift and on-board mask that moves slot p + k*step of a direction to
+        // bit p of a bitboard. Directions are horizontal, vertical, '\' and '/'.
+        struct BitTables {
+            int width;
+            int height;
+            int streak;
+            int reach;
+            int diagReach;
+            int shift[4][2 * kMaxReach + 1];
+            uint64_t valid[4][2 * kMaxReach + 1];
+        };
+
+        // Raw counts for a block of kBatchLanes boards (index 0 is red)
+        struct BatchCounts {
+            uint64_t streaks[2][kMaxStreak + 1][kBatchLanes];
+            uint64_t wins[2][kBatchLanes];
+        };
+
+        typedef void (*BatchKernelFn)(const uint64_t* red, const uint64_t* yellow,
+                                      const BitTables& tables, BatchCounts& counts);
+
+        void countBatchScalar(const uint64_t* red, const uint64_t* yellow, const BitTables& tables, BatchCounts& counts);
+        void countBatchSse2(const uint64_t* red, const uint64_t* yellow, const BitTables& tables, BatchCounts& counts);
+        void countBatchAvx2(const uint64_t* red, const uint64_t* yellow, const BitTables& tables, BatchCounts& counts);
+    }
+}
+
+/**
+ * @brief      Scores many positions of one geometry per call. The positions
+ * are regrouped into blocks of kBatchLanes bitboards so the vector unit works
+ * on several boards at once (four per AVX2 register). The scores are the same
+ * as Board::EvaluateBoard for every position.
+ */
+class BatchEvaluator
+{
+    public:
+        BatchEvaluator(int width, int height, int winningStreakSize);
+
+        /**
+         * @brief      Determines if the geometry can be handled, which needs the
+         * board to fit in a 64 bit Position.
+         */
+        static bool supportsGeometry(int width, int height, int winningStreakSize);
+
+        /**
+         * @brief      Evaluates a batch of positions.
+         *
+         * @param[in]  positions   The positions, scored for their own player
+         * @param[in]  n           The number of positions
+         * @param      scores_out  Filled with one score per position
+         */
+        void evaluateBatch(const Position* positions, size_t n, int* scores_out) const;
+
+        /**
+         * @brief      Same as evaluateBatch with an explicit instruction set.
+         */
+        void evaluateBatchWith(EvalKernel::Isa isa, const Position* positions, size_t n,
+                               int* scores_out) const;
+
+    private:
+        EvalKernel::detail::BitTables _tables;
+};
+
+#endif
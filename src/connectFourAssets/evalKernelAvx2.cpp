@@ -0,0 +1,100 @@
+/**
+ * @defgroup   EVAL_KERNEL
+ *
+ * @brief      AVX2 path of the evaluation and playout kernels. This is the
+ * only file built with -mavx2, it is only called after the runtime CPU check
+ * passed.
+ *
+ * @date       2021
+ */
+
+#include "evalKernel.hpp"
+#include "playoutKernel.hpp"
+
+#if defined(EVAL_KERNEL_AVX2) && defined(__AVX2__)
+
+#include "evalKernelImpl.hpp"
+#include "playoutKernelImpl.hpp"
+#include <immintrin.h>
+
+namespace
+{
+    struct Avx2Vec {
+        typedef __m256i T;
+        enum { lanes = 32 };
+        static T load(const uint8_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+        static T eq(T a, uint8_t c) { return _mm256_cmpeq_epi8(a, _mm256_set1_epi8((char)c)); }
+        static T and_(T a, T b) { return _mm256_and_si256(a, b); }
+        static T andnot(T a, T b) { return _mm256_andnot_si256(a, b); }
+        static uint32_t count(T a) { return __builtin_popcount((uint32_t)_mm256_movemask_epi8(a)); }
+        static bool any(T a) { return !_mm256_testz_si256(a, a); }
+    };
+
+    // Four 64 bit boards per register for the batch kernel
+    struct Avx2x64 {
+        typedef __m256i T;
+        enum { lanes = 4 };
+        static T load(const uint64_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+        static void store(uint64_t* p, T a) { _mm256_storeu_si256((__m256i*)p, a); }
+        static T zero() { return _mm256_setzero_si256(); }
+        static T set1(uint64_t v) { return _mm256_set1_epi64x((long long)v); }
+        static T shr(T a, int n) { return _mm256_srl_epi64(a, _mm_cvtsi32_si128(n)); }
+        static T shl(T a, int n) { return _mm256_sll_epi64(a, _mm_cvtsi32_si128(n)); }
+        static T and_(T a, T b) { return _mm256_and_si256(a, b); }
+        static T or_(T a, T b) { return _mm256_or_si256(a, b); }
+        static T andnot(T a, T b) { return _mm256_andnot_si256(a, b); }
+        static T add(T a, T b) { return _mm256_add_epi64(a, b); }
+        static T popcount(T a) {
+            // Nibble lookup with vpshufb, then sum the bytes of each lane
+            const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+            const __m256i low = _mm256_set1_epi8(0x0f);
+            __m256i lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(a, low));
+            __m256i hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(a, 4), low));
+            return _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256());
+        }
+        static bool any(T a) { return !_mm256_testz_si256(a, a); }
+        static T xor_(T a, T b) { return _mm256_xor_si256(a, b); }
+        static T shlv(T a, T n) { return _mm256_sllv_epi64(a, n); }
+        static T mul32(T a, T b) { return _mm256_mul_epu32(a, b); }
+        static T eq(T a, T b) { return _mm256_cmpeq_epi64(a, b); }
+        static T nonzero(T a) { return _mm256_xor_si256(eq(a, zero()), _mm256_set1_epi64x(-1)); }
+    };
+}
+
+void EvalKernel::detail::countStreaksAvx2(const uint8_t* cells, const Layout& layout, Counts& counts)
+{
+    countStreaksImpl<Avx2Vec>(cells, layout, counts);
+}
+
+void EvalKernel::detail::countBatchAvx2(const uint64_t* red, const uint64_t* yellow,
+                                        const BitTables& tables, BatchCounts& counts)
+{
+    countBatchImpl<Avx2x64>(red, yellow, tables, counts);
+}
+
+void PlayoutKernel::detail::advanceAvx2(Lanes& lanes, const Tables& tables)
+{
+    advanceImpl<Avx2x64>(lanes, tables);
+}
+
+#else
+
+void EvalKernel::detail::countStreaksAvx2(const uint8_t* cells, const Layout& layout, Counts& counts)
+{
+    // Not compiled for AVX2, isaSupported() never selects this path
+    countStreaksSse2(cells, layout, counts);
+}
+
+void EvalKernel::detail::countBatchAvx2(const uint64_t* red, const uint64_t* yellow,
+                                        const BitTables& tables, BatchCounts& counts)
+{
+    countBatchSse2(red, yellow, tables, counts);
+}
+
+void PlayoutKernel::detail::advanceAvx2(Lanes& lanes, const Tables& tables)
+{
+    advanceSse2(lanes, tables);
+}
+
+#endif
@@ -0,0 +1,163 @@
+/**
+ * @defgroup   EVAL_KERNEL_IMPL
+ *
+ * @brief      Width independent body of the evaluation kernel. This header is
+ * included by every translation unit that instantiates the kernel for an
+ * instruction set, so everything in here has internal linkage and must not
+ * call into the standard library (the AVX2 unit is built with -mavx2).
+ *
+ * For one color x, a window of direction d starting at cell p is
+ *     start(p)   = !x[p-d] & x[p]
+ *     run_S(p)   = start(p) & x[p+d] & ... & x[p+(S-1)d]
+ *     exact_S(p) = run_S(p) & !x[p+Sd]
+ *
+ * checkHorzStreak/checkVertStreak count exact_S. checkDiagStreak walks the
+ * '\' diagonal away from every cell of the color, which adds up to
+ *     2 * #run_{S+1} + sum over exact_S runs of (pieces on that diagonal - S)
+ * The second term is counted by and-ing exact_S with every other cell of the
+ * same diagonal.
+ *
+ * @date       2021
+ */
+#ifndef __EVAL_KERNEL_IMPL__
+#define __EVAL_KERNEL_IMPL__
+
+#include "evalKernel.hpp"
+
+#include <cstdint>
+
+namespace
+{
+    template <class V>
+    void countStreaksImpl(const uint8_t* cells, const EvalKernel::detail::Layout& layout,
+                          EvalKernel::detail::Counts& counts)
+    {
+        typedef typename V::T T;
+        const int K = layout.streak;
+        const int stride = layout.stride;
+        const int diagReach = (layout.width < layout.height ? layout.width : layout.height) - 1;
+        const uint8_t colors[2] = {(uint8_t)SlotStatus::Red, (uint8_t)SlotStatus::Yellow};
+
+        for (int c = 0; c < 2; c++) {
+            counts.wins[c] = false;
+            for (int s = 0; s <= EvalKernel::kMaxStreak; s++) counts.streaks[c][s] = 0;
+        }
+
+        const int regionEnd = layout.regionStart + layout.regionLen;
+        for (int base = layout.regionStart; base < regionEnd; base += V::lanes) {
+            const uint8_t* p = cells + base;
+            for (int c = 0; c < 2; c++) {
+                const uint8_t color = colors[c];
+                uint32_t* streaks = counts.streaks[c];
+                bool won = false;
+
+                // Horizontal and vertical streaks of exactly S pieces
+                const int straight[2] = {1, stride};
+                for (int dir = 0; dir < 2; dir++) {
+                    const int d = straight[dir];
+                    T run = V::andnot(V::eq(V::load(p - d), color), V::eq(V::load(p), color));
+                    for (int S = 2; S <= K; S++) {
+                        run = V::and_(run, V::eq(V::load(p + (S - 1) * d), color));
+                        streaks[S] += V::count(V::andnot(V::eq(V::load(p + S * d), color), run));
+                    }
+                    won |= V::any(run);
+                }
+
+                // '\' diagonal, see the header comment for the counting rule
+                const int d = stride + 1;
+                T run = V::andnot(V::eq(V::load(p - d), color), V::eq(V::load(p), color));
+                for (int S = 2; S <= K; S++) {
+                    run = V::and_(run, V::eq(V::load(p + (S - 1) * d), color));
+                    T next = V::eq(V::load(p + S * d), color);
+                    T exact = V::andnot(next, run);
+                    uint32_t n = 2 * V::count(V::and_(run, next));
+                    if (V::any(exact)) {
+                        for (int k = -diagReach; k <= -2; k++)
+                            n += V::count(V::and_(exact, V::eq(V::load(p + k * d), color)));
+                        for (int k = S + 1; k <= diagReach; k++)
+                            n += V::count(V::and_(exact, V::eq(V::load(p + k * d), color)));
+                    }
+                    streaks[S] += n;
+                }
+                won |= V::any(run);
+
+                // '/' diagonal only matters for finding a winner
+                if (!won) {
+                    const int a = stride - 1;
+                    T line = V::eq(V::load(p), color);
+                    for (int k = 1; k < K; k++) line = V::and_(line, V::eq(V::load(p + k * a), color));
+                    won = V::any(line);
+                }
+                counts.wins[c] |= won;
+            }
+        }
+    }
+
+    /*
+     * Batch version of the kernel above. Each lane of V holds the 64 bit
+     * board of one position and the windows are formed with uniform shifts
+     * plus on-board masks, so every instruction works on V::lanes boards.
+     */
+    template <class V>
+    void countBatchImpl(const uint64_t* red, const uint64_t* yellow,
+                        const EvalKernel::detail::BitTables& tables,
+                        EvalKernel::detail::BatchCounts& counts)
+    {
+        typedef typename V::T T;
+        const int K = tables.streak;
+        const int mid = EvalKernel::detail::kMaxReach;
+
+        for (int lane0 = 0; lane0 < EvalKernel::detail::kBatchLanes; lane0 += V::lanes) {
+            for (int c = 0; c < 2; c++) {
+                const T x = V::load((c == 0 ? red : yellow) + lane0);
+                // Slot p + k*step of direction dir, moved to bit p
+                auto at = [&](int dir, int k) {
+                    int shift = tables.shift[dir][mid + k];
+                    T moved = shift >= 0 ? V::shr(x, shift) : V::shl(x, -shift);
+                    return V::and_(moved, V::set1(tables.valid[dir][mid + k]));
+                };
+                T streaks[EvalKernel::kMaxStreak + 1];
+                T won = V::zero();
+
+                // Horizontal and vertical streaks of exactly S pieces
+                for (int dir = 0; dir < 2; dir++) {
+                    T run = V::andnot(at(dir, -1), x);
+                    for (int S = 2; S <= K; S++) {
+                        run = V::and_(run, at(dir, S - 1));
+                        T exact = V::popcount(V::andnot(at(dir, S), run));
+                        streaks[S] = dir == 0 ? exact : V::add(streaks[S], exact);
+                    }
+                    won = V::or_(won, run);
+                }
+
+                // '\' diagonal
+                T run = V::andnot(at(2, -1), x);
+                for (int S = 2; S <= K; S++) {
+                    run = V::and_(run, at(2, S - 1));
+                    T next = at(2, S);
+                    T exact = V::andnot(next, run);
+                    T longer = V::popcount(V::and_(run, next));
+                    T n = V::add(longer, longer);
+                    if (V::any(exact)) {
+                        for (int k = -tables.diagReach; k <= -2; k++)
+                            n = V::add(n, V::popcount(V::and_(exact, at(2, k))));
+                        for (int k = S + 1; k <= tables.diagReach; k++)
+                            n = V::add(n, V::popcount(V::and_(exact, at(2, k))));
+                    }
+                    streaks[S] = V::add(streaks[S], n);
+                }
+                won = V::or_(won, run);
+
+                // '/' diagonal only matters for finding a winner
+                T line = x;
+                for (int k = 1; k < K; k++) line = V::and_(line, at(3, k));
+                won = V::or_(won, line);
+
+                for (int S = 2; S <= K; S++) V::store(&counts.streaks[c][S][lane0], streaks[S]);
+                V::store(&counts.wins[c][lane0], won);
+            }
+        }
+    }
+}
+
+#endif
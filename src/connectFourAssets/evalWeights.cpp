@@ -0,0 +1,79 @@
+/**
+ * @defgroup   EVAL_WEIGHTS
+ *
+ * @brief      Weights of the streak heuristic.
+ *
+ * @date       2021
+ */
+
+#include "evalWeights.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    constexpr EvalWeights::detail::StreakWeights defaults()
+    {
+        EvalWeights::detail::StreakWeights table = {};
+        for (int length = 0; length <= EvalWeights::kMaxLength; length++)
+            table.weights[length] = EvalWeights::defaultStreak(length);
+        return table;
+    }
+}
+
+// Constant initialized, so it holds the defaults before any constructor runs
+EvalWeights::detail::StreakWeights EvalWeights::detail::streak = defaults();
+
+void EvalWeights::setStreak(int length, int32_t weight)
+{
+    if (length >= 0 && length <= kMaxLength) detail::streak.weights[length] = weight;
+}
+
+void EvalWeights::reset()
+{
+    detail::streak = defaults();
+}
+
+bool EvalWeights::load(const std::string& path)
+{
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Could not open weights " << path << std::endl;
+        return false;
+    }
+    // Applied only once the whole file has been read
+    detail::StreakWeights loaded = detail::streak;
+    std::string line;
+    for (int number = 1; std::getline(in, line); number++) {
+        std::istringstream words(line.substr(0, line.find('#')));
+        std::string name;
+        if (!(words >> name)) continue;
+        int length;
+        long long weight;
+        std::string rest;
+        if (name != "streak" || !(words >> length >> weight) || (words >> rest) ||
+            length < 0 || length > kMaxLength || weight < INT32_MIN || weight > INT32_MAX) {
+            std::cerr << "Weights " << path << ":" << number << ": expected streak <length> <weight>" << std::endl;
+            return false;
+        }
+        loaded.weights[length] = (int32_t)weight;
+    }
+    detail::streak = loaded;
+    return true;
+}
+
+bool EvalWeights::save(const std::string& path, int winningStreakSize, const std::string& comment)
+{
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Could not create weights " << path << std::endl;
+        return false;
+    }
+    if (!comment.empty()) out << "# " << comment << "\n";
+    for (int length = 2; length <= winningStreakSize && length <= kMaxLength; length++)
+        out << "streak " << length << " " << detail::streak.weights[length] << "\n";
+    out.flush();
+    return (bool)out;
+}
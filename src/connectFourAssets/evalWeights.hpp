@@ -0,0 +1,70 @@
+/**
+ * @defgroup   EVAL_WEIGHTS
+ *
+ * @brief      Weights of the streak heuristic. Every streak of length n adds
+ * streak(n) to the score of its player and takes it from the other one. The
+ * defaults are the cube of the length the heuristic started out with; a
+ * weights file given with --weights replaces them, and --tune fits a file to
+ * self-play positions.
+ *
+ * A weights file is text with one "streak <length> <weight>" line per length
+ * and '#' starting a comment. Lengths it leaves out keep their defaults.
+ *
+ * Like EvalConfig, the weights are set once from the command line before any
+ * solver is built and only read afterwards. The scalar evaluation, the
+ * vector kernels and the CUDA solver all take them from this table.
+ *
+ * @date       2021
+ */
+#ifndef __EVAL_WEIGHTS__
+#define __EVAL_WEIGHTS__
+
+#include <cstdint>
+#include <string>
+
+namespace EvalWeights
+{
+    // Longest streak a weight is kept for, a board streak length is a uint8
+    constexpr int kMaxLength = 255;
+
+    constexpr int32_t defaultStreak(int length) { return length * length * length; }
+
+    namespace detail
+    {
+        struct StreakWeights {
+            int32_t weights[kMaxLength + 1];
+        };
+
+        // Read inline by every evaluation
+        extern StreakWeights streak;
+    }
+
+    /**
+     * @brief      The weights indexed by streak length, for loops that read
+     * several per evaluation.
+     */
+    inline const int32_t* streakTable() { return detail::streak.weights; }
+
+    inline int32_t streak(int length) { return streakTable()[length]; }
+    void setStreak(int length, int32_t weight);
+
+    // Back to the defaults
+    void reset();
+
+    /**
+     * @brief      Reads a weights file.
+     *
+     * @return     False if the file cannot be read or has a malformed line,
+     * the weights are left as they were then
+     */
+    bool load(const std::string& path);
+
+    /**
+     * @brief      Writes the weights of the lengths 2 to winningStreakSize.
+     *
+     * @param[in]  comment  Written as a comment line above the weights
+     */
+    bool save(const std::string& path, int winningStreakSize, const std::string& comment);
+}
+
+#endif
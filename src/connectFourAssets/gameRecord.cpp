@@ -0,0 +1,260 @@
+#include "gameRecord.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((uint8_t)value);
+    }
+
+    // False when the varint runs past the end
+    bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; p < end && shift < 64; shift += 7) {
+            uint8_t byte = *p++;
+            value |= (uint64_t)(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    uint64_t zigzag(int value) { return ((uint64_t)(int64_t)value << 1) ^ (uint64_t)((int64_t)value >> 63); }
+    int unzigzag(uint64_t value) { return (int)(int64_t)((value >> 1) ^ (0 - (value & 1))); }
+
+    int moveBits(int width) { return width > 16 ? 8 : 4; }
+}
+
+const char* GameRecord::resultName(Result result)
+{
+    switch (result) {
+        case Result::FirstWins: return "1-0";
+        case Result::SecondWins: return "0-1";
+        case Result::Draw: return "draw";
+        default: return "*";
+    }
+}
+
+GameRecordWriter::~GameRecordWriter()
+{
+    close();
+}
+
+GameRecordWriter& GameRecordWriter::shared()
+{
+    static GameRecordWriter writer;
+    return writer;
+}
+
+bool GameRecordWriter::open(const std::string& path, int width, int height, int winningStreakSize)
+{
+    close();
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Could not create game records " << path << std::endl;
+        return false;
+    }
+    GameRecordHeader header = {};
+    memcpy(header.magic, "C4GR", 4);
+    header.version = kVersion;
+    header.width = width;
+    header.height = height;
+    header.winningStreakSize = winningStreakSize;
+    if (fwrite(&header, sizeof(header), 1, file) != 1) {
+        std::cerr << "Could not write game records " << path << std::endl;
+        fclose(file);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _file = file;
+    _width = width;
+    _numSlots = width * height;
+    _games = 0;
+    _buffer.reserve(kFlushBytes + 1024);
+    return true;
+}
+
+void GameRecordWriter::close()
+{
+    this->flush();
+    std::lock_guard<std::mutex> fileLock(_fileMutex);
+    if (!_file) return;
+    fclose(_file);
+    _file = nullptr;
+}
+
+void GameRecordWriter::encode(const GameRecord& game, int width, std::vector<uint8_t>& out)
+{
+    thread_local std::vector<uint8_t> body;
+    body.clear();
+    body.push_back((uint8_t)game.result | (game.first == Player::Yellow ? 4 : 0));
+    putVarint(body, game.moves.size());
+    const int bits = moveBits(width);
+    size_t packed = body.size();
+    body.resize(packed + (game.moves.size() * bits + 7) / 8, 0);
+    for (size_t i = 0; i < game.moves.size(); i++) {
+        size_t bit = i * bits;
+        body[packed + bit / 8] |= (uint8_t)(game.moves[i].column << (bit % 8));
+    }
+    for (const GameMove& move : game.moves) {
+        putVarint(body, move.micros);
+        putVarint(body, move.nodes);
+        body.push_back((uint8_t)std::min(std::max(move.depth, 0), 255));
+        putVarint(body, zigzag(move.score));
+    }
+    putVarint(out, body.size());
+    out.insert(out.end(), body.begin(), body.end());
+}
+
+void GameRecordWriter::write(const GameRecord& game)
+{
+    // The reader takes no game with more moves than the board has slots
+    if (game.moves.size() > (size_t)_numSlots) {
+        std::cerr << "Game records take at most " << _numSlots << " moves per game" << std::endl;
+        return;
+    }
+    thread_local std::vector<uint8_t> encoded;
+    encoded.clear();
+    encode(game, _width, encoded);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_file) return;
+    _buffer.insert(_buffer.end(), encoded.begin(), encoded.end());
+    ++_games;
+    if (_buffer.size() < kFlushBytes) return;
+    // Taking the file before letting go of the buffer keeps the games in
+    // order, other threads fill the next buffer while this one is written
+    thread_local std::vector<uint8_t> full;
+    full.clear();
+    full.swap(_buffer);
+    _buffer.reserve(kFlushBytes + 1024);
+    std::lock_guard<std::mutex> fileLock(_fileMutex);
+    lock.unlock();
+    this->writeOut(full);
+}
+
+void GameRecordWriter::flush()
+{
+    std::vector<uint8_t> pending;
+    std::unique_lock<std::mutex> lock(_mutex);
+    pending.swap(_buffer);
+    std::lock_guard<std::mutex> fileLock(_fileMutex);
+    lock.unlock();
+    this->writeOut(pending);
+    if (_file) fflush(_file);
+}
+
+void GameRecordWriter::writeOut(const std::vector<uint8_t>& bytes)
+{
+    if (!_file || bytes.empty()) return;
+    if (fwrite(bytes.data(), 1, bytes.size(), _file) != bytes.size())
+        std::cerr << "Could not write game records" << std::endl;
+}
+
+uint64_t GameRecordWriter::games()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _games;
+}
+
+GameRecordReader::~GameRecordReader()
+{
+    close();
+}
+
+bool GameRecordReader::open(const std::string& path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Could not open game records " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(GameRecordHeader)) {
+        std::cerr << "Game records " << path << " are too small" << std::endl;
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Could not map game records " << path << std::endl;
+        return false;
+    }
+    const GameRecordHeader* header = (const GameRecordHeader*)mapping;
+    if (memcmp(header->magic, "C4GR", 4) || header->version != GameRecordWriter::kVersion) {
+        std::cerr << "Game records " << path << " are not valid game records" << std::endl;
+        munmap(mapping, st.st_size);
+        return false;
+    }
+    _mapping = mapping;
+    _mappingSize = st.st_size;
+    _header = header;
+
+    // Games are found from their lengths, the last one may be torn
+    const uint8_t* base = (const uint8_t*)mapping;
+    const uint8_t* end = base + _mappingSize;
+    const uint8_t* p = base + sizeof(GameRecordHeader);
+    uint64_t length;
+    while (p < end && getVarint(p, end, length) && length <= (uint64_t)(end - p)) {
+        _games.push_back({(size_t)(p - base), (size_t)length});
+        p += length;
+    }
+    return true;
+}
+
+void GameRecordReader::close()
+{
+    if (_mapping) munmap(_mapping, _mappingSize);
+    _mapping = nullptr;
+    _mappingSize = 0;
+    _header = nullptr;
+    _games.clear();
+}
+
+bool GameRecordReader::read(size_t index, GameRecord& game) const
+{
+    if (index >= _games.size()) return false;
+    const uint8_t* p = (const uint8_t*)_mapping + _games[index].offset;
+    const uint8_t* end = p + _games[index].length;
+    uint64_t plies;
+    // Every game has at least its flags byte
+    if (p >= end) return false;
+    uint8_t flags = *p++;
+    if (!getVarint(p, end, plies) || plies > (uint64_t)_header->width * _header->height) return false;
+    game.result = (GameRecord::Result)(flags & 3);
+    game.first = (flags & 4) ? Player::Yellow : Player::Red;
+    game.moves.assign(plies, GameMove());
+
+    const int bits = moveBits(_header->width);
+    const size_t packed = (plies * bits + 7) / 8;
+    if (packed > (size_t)(end - p)) return false;
+    for (size_t i = 0; i < plies; i++) {
+        size_t bit = i * bits;
+        game.moves[i].column = (p[bit / 8] >> (bit % 8)) & ((1 << bits) - 1);
+        if (game.moves[i].column >= _header->width) return false;
+    }
+    p += packed;
+    for (GameMove& move : game.moves) {
+        uint64_t micros, nodes, score;
+        if (!getVarint(p, end, micros) || !getVarint(p, end, nodes) || p >= end) return false;
+        move.micros = (uint32_t)micros;
+        move.nodes = nodes;
+        move.depth = *p++;
+        if (!getVarint(p, end, score)) return false;
+        move.score = unzigzag(score);
+    }
+    return p == end;
+}
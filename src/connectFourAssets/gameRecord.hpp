@@ -0,0 +1,168 @@
+/**
+ * @defgroup   GAME_RECORD
+ *
+ * @brief      Compact binary records of played games, written by the
+ * tournaments (--record) and read back with --replay.
+ *
+ * A file is a GameRecordHeader with the geometry followed by the games. A
+ * game is its body length as a varint and the body:
+ *
+ *     flags                    1 byte, result in bits 0-1, bit 2 set when
+ *                              Yellow moved first
+ *     plies                    varint, at most width * height
+ *     columns                  4 bits per move (8 when width > 16), packed
+ *                              low nibble first
+ *     per move                 microseconds and nodes as varints, depth as
+ *                              1 byte, score as a zigzag varint
+ *
+ * A move takes about 8 bytes, a whole 7x6 game less than 400. The writer
+ * encodes a game on the calling thread and copies it to a shared buffer that
+ * goes to the file every kFlushBytes, so a game loop pays for a few hundred
+ * bytes of copying per game and any number of threads can write. The reader
+ * maps the file and indexes the games by their lengths; a game torn by a
+ * crash at the end of the file is skipped.
+ *
+ * @date       2021
+ */
+#ifndef __GAME_RECORD__
+#define __GAME_RECORD__
+
+#include "player.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct GameRecordHeader {
+    char magic[4];          // "C4GR"
+    uint32_t version;
+    uint8_t width;
+    uint8_t height;
+    uint8_t winningStreakSize;
+    uint8_t reserved[5];
+};
+
+struct GameMove {
+    // Column (0 based) of the move
+    int column = -1;
+    // Search depth and score of the solver, 0 where the solver keeps none
+    int depth = 0;
+    int score = 0;
+    uint32_t micros = 0;
+    uint64_t nodes = 0;
+};
+
+struct GameRecord {
+    enum class Result : uint8_t {Unfinished = 0, FirstWins, SecondWins, Draw};
+
+    Player first = Player::Red;
+    Result result = Result::Unfinished;
+    std::vector<GameMove> moves;
+
+    static const char* resultName(Result result);
+};
+
+class GameRecordWriter
+{
+    public:
+        static constexpr uint32_t kVersion = 1;
+        // Buffered bytes that make the writer go to the file
+        static constexpr size_t kFlushBytes = 1 << 16;
+
+        GameRecordWriter() = default;
+        ~GameRecordWriter();
+        GameRecordWriter(const GameRecordWriter&) = delete;
+        GameRecordWriter& operator=(const GameRecordWriter&) = delete;
+
+        /**
+         * @brief      The writer the tournaments record their games with.
+         */
+        static GameRecordWriter& shared();
+
+        /**
+         * @brief      Creates the file, replacing an existing one.
+         *
+         * @return     False if the file cannot be written
+         */
+        bool open(const std::string& path, int width, int height, int winningStreakSize);
+
+        // Writes the buffered games and closes the file
+        void close();
+
+        bool isOpen() const { return _file != nullptr; }
+
+        /**
+         * @brief      Appends a game, safe to call from several threads. Games
+         * with more moves than the board has slots are not written.
+         */
+        void write(const GameRecord& game);
+
+        // Writes the buffered games to the file
+        void flush();
+
+        uint64_t games();
+
+        /**
+         * @brief      Appends the length prefixed encoding of a game.
+         */
+        static void encode(const GameRecord& game, int width, std::vector<uint8_t>& out);
+
+    private:
+        std::mutex _mutex;
+        std::vector<uint8_t> _buffer;
+        // Held while a full buffer is written, the next one fills meanwhile
+        std::mutex _fileMutex;
+        FILE* _file = nullptr;
+        int _width = 0;
+        int _numSlots = 0;
+        uint64_t _games = 0;
+
+        void writeOut(const std::vector<uint8_t>& bytes);
+};
+
+class GameRecordReader
+{
+    public:
+        GameRecordReader() = default;
+        ~GameRecordReader();
+        GameRecordReader(const GameRecordReader&) = delete;
+        GameRecordReader& operator=(const GameRecordReader&) = delete;
+
+        /**
+         * @brief      Maps a record file and indexes its games.
+         *
+         * @return     False if it is not a record file, the reader stays
+         * closed then
+         */
+        bool open(const std::string& path);
+
+        void close();
+
+        const GameRecordHeader& header() const { return *_header; }
+
+        // Number of complete games in the file
+        size_t size() const { return _games.size(); }
+
+        /**
+         * @brief      Decodes a game.
+         *
+         * @return     False if the game is corrupt
+         */
+        bool read(size_t index, GameRecord& game) const;
+
+    private:
+        struct Span {
+            size_t offset;
+            size_t length;
+        };
+
+        void* _mapping = nullptr;
+        size_t _mappingSize = 0;
+        const GameRecordHeader* _header = nullptr;
+        std::vector<Span> _games;
+};
+
+#endif
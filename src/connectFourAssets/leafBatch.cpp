@@ -0,0 +1,177 @@
+/**
+ * @defgroup   LEAF_BATCH
+ *
+ * @brief      Batched scoring of the last plies of a minimax search.
+ *
+ * @date       2021
+ */
+
+#include "leafBatch.hpp"
+#include "evalConfig.hpp"
+#include "zobrist.hpp"
+
+#include <algorithm>
+#include <climits>
+
+LeafBatch::LeafBatch(int width, int height, int winningStreakSize)
+    : _width(width), _height(height), _streak(winningStreakSize),
+      _evaluator(width, height, winningStreakSize),
+      _patternEvaluator(width, height, winningStreakSize),
+      _usePattern(PatternEvaluator::supportsGeometry(width, height, winningStreakSize))
+{
+    int numSlots = width * height;
+    _fullMask = numSlots == 64 ? ~uint64_t(0) : (uint64_t(1) << numSlots) - 1;
+    _zobrist.resize(2 * numSlots);
+    Zobrist::fillTable(_zobrist.data(), numSlots);
+    _mirrorZobrist.resize(2 * numSlots);
+    Zobrist::fillMirrorTable(_mirrorZobrist.data(), width, height);
+
+    // Streaks are walked towards higher slots: right, down, down-right and
+    // down-left
+    const int rowStep[4] = {0, 1, 1, 1};
+    const int columnStep[4] = {1, 0, 1, -1};
+    for (int dir = 0; dir < 4; dir++) {
+        _step[dir] = rowStep[dir] * width + columnStep[dir];
+        _streakStart[dir] = 0;
+        for (int r = 0; r < height; r++) {
+            for (int c = 0; c < width; c++) {
+                int lastRow = r + (winningStreakSize - 1) * rowStep[dir];
+                int lastColumn = c + (winningStreakSize - 1) * columnStep[dir];
+                if (lastRow < height && lastColumn >= 0 && lastColumn < width)
+                    _streakStart[dir] |= uint64_t(1) << (r * width + c);
+            }
+        }
+    }
+}
+
+bool LeafBatch::supportsGeometry(int width, int height, int winningStreakSize)
+{
+    return BatchEvaluator::supportsGeometry(width, height, winningStreakSize);
+}
+
+int LeafBatch::minimax(const SlotStatus* board, uint64_t key, uint64_t mirrorKey, int depth,
+                       Player player, bool maximizer, uint64_t& nodesTraversed)
+{
+    _subtreeEnd.clear();
+    _leafNodes.clear();
+    _leafPositions.clear();
+    _leafKeys.clear();
+    _leafMirrorKeys.clear();
+    _wonLeaves.clear();
+
+    Position root = PositionHelpers::fromBoard(board, _width * _height, player);
+    _playerColor = SlotStatusHelpers::getSlotFromPlayer(player);
+    SlotStatus color = SlotStatusHelpers::getSlotFromPlayer(
+        maximizer ? player : PlayerHelpers::OppositePlayer(player));
+    gather(root, key, mirrorKey, depth, color);
+
+    _scores.resize(_subtreeEnd.size());
+    for (const auto& won : _wonLeaves) _scores[won.first] = won.second;
+    evaluateLeaves();
+    return reduce(0, maximizer, nodesTraversed);
+}
+
+void LeafBatch::gather(const Position& position, uint64_t key, uint64_t mirrorKey, int depth,
+                       SlotStatus color)
+{
+    int node = _subtreeEnd.size();
+    _subtreeEnd.push_back(node + 1);
+
+    if (depth == 0 || (position.red | position.yellow) == _fullMask) {
+        _leafNodes.push_back(node);
+        _leafPositions.push_back(position);
+        _leafKeys.push_back(key);
+        _leafMirrorKeys.push_back(mirrorKey);
+        return;
+    }
+
+    SlotStatus next = color == SlotStatus::Red ? SlotStatus::Yellow : SlotStatus::Red;
+    uint64_t moves = PositionHelpers::legalMoves(position, _width, _height);
+    // Highest slot first, the order the solvers walk the board in
+    while (moves) {
+        int i = 63 - __builtin_clzll(moves);
+        moves &= ~(uint64_t(1) << i);
+        Position child = position;
+        PositionHelpers::play(child, i, color);
+        // Children on the horizon are evaluated anyway and the evaluation
+        // finds their wins, only the interior ones need the terminal check
+        uint64_t pieces = color == SlotStatus::Red ? child.red : child.yellow;
+        if (depth > 1 && isWin(pieces)) {
+            // A won child is a leaf whose score needs no evaluation
+            int leaf = _subtreeEnd.size();
+            _subtreeEnd.push_back(leaf + 1);
+            _wonLeaves.emplace_back(leaf, color == _playerColor ? INT_MAX : INT_MIN);
+        }
+        else {
+            int entry = 2 * i + (color == SlotStatus::Yellow);
+            gather(child, key ^ _zobrist[entry], mirrorKey ^ _mirrorZobrist[entry], depth - 1, next);
+        }
+    }
+    _subtreeEnd[node] = _subtreeEnd.size();
+}
+
+bool LeafBatch::isWin(uint64_t pieces) const
+{
+    // No early exits, the loop counts are the same for every call
+    uint64_t won = 0;
+    for (int dir = 0; dir < 4; dir++) {
+        uint64_t run = pieces & _streakStart[dir];
+        for (int k = 1; k < _streak; k++) run &= pieces >> (k * _step[dir]);
+        won |= run;
+    }
+    return won != 0;
+}
+
+void LeafBatch::evaluateLeaves()
+{
+    const size_t numLeaves = _leafPositions.size();
+    _leafScores.resize(numLeaves);
+    if (!_evalCache) {
+        evaluate(_leafPositions.data(), numLeaves, _leafScores.data());
+    }
+    else {
+        // Only the leaves that miss the cache go to the evaluator. Mirror
+        // images share an entry when the heuristic allows it.
+        const bool canonical = EvalConfig::mirrorSymmetric(_width, _height, _streak);
+        _missLeaves.clear();
+        _missKeys.clear();
+        _missPositions.clear();
+        for (size_t leaf = 0; leaf < numLeaves; leaf++) {
+            uint64_t key = canonical ? Zobrist::canonicalKey(_leafKeys[leaf], _leafMirrorKeys[leaf])
+                                     : _leafKeys[leaf];
+            key = Zobrist::scoredKey(key, _leafPositions[leaf].player);
+            if (_evalCache->probe(key, _leafScores[leaf])) continue;
+            _missLeaves.push_back(leaf);
+            _missKeys.push_back(key);
+            _missPositions.push_back(_leafPositions[leaf]);
+        }
+        _missScores.resize(_missPositions.size());
+        evaluate(_missPositions.data(), _missPositions.size(), _missScores.data());
+        for (size_t miss = 0; miss < _missLeaves.size(); miss++) {
+            _leafScores[_missLeaves[miss]] = _missScores[miss];
+            _evalCache->store(_missKeys[miss], _missScores[miss]);
+        }
+    }
+    for (size_t leaf = 0; leaf < numLeaves; leaf++) _scores[_leafNodes[leaf]] = _leafScores[leaf];
+}
+
+void LeafBatch::evaluate(const Position* positions, size_t n, int* scores_out)
+{
+    if (_usePattern && EvalConfig::heuristic() == EvalConfig::Heuristic::Pattern)
+        _patternEvaluator.evaluateBatch(positions, n, scores_out);
+    else
+        _evaluator.evaluateBatch(positions, n, scores_out);
+}
+
+int LeafBatch::reduce(int node, bool maximizer, uint64_t& nodesTraversed)
+{
+    if (_subtreeEnd[node] == node + 1) return _scores[node];
+
+    int bestScore = maximizer ? INT_MIN : INT_MAX;
+    for (int child = node + 1; child < _subtreeEnd[node]; child = _subtreeEnd[child]) {
+        int score = reduce(child, !maximizer, nodesTraversed);
+        bestScore = maximizer ? std::max(score, bestScore) : std::min(score, bestScore);
+        ++nodesTraversed;
+    }
+    return bestScore;
+}
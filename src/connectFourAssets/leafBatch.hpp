@@ -0,0 +1,111 @@
+/**
+ * @defgroup   LEAF_BATCH
+ *
+ * @brief      Scores the last plies of a minimax search in one call to the
+ * batch evaluator. The subtree below a node with at most kMaxDepth plies left
+ * is generated as bitboards, its leaves (horizon or full board) are evaluated
+ * as one block, and the minimax values are then reduced with the same rules
+ * the solvers use, so the result is identical to searching the subtree node by
+ * node. Wins above the horizon are found while generating the subtree, the
+ * ones on the horizon by the evaluation itself.
+ *
+ * @date       2021
+ */
+#ifndef __LEAF_BATCH__
+#define __LEAF_BATCH__
+
+#include "slotStatus.hpp"
+#include "player.hpp"
+#include "position.hpp"
+#include "evalKernel.hpp"
+#include "patternEval.hpp"
+#include "evalCache.hpp"
+
+#include <utility>
+#include <vector>
+
+class LeafBatch
+{
+    public:
+        // Plies below a node that are generated into one block. Two plies on a
+        // 7 wide board make blocks of up to 57 positions.
+        static constexpr int kMaxDepth = 2;
+
+        LeafBatch(int width, int height, int winningStreakSize);
+
+        /**
+         * @brief      Determines if the geometry can be handled
+         */
+        static bool supportsGeometry(int width, int height, int winningStreakSize);
+
+        /**
+         * @brief      Minimax value of a node with depth <= kMaxDepth plies left.
+         * The node itself must not be won already, the solvers check that with
+         * Board::isWinningMove before handing it over.
+         *
+         * @param[in]  board           The board
+         * @param[in]  key             The Zobrist key of the board (Board::key)
+         * @param[in]  mirrorKey       Its mirror key (Board::mirrorKey)
+         * @param[in]  depth           The remaining depth
+         * @param[in]  player          The player the scores are computed for
+         * @param[in]  maximizer       Whether the node is a maximizing node
+         * @param      nodesTraversed  Incremented once per child searched
+         *
+         * @return     Same value as the solvers' minimax
+         */
+        int minimax(const SlotStatus* board, uint64_t key, uint64_t mirrorKey, int depth,
+                    Player player, bool maximizer, uint64_t& nodesTraversed);
+
+        /**
+         * @brief      Puts an evaluation cache in front of the batch evaluator.
+         * Only the positions that miss are evaluated. Null turns it off.
+         */
+        void setEvalCache(EvalCache* cache) { _evalCache = cache; }
+
+    private:
+        int _width;
+        int _height;
+        int _streak;
+        uint64_t _fullMask;
+        SlotStatus _playerColor;
+        // Slot step of the horizontal, vertical and both diagonal directions,
+        // and the slots a winning streak in that direction can start on
+        int _step[4];
+        uint64_t _streakStart[4];
+        // Zobrist values, laid out like Board's tables
+        std::vector<uint64_t> _zobrist;
+        std::vector<uint64_t> _mirrorZobrist;
+        BatchEvaluator _evaluator;
+        PatternEvaluator _patternEvaluator;
+        bool _usePattern;
+        EvalCache* _evalCache = nullptr;
+
+        // Nodes in preorder, with the index one past each node's subtree.
+        // Nodes without children are leaves, their scores are filled in
+        // before the reduction.
+        std::vector<int> _subtreeEnd;
+        std::vector<int> _scores;
+        // Leaves that need the heuristic, and won leaves with their score
+        std::vector<int> _leafNodes;
+        std::vector<Position> _leafPositions;
+        std::vector<uint64_t> _leafKeys;
+        std::vector<uint64_t> _leafMirrorKeys;
+        std::vector<int> _leafScores;
+        std::vector<std::pair<int, int>> _wonLeaves;
+
+        // Leaves that missed the cache
+        std::vector<int> _missLeaves;
+        std::vector<uint64_t> _missKeys;
+        std::vector<Position> _missPositions;
+        std::vector<int> _missScores;
+
+        void evaluate(const Position* positions, size_t n, int* scores_out);
+        void evaluateLeaves();
+        bool isWin(uint64_t pieces) const;
+
+        void gather(const Position& position, uint64_t key, uint64_t mirrorKey, int depth,
+                    SlotStatus color);
+        int reduce(int node, bool maximizer, uint64_t& nodesTraversed);
+};
+
+#endif
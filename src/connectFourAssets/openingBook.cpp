@@ -0,0 +1,116 @@
+/**
+ * @defgroup   OPENING_BOOK
+ *
+ * @brief      Memory mapped opening book.
+ *
+ * @date       2021
+ */
+
+#include "openingBook.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+OpeningBook::~OpeningBook()
+{
+    close();
+}
+
+OpeningBook& OpeningBook::shared()
+{
+    static OpeningBook book;
+    return book;
+}
+
+bool OpeningBook::open(const std::string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Could not open opening book " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(BookHeader)) {
+        std::cerr << "Opening book " << path << " is too small" << std::endl;
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Could not map opening book " << path << std::endl;
+        return false;
+    }
+
+    const BookHeader* header = (const BookHeader*)mapping;
+    size_t expected = sizeof(BookHeader) + header->count * sizeof(BookEntry);
+    if (memcmp(header->magic, "C4BK", 4) != 0 || header->version != kVersion ||
+        expected != (size_t)st.st_size) {
+        std::cerr << "Opening book " << path << " is not a valid book" << std::endl;
+        munmap(mapping, st.st_size);
+        return false;
+    }
+    // Lookups are binary searches, read ahead would only waste page cache
+    madvise(mapping, st.st_size, MADV_RANDOM);
+
+    _mapping = mapping;
+    _mappingSize = st.st_size;
+    _header = header;
+    _entries = (const BookEntry*)(header + 1);
+    return true;
+}
+
+void OpeningBook::close()
+{
+    if (_mapping) munmap(_mapping, _mappingSize);
+    _mapping = nullptr;
+    _mappingSize = 0;
+    _header = nullptr;
+    _entries = nullptr;
+}
+
+bool OpeningBook::matches(int width, int height, int winningStreakSize) const
+{
+    return isOpen() && _header->width == width && _header->height == height &&
+           _header->winningStreakSize == winningStreakSize;
+}
+
+bool OpeningBook::lookup(uint64_t key, BookEntry& entry) const
+{
+    if (!isOpen()) return false;
+    const BookEntry* end = _entries + _header->count;
+    const BookEntry* it = std::lower_bound(_entries, end, key,
+        [](const BookEntry& e, uint64_t k) { return e.key < k; });
+    if (it == end || it->key != key) return false;
+    entry = *it;
+    return true;
+}
+
+bool OpeningBook::write(const std::string& path, BookHeader header, std::vector<BookEntry>& entries)
+{
+    std::sort(entries.begin(), entries.end(),
+              [](const BookEntry& a, const BookEntry& b) { return a.key < b.key; });
+    memcpy(header.magic, "C4BK", 4);
+    header.version = kVersion;
+    header.count = entries.size();
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Could not create opening book " << path << std::endl;
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              (entries.empty() || fwrite(entries.data(), sizeof(BookEntry), entries.size(), file) == entries.size());
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) std::cerr << "Could not write opening book " << path << std::endl;
+    return ok;
+}
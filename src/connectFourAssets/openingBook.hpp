@@ -0,0 +1,115 @@
+/**
+ * @defgroup   OPENING_BOOK
+ *
+ * @brief      Read-only opening book. The book file is a small header
+ * followed by fixed size entries sorted by key, and is memory mapped so that
+ * opening a book costs the same no matter how large it is. Only the pages a
+ * lookup touches are ever read.
+ *
+ * Entries are keyed by the position key mixed with the player to move
+ * (Zobrist::scoredKey). Books built under a heuristic that scores mirror
+ * images the same (Board::evalMirrorSymmetric) use the canonical key
+ * instead, so a position and its mirror image share one entry; the stored
+ * column then belongs to the canonical orientation and is mirrored back for
+ * positions whose own key is not the canonical one. The header records which
+ * keys the book uses and the heuristic it was built with, lookups follow the
+ * book rather than the heuristic in use.
+ *
+ * @date       2021
+ */
+#ifndef __OPENING_BOOK__
+#define __OPENING_BOOK__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct BookHeader {
+    char magic[4];          // "C4BK"
+    uint32_t version;
+    uint8_t width;
+    uint8_t height;
+    uint8_t winningStreakSize;
+    uint8_t plies;          // deepest ply the book covers
+    uint8_t heuristic;      // EvalConfig::Heuristic the entries were searched with
+    uint8_t canonicalKeys;  // 1 if mirror images share an entry
+    uint8_t reserved[2];
+    uint32_t searchDepth;   // depth the entries were searched to
+    uint64_t count;         // number of entries
+};
+
+struct BookEntry {
+    uint64_t key;
+    int32_t score;          // search score for the player to move
+    uint8_t column;         // 0-indexed, in the orientation of the key
+    uint8_t reserved[3];
+};
+
+class OpeningBook
+{
+    public:
+        static constexpr uint32_t kVersion = 2;
+
+        OpeningBook() = default;
+        ~OpeningBook();
+        OpeningBook(const OpeningBook&) = delete;
+        OpeningBook& operator=(const OpeningBook&) = delete;
+
+        /**
+         * @brief      The book every solver consults before searching.
+         */
+        static OpeningBook& shared();
+
+        /**
+         * @brief      Maps a book file.
+         *
+         * @param[in]  path  The path of the book
+         *
+         * @return     True on success, the book stays closed otherwise
+         */
+        bool open(const std::string& path);
+
+        // Unmaps the book
+        void close();
+
+        bool isOpen() const { return _entries != nullptr; }
+
+        /**
+         * @brief      Determines if the book was built for the geometry.
+         */
+        bool matches(int width, int height, int winningStreakSize) const;
+
+        /**
+         * @brief      Looks up a position.
+         *
+         * @param[in]  key    The scored key of the position
+         * @param      entry  Set to the entry on a hit
+         *
+         * @return     True if the position is in the book
+         */
+        bool lookup(uint64_t key, BookEntry& entry) const;
+
+        const BookHeader& header() const { return *_header; }
+        bool canonicalKeys() const { return _header && _header->canonicalKeys; }
+        size_t size() const { return _header ? _header->count : 0; }
+
+        /**
+         * @brief      Sorts the entries by key and writes a book file.
+         *
+         * @param[in]  path     The path of the book
+         * @param[in]  header   The header, count is filled in
+         * @param      entries  The entries, sorted in place
+         *
+         * @return     True on success
+         */
+        static bool write(const std::string& path, BookHeader header, std::vector<BookEntry>& entries);
+
+    private:
+        void* _mapping = nullptr;
+        size_t _mappingSize = 0;
+        const BookHeader* _header = nullptr;
+        const BookEntry* _entries = nullptr;
+};
+
+#endif
@@ -0,0 +1,114 @@
+/**
+ * @defgroup   PATTERN_EVAL
+ *
+ * @brief      Table driven evaluation keyed by window contents.
+ *
+ * @date       2021
+ */
+
+#include "patternEval.hpp"
+#include "evalConfig.hpp"
+
+#include <climits>
+
+PatternEvaluator::PatternEvaluator(int width, int height, int winningStreakSize)
+    : _streak(winningStreakSize), _numSlots(width * height), _blockSize(0), _table(nullptr)
+{
+    if (!supportsGeometry(width, height, winningStreakSize)) return;
+    _blockSize = PatternTables::pow3(winningStreakSize);
+
+    switch (winningStreakSize) {
+        case 3: _table = PatternTables::kTable3.data(); break;
+        case 4: _table = PatternTables::kTable4.data(); break;
+        case 5: _table = PatternTables::kTable5.data(); break;
+        default:
+            _ownedTable.resize(PatternTables::kBlocks * _blockSize);
+            for (int block = 0; block < PatternTables::kBlocks; block++) {
+                for (int contents = 0; contents < _blockSize; contents++) {
+                    _ownedTable[block * _blockSize + contents] = PatternTables::windowScore(
+                        winningStreakSize, contents, block & 2, block & 1, block & 4);
+                }
+            }
+            _table = _ownedTable.data();
+    }
+
+    // Windows start at their top/left slot and walk right, down, down-right
+    // and down-left
+    const int dr[4] = {0, 1, 1, 1};
+    const int dc[4] = {1, 0, 1, -1};
+    for (int dir = 0; dir < 4; dir++) {
+        for (int r = 0; r < height; r++) {
+            for (int c = 0; c < width; c++) {
+                int lastRow = r + (winningStreakSize - 1) * dr[dir];
+                int lastCol = c + (winningStreakSize - 1) * dc[dir];
+                if (lastRow >= height || lastCol < 0 || lastCol >= width) continue;
+                for (int i = 0; i < winningStreakSize; i++) {
+                    _windowSlots.push_back((r + i * dr[dir]) * width + c + i * dc[dir]);
+                }
+                // Row 0 is the top row, so the bottom row is row 1 from the bottom
+                int anchorParity = (height - r) & 1;
+                _windowBlock.push_back(PatternTables::blockIndex(false, dr[dir] != 0, anchorParity) * _blockSize);
+            }
+        }
+    }
+
+    _allRed = 0;
+    _allYellow = 0;
+    for (int i = 0; i < winningStreakSize; i++) {
+        _allRed += PatternTables::pow3(i);
+        _allYellow += 2 * PatternTables::pow3(i);
+    }
+}
+
+bool PatternEvaluator::supportsGeometry(int width, int height, int winningStreakSize)
+{
+    return width > 0 && height > 0 && winningStreakSize >= 2 && winningStreakSize <= kMaxStreak;
+}
+
+int PatternEvaluator::score(int32_t sum, bool redWins, bool yellowWins, Player player) const
+{
+    // Same winner resolution as Board::DetermineWinner, two winners count as none
+    if (redWins != yellowWins) {
+        bool playerWins = (player == Player::Red) ? redWins : yellowWins;
+        return playerWins ? INT_MAX : INT_MIN;
+    }
+    return player == Player::Red ? sum : -sum;
+}
+
+int PatternEvaluator::evaluate(const SlotStatus* board, Player player) const
+{
+    const int32_t* table = _table + (EvalConfig::rowParity() ? 4 * _blockSize : 0);
+    return evaluateSlots(board, table, player);
+}
+
+int PatternEvaluator::evaluateSlots(const SlotStatus* board, const int32_t* table, Player player) const
+{
+    const int numWindows = _windowBlock.size();
+    const int* slots = _windowSlots.data();
+    int32_t sum = 0;
+    bool redWins = false;
+    bool yellowWins = false;
+    for (int w = 0; w < numWindows; w++, slots += _streak) {
+        int contents = 0;
+        for (int i = _streak - 1; i >= 0; i--) contents = contents * 3 + (int)board[slots[i]];
+        redWins |= contents == _allRed;
+        yellowWins |= contents == _allYellow;
+        sum += table[_windowBlock[w] + contents];
+    }
+    return score(sum, redWins, yellowWins, player);
+}
+
+void PatternEvaluator::evaluateBatch(const Position* positions, size_t n, int* scores_out) const
+{
+    const int32_t* table = _table + (EvalConfig::rowParity() ? 4 * _blockSize : 0);
+    const int numSlots = _numSlots;
+    SlotStatus board[64];
+    for (size_t p = 0; p < n; p++) {
+        // Unpack to one slot per byte, the windows read most slots several times
+        const uint64_t red = positions[p].red;
+        const uint64_t yellow = positions[p].yellow;
+        for (int i = 0; i < numSlots; i++)
+            board[i] = (SlotStatus)(((red >> i) & 1) + 2 * ((yellow >> i) & 1));
+        scores_out[p] = evaluateSlots(board, table, positions[p].player);
+    }
+}
@@ -0,0 +1,144 @@
+/**
+ * @defgroup   PATTERN_EVAL
+ *
+ * @brief      Table driven evaluation. Every window of winningStreakSize
+ * slots in the four directions is read as a base 3 number (empty = 0,
+ * red = 1, yellow = 2) and looked up in a precomputed score table, so a
+ * position is scored with one table load per window.
+ *
+ * A window holding only one color is worth 8^(pieces - 1) to that color and
+ * blocked windows are worth nothing. With row parity enabled, a window one
+ * piece short of a win counts double when its empty slot is on an odd row
+ * (counted from the bottom) for red, or an even row for yellow. That is the
+ * classic zugzwang rule for the first and second player, red moves first in
+ * all the tournament modes.
+ *
+ * The tables for streaks of 3, 4 and 5 are generated at compile time, other
+ * streak lengths build the same table when the evaluator is constructed.
+ *
+ * @date       2021
+ */
+#ifndef __PATTERN_EVAL__
+#define __PATTERN_EVAL__
+
+#include "slotStatus.hpp"
+#include "player.hpp"
+#include "position.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace PatternTables
+{
+    constexpr int pow3(int n) { return n == 0 ? 1 : 3 * pow3(n - 1); }
+
+    // A table holds 8 blocks of 3^K scores, selected by
+    // (parity enabled, sloped window, row parity of the first slot)
+    constexpr int kBlocks = 8;
+
+    constexpr int blockIndex(bool parity, bool sloped, int anchorParity) {
+        return ((parity ? 4 : 0) + (sloped ? 2 : 0) + anchorParity);
+    }
+
+    /**
+     * @brief      Score of one window for red, yellow scores are the negation.
+     *
+     * @param[in]  streak        The window length
+     * @param[in]  contents      The base 3 window contents
+     * @param[in]  sloped        False for horizontal windows, true when every
+     *                           slot is one row lower than the previous one
+     * @param[in]  anchorParity  Row parity of the first slot (1 = odd row from the bottom)
+     * @param[in]  parity        Whether threats are weighted by row parity
+     */
+    constexpr int32_t windowScore(int streak, int contents, bool sloped, int anchorParity, bool parity) {
+        int red = 0;
+        int yellow = 0;
+        int emptySlot = 0;
+        for (int i = 0; i < streak; i++, contents /= 3) {
+            int slot = contents % 3;
+            if (slot == 1) red++;
+            else if (slot == 2) yellow++;
+            else emptySlot = i;
+        }
+        // Blocked windows are worthless, finished ones are handled as wins
+        if ((red && yellow) || red == streak || yellow == streak) return 0;
+
+        int pieces = red + yellow;
+        int32_t value = pieces == 0 ? 0 : int32_t(1) << (3 * (pieces - 1));
+        if (parity && pieces == streak - 1) {
+            int slotParity = sloped ? (anchorParity ^ (emptySlot & 1)) : anchorParity;
+            if ((red && slotParity == 1) || (yellow && slotParity == 0)) value *= 2;
+        }
+        return red ? value : -value;
+    }
+
+    template <int K>
+    constexpr std::array<int32_t, kBlocks * pow3(K)> makeTable() {
+        std::array<int32_t, kBlocks * pow3(K)> table{};
+        for (int block = 0; block < kBlocks; block++) {
+            for (int contents = 0; contents < pow3(K); contents++) {
+                table[block * pow3(K) + contents] =
+                    windowScore(K, contents, block & 2, block & 1, block & 4);
+            }
+        }
+        return table;
+    }
+
+    // Tables for the geometries we run all the time
+    inline constexpr auto kTable3 = makeTable<3>();
+    inline constexpr auto kTable4 = makeTable<4>();
+    inline constexpr auto kTable5 = makeTable<5>();
+}
+
+class PatternEvaluator
+{
+    public:
+        // Longest streak with a table, 3^8 entries per block
+        static constexpr int kMaxStreak = 8;
+
+        PatternEvaluator(int width, int height, int winningStreakSize);
+
+        /**
+         * @brief      Determines if the geometry can be handled. Boards with
+         * longer streaks keep using the streak heuristic.
+         */
+        static bool supportsGeometry(int width, int height, int winningStreakSize);
+
+        /**
+         * @brief      Evaluates a board.
+         *
+         * @param[in]  board   The board
+         * @param[in]  player  The player the score is computed for
+         *
+         * @return     INT_MAX/INT_MIN for a won/lost board, the summed window
+         * scores otherwise
+         */
+        int evaluate(const SlotStatus* board, Player player) const;
+
+        /**
+         * @brief      Evaluates a batch of positions, same interface as
+         * BatchEvaluator::evaluateBatch.
+         */
+        void evaluateBatch(const Position* positions, size_t n, int* scores_out) const;
+
+    private:
+        int _streak;
+        int _numSlots;
+        int _blockSize;
+        const int32_t* _table;
+        std::vector<int32_t> _ownedTable;
+
+        // winningStreakSize slot indices per window and the table block
+        // (without the parity part) each window reads from
+        std::vector<int> _windowSlots;
+        std::vector<int> _windowBlock;
+        int _allRed;
+        int _allYellow;
+
+        int evaluateSlots(const SlotStatus* board, const int32_t* table, Player player) const;
+        int score(int32_t sum, bool redWins, bool yellowWins, Player player) const;
+};
+
+#endif
@@ -0,0 +1,141 @@
+#include "playoutKernel.hpp"
+
+#include <vector>
+
+namespace
+{
+    PlayoutKernel::detail::AdvanceFn advanceFor(EvalKernel::Isa isa)
+    {
+        switch (isa) {
+            case EvalKernel::Isa::AVX2: return PlayoutKernel::detail::advanceAvx2;
+            case EvalKernel::Isa::SSE2: return PlayoutKernel::detail::advanceSse2;
+            default: return PlayoutKernel::detail::advanceScalar;
+        }
+    }
+
+    // splitmix64, turns the playout number into a seed for its lane
+    uint64_t seedFor(uint64_t seed, uint64_t playout)
+    {
+        uint64_t z = seed + (playout + 1) * 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        // xorshift never leaves zero
+        return z ? z : 1;
+    }
+}
+
+PlayoutBatch::PlayoutBatch(int width, int height, int winningStreakSize)
+{
+    _tables.width = width;
+    _tables.height = height;
+    _tables.streak = winningStreakSize;
+    _tables.steps[0] = 1;
+    _tables.steps[1] = height + 1;
+    _tables.steps[2] = height;
+    _tables.steps[3] = height + 2;
+    _tables.bottom = 0;
+    _tables.full = 0;
+    for (int c = 0; c < width; c++) {
+        _tables.bottom |= uint64_t(1) << (c * (height + 1));
+        _tables.full |= ((uint64_t(1) << height) - 1) << (c * (height + 1));
+    }
+    _tables.column = (uint64_t(1) << (height + 1)) - 1;
+}
+
+bool PlayoutBatch::supportsGeometry(int width, int height, int winningStreakSize)
+{
+    return width > 0 && height > 0 && width * (height + 1) <= 64 && winningStreakSize >= 2;
+}
+
+uint64_t PlayoutBatch::toColumns(uint64_t pieces) const
+{
+    uint64_t columns = 0;
+    for (; pieces; pieces &= pieces - 1) {
+        int index = __builtin_ctzll(pieces);
+        int row = index / _tables.width;
+        int c = index % _tables.width;
+        columns |= uint64_t(1) << (c * (_tables.height + 1) + (_tables.height - 1 - row));
+    }
+    return columns;
+}
+
+bool PlayoutBatch::isWin(uint64_t pieces) const
+{
+    for (int d = 0; d < 4; d++) {
+        uint64_t line = pieces;
+        for (int k = 1; k < _tables.streak && line; k++) line &= pieces >> (k * _tables.steps[d]);
+        if (line) return true;
+    }
+    return false;
+}
+
+void PlayoutBatch::run(const Position* positions, size_t n, int playoutsPerPosition,
+                       uint64_t seed, PlayoutCounts* counts_out) const
+{
+    runWith(EvalKernel::activeIsa(), positions, n, playoutsPerPosition, seed, counts_out);
+}
+
+void PlayoutBatch::runWith(EvalKernel::Isa isa, const Position* positions, size_t n,
+                           int playoutsPerPosition, uint64_t seed, PlayoutCounts* counts_out) const
+{
+    using PlayoutKernel::detail::kLanes;
+    PlayoutKernel::detail::AdvanceFn advance = advanceFor(isa);
+
+    // Positions that are already decided are counted without playing
+    std::vector<size_t> open;
+    std::vector<uint64_t> own(n), mask(n);
+    for (size_t i = 0; i < n; i++) {
+        counts_out[i] = PlayoutCounts();
+        uint64_t red = toColumns(positions[i].red);
+        uint64_t yellow = toColumns(positions[i].yellow);
+        own[i] = positions[i].player == Player::Red ? red : yellow;
+        mask[i] = red | yellow;
+        if (isWin(own[i] ^ mask[i])) counts_out[i].losses = playoutsPerPosition;
+        else if (mask[i] == _tables.full) counts_out[i].draws = playoutsPerPosition;
+        else open.push_back(i);
+    }
+
+    const uint64_t total = (uint64_t)open.size() * (playoutsPerPosition > 0 ? playoutsPerPosition : 0);
+    uint64_t next = 0;
+    PlayoutKernel::detail::Lanes lanes;
+    // The playout each lane runs, total when the lane is idle
+    uint64_t playout[kLanes];
+
+    auto refill = [&](int l) {
+        lanes.side[l] = 0;
+        lanes.result[l] = 0;
+        if (next == total) {
+            playout[l] = total;
+            lanes.own[l] = lanes.mask[l] = 0;
+            lanes.rng[l] = 1;
+            lanes.active[l] = 0;
+            return;
+        }
+        size_t i = open[next / playoutsPerPosition];
+        playout[l] = next;
+        lanes.own[l] = own[i];
+        lanes.mask[l] = mask[i];
+        lanes.rng[l] = seedFor(seed, next);
+        lanes.active[l] = ~uint64_t(0);
+        next++;
+    };
+
+    for (int l = 0; l < kLanes; l++) refill(l);
+    bool busy = total > 0;
+    while (busy) {
+        advance(lanes, _tables);
+        busy = false;
+        for (int l = 0; l < kLanes; l++) {
+            if (playout[l] == total) continue;
+            if (!lanes.active[l]) {
+                PlayoutCounts& counts = counts_out[open[playout[l] / playoutsPerPosition]];
+                if (lanes.result[l] == 2) counts.wins++;
+                else if (lanes.result[l] == 1) counts.draws++;
+                else counts.losses++;
+                refill(l);
+            }
+            busy |= playout[l] != total;
+        }
+    }
+}
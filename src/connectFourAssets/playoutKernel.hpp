@@ -0,0 +1,110 @@
+/**
+ * @defgroup   PLAYOUT_KERNEL
+ *
+ * @brief      Random playouts for many positions at once. A block of kLanes
+ * games is advanced in lockstep on column major bitboards with a sentinel row
+ * (the layout MctsSolver uses), so every instruction of a step moves
+ * V::lanes games. Each lane draws its column with its own xorshift generator;
+ * a lane that draws a full column waits for the next step, which keeps the
+ * choice uniform over the open columns. Finished lanes are refilled with the
+ * next playout between steps.
+ *
+ * Every playout is seeded from its own number, so the counts do not depend
+ * on the instruction set or the lane a playout ran on.
+ *
+ * @date       2021
+ */
+#ifndef __PLAYOUT_KERNEL__
+#define __PLAYOUT_KERNEL__
+
+#include "position.hpp"
+#include "evalKernel.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+// Outcomes of the playouts of one position, seen by the player to move
+struct PlayoutCounts {
+    uint32_t wins = 0;
+    uint32_t draws = 0;
+    uint32_t losses = 0;
+};
+
+namespace PlayoutKernel
+{
+    namespace detail
+    {
+        // Games in flight, four AVX2 registers per bitboard
+        constexpr int kLanes = 16;
+
+        struct Tables {
+            int width;
+            int height;
+            int streak;
+            // Slot step of the vertical, horizontal and both diagonal directions
+            int steps[4];
+            uint64_t bottom;    // lowest slot of every column
+            uint64_t full;      // every slot of the board, without the sentinels
+            uint64_t column;    // the slots of column 0, sentinel included
+        };
+
+        // One game per lane. A lane plays while its active mask is all ones,
+        // result holds the half points (2 win, 1 draw) of the player that was
+        // to move at the start once the lane stops.
+        struct alignas(32) Lanes {
+            uint64_t own[kLanes];
+            uint64_t mask[kLanes];
+            uint64_t rng[kLanes];
+            uint64_t side[kLanes];
+            uint64_t active[kLanes];
+            uint64_t result[kLanes];
+        };
+
+        // Plays steps until at least one lane finished or none is active
+        typedef void (*AdvanceFn)(Lanes& lanes, const Tables& tables);
+
+        void advanceScalar(Lanes& lanes, const Tables& tables);
+        void advanceSse2(Lanes& lanes, const Tables& tables);
+        void advanceAvx2(Lanes& lanes, const Tables& tables);
+    }
+}
+
+class PlayoutBatch
+{
+    public:
+        PlayoutBatch(int width, int height, int winningStreakSize);
+
+        /**
+         * @brief      Determines if the geometry can be handled, which needs
+         * width * (height + 1) <= 64.
+         */
+        static bool supportsGeometry(int width, int height, int winningStreakSize);
+
+        /**
+         * @brief      Plays random games from every position.
+         *
+         * @param[in]  positions            The positions, Position::player is
+         * the player to move
+         * @param[in]  n                    The number of positions
+         * @param[in]  playoutsPerPosition  The playouts per position
+         * @param[in]  seed                 The seed of the random generators
+         * @param      counts_out           Filled with one result per position
+         */
+        void run(const Position* positions, size_t n, int playoutsPerPosition,
+                 uint64_t seed, PlayoutCounts* counts_out) const;
+
+        /**
+         * @brief      Same as run with an explicit instruction set.
+         */
+        void runWith(EvalKernel::Isa isa, const Position* positions, size_t n,
+                     int playoutsPerPosition, uint64_t seed, PlayoutCounts* counts_out) const;
+
+    private:
+        PlayoutKernel::detail::Tables _tables;
+
+        // Moves a row major bitboard (row 0 at the top) to the column layout
+        uint64_t toColumns(uint64_t pieces) const;
+        bool isWin(uint64_t pieces) const;
+};
+
+#endif
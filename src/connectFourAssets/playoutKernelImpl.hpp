@@ -0,0 +1,91 @@
+/**
+ * @defgroup   PLAYOUT_KERNEL_IMPL
+ *
+ * @brief      Width independent body of the playout kernel, instantiated next
+ * to the evaluation kernels for every instruction set. Like
+ * evalKernelImpl.hpp it has internal linkage and does not call into the
+ * standard library.
+ *
+ * Per lane and step:
+ *     rng     = xorshift64(rng)
+ *     column  = ((rng >> 32) * width) >> 32
+ *     bit     = (mask + bottom) & full & (column mask << column * (height + 1))
+ * An empty bit means the column is full and the lane sits out the step.
+ *
+ * @date       2021
+ */
+#ifndef __PLAYOUT_KERNEL_IMPL__
+#define __PLAYOUT_KERNEL_IMPL__
+
+#include "playoutKernel.hpp"
+
+#include <cstdint>
+
+namespace
+{
+    template <class V>
+    void advanceImpl(PlayoutKernel::detail::Lanes& lanes, const PlayoutKernel::detail::Tables& tables)
+    {
+        typedef typename V::T T;
+        const T one = V::set1(1);
+        const T two = V::set1(2);
+        const T width = V::set1(tables.width);
+        const T columnStride = V::set1(tables.height + 1);
+        const T bottom = V::set1(tables.bottom);
+        const T full = V::set1(tables.full);
+        const T column = V::set1(tables.column);
+
+        while (true) {
+            T finishedAny = V::zero();
+            T activeAny = V::zero();
+            for (int lane0 = 0; lane0 < PlayoutKernel::detail::kLanes; lane0 += V::lanes) {
+                T active = V::load(lanes.active + lane0);
+                T own = V::load(lanes.own + lane0);
+                T mask = V::load(lanes.mask + lane0);
+                T rng = V::load(lanes.rng + lane0);
+                T side = V::load(lanes.side + lane0);
+
+                rng = V::xor_(rng, V::shl(rng, 13));
+                rng = V::xor_(rng, V::shr(rng, 7));
+                rng = V::xor_(rng, V::shl(rng, 17));
+                T drawn = V::shr(V::mul32(V::shr(rng, 32), width), 32);
+                T shift = V::mul32(drawn, columnStride);
+                T moves = V::and_(V::add(mask, bottom), full);
+                T bit = V::and_(V::and_(moves, V::shlv(column, shift)), active);
+                T moved = V::nonzero(bit);
+
+                // Lines of the player who moved, the sentinel row keeps the
+                // shifted copies from wrapping into the next column
+                T pieces = V::or_(own, bit);
+                T lines = V::zero();
+                for (int d = 0; d < 4; d++) {
+                    T line = pieces;
+                    for (int k = 1; k < tables.streak; k++)
+                        line = V::and_(line, V::shr(pieces, k * tables.steps[d]));
+                    lines = V::or_(lines, line);
+                }
+                T won = V::and_(V::nonzero(lines), moved);
+                T newMask = V::or_(mask, bit);
+                T draw = V::and_(V::andnot(won, V::eq(newMask, full)), moved);
+
+                // A win is worth 2 when the player to move at the start made it
+                T result = V::or_(V::and_(won, V::andnot(side, two)), V::and_(draw, one));
+                T finished = V::or_(won, draw);
+                active = V::andnot(finished, active);
+
+                V::store(lanes.own + lane0, V::xor_(own, V::and_(moved, mask)));
+                V::store(lanes.mask + lane0, newMask);
+                V::store(lanes.rng + lane0, rng);
+                V::store(lanes.side + lane0, V::xor_(side, moved));
+                V::store(lanes.active + lane0, active);
+                V::store(lanes.result + lane0, V::or_(V::load(lanes.result + lane0), result));
+
+                finishedAny = V::or_(finishedAny, finished);
+                activeAny = V::or_(activeAny, active);
+            }
+            if (V::any(finishedAny) || !V::any(activeAny)) return;
+        }
+    }
+}
+
+#endif
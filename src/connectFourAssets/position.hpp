@@ -0,0 +1,78 @@
+/**
+ * @defgroup   POSITION
+ *
+ * @brief      Compact bitboard copy of a board, used wherever many positions
+ * have to be stored or handed around at once. Only boards with at most 64
+ * slots fit.
+ *
+ * Bit (row * width + column) is set in red/yellow when that slot holds the
+ * color, which is the same row major indexing the Board class uses (row 0 is
+ * the top row).
+ *
+ * @date       2021
+ */
+#ifndef __POSITION__
+#define __POSITION__
+
+#include "slotStatus.hpp"
+#include "player.hpp"
+
+#include <cstdint>
+
+struct Position {
+    uint64_t red = 0;
+    uint64_t yellow = 0;
+    // The player the position is scored for
+    Player player = Player::Red;
+};
+
+namespace PositionHelpers
+{
+    /**
+     * @brief      Determines if a board of the given size fits in a Position.
+     */
+    inline bool fitsBitboard(int width, int height) {
+        return width > 0 && height > 0 && width * height <= 64;
+    }
+
+    /**
+     * @brief      Builds a position from a board array.
+     *
+     * @param[in]  board     The board
+     * @param[in]  numSlots  The number of slots (width * height)
+     * @param[in]  player    The player the position is scored for
+     *
+     * @return     The position
+     */
+    inline Position fromBoard(const SlotStatus* board, int numSlots, Player player) {
+        Position position;
+        position.player = player;
+        for (int i = 0; i < numSlots; i++) {
+            if (board[i] == SlotStatus::Red) position.red |= uint64_t(1) << i;
+            else if (board[i] == SlotStatus::Yellow) position.yellow |= uint64_t(1) << i;
+        }
+        return position;
+    }
+
+    /**
+     * @brief      Drops a piece of the given color on the slot index.
+     */
+    inline void play(Position& position, int index, SlotStatus color) {
+        if (color == SlotStatus::Red) position.red |= uint64_t(1) << index;
+        else position.yellow |= uint64_t(1) << index;
+    }
+
+    /**
+     * @brief      Slots where a piece can be dropped: empty slots on the bottom
+     * row or right above an occupied slot.
+     */
+    inline uint64_t legalMoves(const Position& position, int width, int height) {
+        int numSlots = width * height;
+        uint64_t all = numSlots == 64 ? ~uint64_t(0) : (uint64_t(1) << numSlots) - 1;
+        uint64_t occupied = position.red | position.yellow;
+        uint64_t bottomRow = (width >= 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1) << (width * (height - 1));
+        return ~occupied & all & ((occupied >> width) | bottomRow);
+    }
+}
+
+#endif
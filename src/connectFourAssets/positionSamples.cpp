@@ -0,0 +1,146 @@
+#include "positionSamples.hpp"
+
+#include <cstring>
+#include <iostream>
+
+SampleWriter::~SampleWriter()
+{
+    close();
+}
+
+std::string SampleWriter::shardPath(const std::string& prefix, int shard)
+{
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), ".%03d", shard);
+    return prefix + suffix;
+}
+
+bool SampleWriter::open(const std::string& prefix, int width, int height, int winningStreakSize, int shards)
+{
+    close();
+    if (!supportsGeometry(width, height) || shards <= 0) {
+        std::cerr << "Position samples need a board of at most 64 slots and a shard" << std::endl;
+        return false;
+    }
+    SampleShardHeader header = {};
+    memcpy(header.magic, "C4SP", 4);
+    header.version = kVersion;
+    header.width = width;
+    header.height = height;
+    header.winningStreakSize = winningStreakSize;
+    header.shards = shards;
+    for (int i = 0; i < shards; i++) {
+        std::unique_ptr<Shard> shard(new Shard());
+        const std::string path = shardPath(prefix, i);
+        shard->file = fopen(path.c_str(), "wb");
+        header.shard = i;
+        if (!shard->file || fwrite(&header, sizeof(header), 1, shard->file) != 1) {
+            std::cerr << "Could not create sample shard " << path << std::endl;
+            if (shard->file) fclose(shard->file);
+            close();
+            return false;
+        }
+        shard->buffer.reserve(kFlushSamples);
+        _shards.push_back(std::move(shard));
+    }
+    return true;
+}
+
+void SampleWriter::close()
+{
+    for (std::unique_ptr<Shard>& shard : _shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        writeOut(*shard);
+        fclose(shard->file);
+    }
+    _shards.clear();
+}
+
+bool SampleWriter::add(const PositionSample& sample)
+{
+    if (_shards.empty()) return false;
+    // The low bits of the key pick the shard, the set hashes all of them
+    Shard& shard = *_shards[sample.key % _shards.size()];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (!shard.keys.insert(sample.key).second) {
+        ++shard.duplicates;
+        return false;
+    }
+    shard.buffer.push_back(sample);
+    ++shard.written;
+    if (shard.buffer.size() >= kFlushSamples) writeOut(shard);
+    return true;
+}
+
+void SampleWriter::writeOut(Shard& shard)
+{
+    if (shard.buffer.empty()) return;
+    if (fwrite(shard.buffer.data(), sizeof(PositionSample), shard.buffer.size(), shard.file) != shard.buffer.size())
+        std::cerr << "Could not write position samples" << std::endl;
+    shard.buffer.clear();
+}
+
+uint64_t SampleWriter::written() const
+{
+    uint64_t total = 0;
+    for (const std::unique_ptr<Shard>& shard : _shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total += shard->written;
+    }
+    return total;
+}
+
+uint64_t SampleWriter::duplicates() const
+{
+    uint64_t total = 0;
+    for (const std::unique_ptr<Shard>& shard : _shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total += shard->duplicates;
+    }
+    return total;
+}
+
+SampleReader::~SampleReader()
+{
+    close();
+}
+
+bool SampleReader::open(const std::string& path)
+{
+    close();
+    _file = fopen(path.c_str(), "rb");
+    if (!_file) {
+        std::cerr << "Could not open sample shard " << path << std::endl;
+        return false;
+    }
+    if (fread(&_header, sizeof(_header), 1, _file) != 1 || memcmp(_header.magic, "C4SP", 4) ||
+        _header.version != SampleWriter::kVersion) {
+        std::cerr << "Sample shard " << path << " is not a valid shard" << std::endl;
+        close();
+        return false;
+    }
+    _buffer.reserve(kReadSamples);
+    return true;
+}
+
+void SampleReader::close()
+{
+    if (_file) fclose(_file);
+    _file = nullptr;
+    _buffer.clear();
+    _position = 0;
+}
+
+bool SampleReader::next(PositionSample& sample)
+{
+    if (_position == _buffer.size()) {
+        if (!_file) return false;
+        // A torn record at the end is not read
+        _buffer.resize(kReadSamples);
+        _buffer.resize(fread(_buffer.data(), sizeof(PositionSample), kReadSamples, _file));
+        _position = 0;
+        if (_buffer.empty()) return false;
+    }
+    sample = _buffer[_position++];
+    return true;
+}
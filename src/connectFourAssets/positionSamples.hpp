@@ -0,0 +1,146 @@
+/**
+ * @defgroup   POSITION_SAMPLES
+ *
+ * @brief      Sharded files of positions labelled with search results, the
+ * output of the self-play generator (--self-play) and the input of tuning.
+ *
+ * A corpus is a number of shard files, <prefix>.<shard>, each a header
+ * followed by fixed size PositionSample records in no particular order. A
+ * position goes to the shard its key selects and only the first sample of a
+ * position is kept, so the shards hold disjoint sets of positions and can be
+ * read independently. SampleReader streams a shard through a small buffer and
+ * stops at a torn last record.
+ *
+ * Positions are stored as the slots of each color, bit i standing for slot i
+ * of Board::getBoard(), which limits the corpus to boards of at most 64
+ * slots. Red is assumed to move first.
+ *
+ * @date       2021
+ */
+#ifndef __POSITION_SAMPLES__
+#define __POSITION_SAMPLES__
+
+#include "player.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+struct SampleShardHeader {
+    char magic[4];          // "C4SP"
+    uint32_t version;
+    uint8_t width;
+    uint8_t height;
+    uint8_t winningStreakSize;
+    uint8_t reserved;
+    uint32_t shard;         // index of this shard
+    uint32_t shards;        // number of shards of the corpus
+};
+
+struct PositionSample {
+    uint64_t key;           // Zobrist::scoredKey of the canonical key
+    uint64_t red;           // slots holding red pieces
+    uint64_t yellow;        // slots holding yellow pieces
+    int32_t score;          // search score for the player to move
+    int8_t column;          // best move (0-indexed) in this orientation
+    uint8_t depth;          // depth of the search
+    uint8_t plies;          // pieces on the board, odd when yellow is to move
+    int8_t result;          // 1 win, 0 draw, -1 loss of the game for the player to move
+
+    Player toMove() const { return (plies % 2) ? Player::Yellow : Player::Red; }
+};
+
+class SampleWriter
+{
+    public:
+        static constexpr uint32_t kVersion = 1;
+        // Samples a shard buffers before it writes them out
+        static constexpr size_t kFlushSamples = 4096;
+
+        SampleWriter() = default;
+        ~SampleWriter();
+        SampleWriter(const SampleWriter&) = delete;
+        SampleWriter& operator=(const SampleWriter&) = delete;
+
+        static bool supportsGeometry(int width, int height) { return width * height <= 64; }
+
+        /**
+         * @brief      Creates the shard files, replacing existing ones.
+         *
+         * @return     False if a shard cannot be written
+         */
+        bool open(const std::string& prefix, int width, int height, int winningStreakSize, int shards);
+
+        // Writes the buffered samples and closes the shards
+        void close();
+
+        /**
+         * @brief      Adds a sample unless its position was added before. Safe
+         * to call from several threads, which only contend for a shard.
+         *
+         * @return     True if the sample was kept
+         */
+        bool add(const PositionSample& sample);
+
+        uint64_t written() const;
+        uint64_t duplicates() const;
+
+        static std::string shardPath(const std::string& prefix, int shard);
+
+    private:
+        struct Shard {
+            std::mutex mutex;
+            FILE* file = nullptr;
+            std::unordered_set<uint64_t> keys;
+            std::vector<PositionSample> buffer;
+            uint64_t written = 0;
+            uint64_t duplicates = 0;
+        };
+
+        std::vector<std::unique_ptr<Shard>> _shards;
+
+        static void writeOut(Shard& shard);
+};
+
+class SampleReader
+{
+    public:
+        // Samples read from the file at a time
+        static constexpr size_t kReadSamples = 4096;
+
+        SampleReader() = default;
+        ~SampleReader();
+        SampleReader(const SampleReader&) = delete;
+        SampleReader& operator=(const SampleReader&) = delete;
+
+        /**
+         * @brief      Opens a shard and checks its header.
+         *
+         * @return     False if it is not a shard, the reader stays closed then
+         */
+        bool open(const std::string& path);
+
+        void close();
+
+        const SampleShardHeader& header() const { return _header; }
+
+        /**
+         * @brief      Reads the next sample.
+         *
+         * @return     False at the end of the shard
+         */
+        bool next(PositionSample& sample);
+
+    private:
+        FILE* _file = nullptr;
+        SampleShardHeader _header = {};
+        std::vector<PositionSample> _buffer;
+        size_t _position = 0;
+};
+
+#endif
@@ -0,0 +1,311 @@
+/**
+ * @defgroup   TABLEBASE
+ *
+ * @brief      Retrograde tablebase generation and lookup.
+ *
+ * @date       2021
+ */
+
+#include "tablebase.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    typedef Tablebase::Value Value;
+
+    // Value of the parent for the move into a child with the given value
+    Value negate(Value child) {
+        switch (child) {
+            case Value::Loss: return Value::Win;
+            case Value::Win: return Value::Loss;
+            default: return child;
+        }
+    }
+
+    void set(std::vector<uint8_t>& values, uint64_t index, Value value) {
+        values[index >> 2] = (values[index >> 2] & ~(3 << (2 * (index & 3)))) |
+                             ((uint8_t)value << (2 * (index & 3)));
+    }
+
+    int popcount(uint64_t x) { return __builtin_popcountll(x); }
+}
+
+Tablebase::~Tablebase()
+{
+    close();
+}
+
+Tablebase& Tablebase::shared()
+{
+    static Tablebase tablebase;
+    return tablebase;
+}
+
+uint64_t Tablebase::indexSpace(int width, int height)
+{
+    if (!PositionHelpers::fitsBitboard(width, height) || height > 30) return 0;
+    const uint64_t columnStates = (uint64_t(1) << (height + 1)) - 1;
+    uint64_t space = 1;
+    for (int c = 0; c < width; c++) {
+        space *= columnStates;
+        if (space > kMaxEntries) return 0;
+    }
+    return space;
+}
+
+bool Tablebase::supportsGeometry(int width, int height, int winningStreakSize)
+{
+    return winningStreakSize >= 2 && indexSpace(width, height) > 0;
+}
+
+void Tablebase::Geometry::init(int width, int height, int streak)
+{
+    this->width = width;
+    this->height = height;
+    this->streak = streak;
+    lines.assign(width * height, {});
+    const int dirs[4][2] = {{0, 1}, {1, 0}, {1, 1}, {1, -1}};
+    for (int d = 0; d < 4; d++) {
+        for (int row = 0; row < height; row++) {
+            for (int col = 0; col < width; col++) {
+                int endRow = row + (streak - 1) * dirs[d][0];
+                int endCol = col + (streak - 1) * dirs[d][1];
+                if (endRow >= height || endCol < 0 || endCol >= width) continue;
+                uint64_t mask = 0;
+                for (int k = 0; k < streak; k++)
+                    mask |= uint64_t(1) << ((row + k * dirs[d][0]) * width + col + k * dirs[d][1]);
+                for (int k = 0; k < streak; k++)
+                    lines[(row + k * dirs[d][0]) * width + col + k * dirs[d][1]].push_back(mask);
+            }
+        }
+    }
+}
+
+Position Tablebase::Geometry::fromBoard(const SlotStatus* board, Player toMove) const
+{
+    Position position = PositionHelpers::fromBoard(board, width * height, Player::Red);
+    // Whoever has more pieces moved first, on an even ply the player to move
+    // did
+    const int red = popcount(position.red), yellow = popcount(position.yellow);
+    if (red == yellow ? toMove == Player::Yellow : yellow > red) std::swap(position.red, position.yellow);
+    return position;
+}
+
+uint64_t Tablebase::Geometry::index(const Position& position) const
+{
+    const uint64_t columnStates = (uint64_t(1) << (height + 1)) - 1;
+    uint64_t index = 0;
+    for (int col = 0; col < width; col++) {
+        uint64_t bits = 0;
+        int n = 0;
+        for (int row = height - 1; row >= 0; row--, n++) {
+            uint64_t slot = uint64_t(1) << (row * width + col);
+            if (position.red & slot) bits |= uint64_t(1) << n;
+            else if (!(position.yellow & slot)) break;
+        }
+        index = index * columnStates + (uint64_t(1) << n) - 1 + bits;
+    }
+    return index;
+}
+
+bool Tablebase::Geometry::completesLine(uint64_t pieces, int slot) const
+{
+    for (uint64_t mask : lines[slot])
+        if ((pieces & mask) == mask) return true;
+    return false;
+}
+
+long Tablebase::generate(const std::string& path, int width, int height, int winningStreakSize)
+{
+    if (!supportsGeometry(width, height, winningStreakSize)) {
+        std::cerr << "Tablebase: geometry " << width << "x" << height << " is too large" << std::endl;
+        return -1;
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    const uint64_t space = indexSpace(width, height);
+    const int numSlots = width * height;
+    Geometry geometry;
+    geometry.init(width, height, winningStreakSize);
+
+    std::vector<uint8_t> values((space + 3) / 4, 0);
+    std::vector<uint64_t> reached((space + 63) / 64, 0);
+
+    // Forward pass: the positions of every ply that are reachable without a
+    // win on the way. Positions right after a winning move are terminal and
+    // get their value here.
+    std::vector<std::vector<Position>> plies(numSlots + 1);
+    plies[0].push_back(Position());
+    reached[0] |= 1;
+    long count = 1;
+    for (int ply = 0; ply < numSlots; ply++) {
+        for (const Position& position : plies[ply]) {
+            uint64_t moves = PositionHelpers::legalMoves(position, width, height);
+            for (; moves; moves &= moves - 1) {
+                int slot = __builtin_ctzll(moves);
+                Position child = position;
+                PositionHelpers::play(child, slot, (ply & 1) ? SlotStatus::Yellow : SlotStatus::Red);
+                uint64_t index = geometry.index(child);
+                if (reached[index >> 6] & (uint64_t(1) << (index & 63))) continue;
+                reached[index >> 6] |= uint64_t(1) << (index & 63);
+                ++count;
+                if (geometry.completesLine((ply & 1) ? child.yellow : child.red, slot))
+                    set(values, index, Value::Loss);
+                else
+                    plies[ply + 1].push_back(child);
+            }
+        }
+    }
+    reached = std::vector<uint64_t>();
+
+    // Backward pass: full boards are draws, every other position takes the
+    // best value over its children, which are one ply deeper and solved
+    for (int ply = numSlots; ply >= 0; ply--) {
+        for (const Position& position : plies[ply]) {
+            Value best = Value::Loss;
+            if (ply == numSlots) best = Value::Draw;
+            uint64_t moves = PositionHelpers::legalMoves(position, width, height);
+            for (; moves && best != Value::Win; moves &= moves - 1) {
+                int slot = __builtin_ctzll(moves);
+                Position child = position;
+                PositionHelpers::play(child, slot, (ply & 1) ? SlotStatus::Yellow : SlotStatus::Red);
+                Value value = negate(get(values.data(), geometry.index(child)));
+                if (value > best) best = value;
+            }
+            set(values, geometry.index(position), best);
+        }
+        if (ply < numSlots) plies[ply + 1] = std::vector<Position>();
+    }
+
+    TablebaseHeader header = {};
+    memcpy(header.magic, "C4TB", 4);
+    header.version = kVersion;
+    header.width = width;
+    header.height = height;
+    header.winningStreakSize = winningStreakSize;
+    header.count = space;
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Could not create tablebase " << path << std::endl;
+        return -1;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(values.data(), 1, values.size(), file) == values.size();
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) {
+        std::cerr << "Could not write tablebase " << path << std::endl;
+        return -1;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    const char* names[] = {"unknown", "loss", "draw", "win"};
+    std::cout << "Tablebase: solved " << count << " positions of " << width << "x" << height
+              << " (streak " << winningStreakSize << ") in " << elapsed.count() << " s, "
+              << names[(int)get(values.data(), 0)] << " for the first player" << std::endl;
+    return count;
+}
+
+bool Tablebase::open(const std::string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Could not open tablebase " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TablebaseHeader)) {
+        std::cerr << "Tablebase " << path << " is too small" << std::endl;
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Could not map tablebase " << path << std::endl;
+        return false;
+    }
+
+    const TablebaseHeader* header = (const TablebaseHeader*)mapping;
+    if (memcmp(header->magic, "C4TB", 4) != 0 || header->version != kVersion ||
+        !supportsGeometry(header->width, header->height, header->winningStreakSize) ||
+        header->count != indexSpace(header->width, header->height) ||
+        sizeof(TablebaseHeader) + (header->count + 3) / 4 != (size_t)st.st_size) {
+        std::cerr << "Tablebase " << path << " is not a valid tablebase" << std::endl;
+        munmap(mapping, st.st_size);
+        return false;
+    }
+
+    _mapping = mapping;
+    _mappingSize = st.st_size;
+    _header = header;
+    _values = (const uint8_t*)(header + 1);
+    _geometry.init(header->width, header->height, header->winningStreakSize);
+    return true;
+}
+
+void Tablebase::close()
+{
+    if (_mapping) munmap(_mapping, _mappingSize);
+    _mapping = nullptr;
+    _mappingSize = 0;
+    _header = nullptr;
+    _values = nullptr;
+}
+
+bool Tablebase::matches(int width, int height, int winningStreakSize) const
+{
+    return isOpen() && _header->width == width && _header->height == height &&
+           _header->winningStreakSize == winningStreakSize;
+}
+
+Tablebase::Value Tablebase::lookup(const Position& position) const
+{
+    return get(_values, _geometry.index(position));
+}
+
+Tablebase::Value Tablebase::value(const SlotStatus* board, Player toMove) const
+{
+    if (!isOpen()) return Value::Unknown;
+    return lookup(_geometry.fromBoard(board, toMove));
+}
+
+int Tablebase::bestMove(const SlotStatus* board, Player toMove, Value* value) const
+{
+    if (!isOpen()) return -1;
+    const Position position = _geometry.fromBoard(board, toMove);
+    const bool firstToMove = popcount(position.red) == popcount(position.yellow);
+    if (lookup(position) == Value::Unknown) return -1;
+
+    // Highest slot index first, the order the solvers scan moves in
+    int move = -1;
+    Value best = Value::Unknown;
+    uint64_t moves = PositionHelpers::legalMoves(position, _geometry.width, _geometry.height);
+    for (; moves; moves &= ~(uint64_t(1) << (63 - __builtin_clzll(moves)))) {
+        int slot = 63 - __builtin_clzll(moves);
+        Position child = position;
+        PositionHelpers::play(child, slot, firstToMove ? SlotStatus::Red : SlotStatus::Yellow);
+        Value result;
+        if (_geometry.completesLine(firstToMove ? child.red : child.yellow, slot))
+            result = Value::Win;
+        else
+            result = negate(lookup(child));
+        if (result > best) {
+            best = result;
+            move = slot;
+        }
+        if (best == Value::Win) break;
+    }
+    if (value) *value = best;
+    return move;
+}
@@ -0,0 +1,150 @@
+/**
+ * @defgroup   TABLEBASE
+ *
+ * @brief      Exact game values for small geometries. Every position that
+ * can be reached from the empty board is enumerated ply by ply, and the plies
+ * are then solved backward starting from the full board, so each position
+ * only looks at children that already have their final value.
+ *
+ * The values are packed at 2 bits per position. A position is indexed by the
+ * state of each column (its height and the owners of its pieces), which gives
+ * (2^(height+1) - 1)^width slots, most of which are unreachable and stay
+ * Unknown. The file is memory mapped like the opening book.
+ *
+ * Values are stored for the player to move, with the pieces split into
+ * those of the first and the second player. On an odd ply the first player
+ * is the one with more pieces, on an even ply the pieces look the same for
+ * both starts and the player to move tells them apart, so lookups take it.
+ *
+ * @date       2021
+ */
+#ifndef __TABLEBASE__
+#define __TABLEBASE__
+
+#include "slotStatus.hpp"
+#include "player.hpp"
+#include "position.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct TablebaseHeader {
+    char magic[4];          // "C4TB"
+    uint32_t version;
+    uint8_t width;
+    uint8_t height;
+    uint8_t winningStreakSize;
+    uint8_t reserved[5];
+    uint64_t count;         // number of 2 bit values
+};
+
+class Tablebase
+{
+    public:
+        enum class Value : uint8_t {Unknown = 0, Loss, Draw, Win};
+
+        static constexpr uint32_t kVersion = 1;
+        // Largest index space generated, 256 MB of values
+        static constexpr uint64_t kMaxEntries = uint64_t(1) << 30;
+
+        Tablebase() = default;
+        ~Tablebase();
+        Tablebase(const Tablebase&) = delete;
+        Tablebase& operator=(const Tablebase&) = delete;
+
+        /**
+         * @brief      The tablebase SequentialSolver::solve consults.
+         */
+        static Tablebase& shared();
+
+        /**
+         * @brief      Number of values needed for a geometry, 0 if the geometry
+         * does not fit in a bitboard or needs more than kMaxEntries.
+         */
+        static uint64_t indexSpace(int width, int height);
+
+        /**
+         * @brief      Determines if the geometry can be handled
+         */
+        static bool supportsGeometry(int width, int height, int winningStreakSize);
+
+        /**
+         * @brief      Solves every reachable position and writes the values.
+         *
+         * @param[in]  path               The path of the tablebase
+         * @param[in]  width              The width of the board
+         * @param[in]  height             The height of the board
+         * @param[in]  winningStreakSize  The winning streak size
+         *
+         * @return     The number of reachable positions, -1 on failure
+         */
+        static long generate(const std::string& path, int width, int height, int winningStreakSize);
+
+        /**
+         * @brief      Maps a tablebase file.
+         *
+         * @return     True on success, the tablebase stays closed otherwise
+         */
+        bool open(const std::string& path);
+
+        // Unmaps the tablebase
+        void close();
+
+        bool isOpen() const { return _values != nullptr; }
+
+        /**
+         * @brief      Determines if the tablebase was built for the geometry.
+         */
+        bool matches(int width, int height, int winningStreakSize) const;
+
+        /**
+         * @brief      Value of a board for the player to move.
+         */
+        Value value(const SlotStatus* board, Player toMove) const;
+
+        /**
+         * @brief      Finds a move that keeps the best value: a win if there is
+         * one, a draw otherwise.
+         *
+         * @param[in]  board   The board
+         * @param[in]  toMove  The player to move
+         * @param      value   Set to the value of the position if not null
+         *
+         * @return     The index (row major) of the move, -1 if the position is
+         * not in the table or has no moves
+         */
+        int bestMove(const SlotStatus* board, Player toMove, Value* value = nullptr) const;
+
+    private:
+        // Geometry and winning lines of the open tablebase or the one being
+        // generated
+        struct Geometry {
+            int width = 0;
+            int height = 0;
+            int streak = 0;
+            // Winning lines through each slot, as bitboard masks
+            std::vector<std::vector<uint64_t>> lines;
+
+            void init(int width, int height, int streak);
+            // Split of a board into the pieces of the first and second player
+            Position fromBoard(const SlotStatus* board, Player toMove) const;
+            uint64_t index(const Position& position) const;
+            bool completesLine(uint64_t pieces, int slot) const;
+        };
+
+        static Value get(const uint8_t* values, uint64_t index) {
+            return (Value)((values[index >> 2] >> (2 * (index & 3))) & 3);
+        }
+
+        Value lookup(const Position& position) const;
+
+        void* _mapping = nullptr;
+        size_t _mappingSize = 0;
+        const TablebaseHeader* _header = nullptr;
+        const uint8_t* _values = nullptr;
+        Geometry _geometry;
+};
+
+#endif
@@ -0,0 +1,61 @@
+/**
+ * @defgroup   TRANSPOSITION_TABLE
+ *
+ * @brief      Bucketed transposition table with aging.
+ *
+ * @date       2021
+ */
+
+#include "transpositionTable.hpp"
+
+TranspositionTable::TranspositionTable(size_t sizeKb)
+{
+    size_t buckets = 1;
+    while (buckets * 2 * kBucketSize * sizeof(Entry) <= sizeKb * 1024) buckets *= 2;
+    // Value initialized, so every entry starts out empty
+    _entries.resize(buckets * kBucketSize);
+    _bucketMask = buckets - 1;
+}
+
+void TranspositionTable::store(uint64_t key, int depth, int value, Bound bound)
+{
+    Entry* bucket = &_entries[(key & _bucketMask) * kBucketSize];
+    Entry* victim = bucket;
+    int victimWorth = 1 << 30;
+    for (int i = 0; i < kBucketSize; i++) {
+        Entry& entry = bucket[i];
+        if (entry.key == key && entry.depth == depth && bound != Bound::Exact &&
+            (Bound)entry.bound == Bound::Exact) {
+            entry.generation = _generation;
+            return;
+        }
+        if (entry.key == 0 || (entry.key == key && entry.depth == depth)) {
+            victim = &entry;
+            break;
+        }
+        // Deep entries are worth more, every generation of age costs two plies
+        int age = (uint8_t)(_generation - entry.generation);
+        int worth = entry.depth - 2 * age;
+        if (worth < victimWorth) {
+            victimWorth = worth;
+            victim = &entry;
+        }
+    }
+    victim->key = key;
+    victim->value = value;
+    victim->depth = (uint8_t)depth;
+    victim->generation = _generation;
+    victim->bound = (uint8_t)bound;
+}
+
+void TranspositionTable::clear()
+{
+    for (Entry& entry : _entries) {
+        entry.key = 0;
+        entry.value = 0;
+        entry.depth = 0;
+        entry.generation = 0;
+        entry.bound = 0;
+        entry.reserved = 0;
+    }
+}
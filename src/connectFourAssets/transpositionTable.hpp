@@ -0,0 +1,122 @@
+/**
+ * @defgroup   TRANSPOSITION_TABLE
+ *
+ * @brief      Minimax values of interior search nodes, kept for the lifetime
+ * of a solver. Without pruning a node's value only depends on the position,
+ * the remaining depth and the scored player, so a hit is always exact and can
+ * be reused by later moves of the same game, or later games. The alpha-beta
+ * drivers also store the bounds they get from searches that failed high or
+ * low, those only answer probes with a window they fall outside of.
+ *
+ * Entries are grouped in buckets of one cache line. Instead of being cleared,
+ * the table is aged: every search starts a new generation, and a store
+ * replaces the entry of the bucket with the least depth once entries from old
+ * generations have been discounted. Entries that keep getting hits are moved
+ * to the current generation.
+ *
+ * @date       2021
+ */
+#ifndef __TRANSPOSITION_TABLE__
+#define __TRANSPOSITION_TABLE__
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class TranspositionTable
+{
+    public:
+        // Nodes with fewer plies left are cheaper to search again than to store
+        static constexpr int kMinDepth = 3;
+
+        // What a stored value says about the node's minimax value
+        enum class Bound : uint8_t {Exact = 0, Lower, Upper};
+
+        /**
+         * @brief      Constructs a new instance.
+         *
+         * @param[in]  sizeKb  The table size in KB, rounded down to a power of
+         * two number of buckets
+         */
+        explicit TranspositionTable(size_t sizeKb);
+
+        /**
+         * @brief      Looks up an exact node value. With the full window only
+         * bounds that pin the value (a win or a loss) hit besides exact entries.
+         *
+         * @param[in]  key    The node key (Zobrist::nodeKey), 0 is never stored
+         * @param[in]  depth  The remaining depth of the node
+         * @param      value  Set to the stored value on a hit
+         *
+         * @return     True on a hit
+         */
+        bool probe(uint64_t key, int depth, int& value) {
+            return probe(key, depth, INT_MIN, INT_MAX, value);
+        }
+
+        /**
+         * @brief      Looks up a node value for an alpha-beta window. Bounds
+         * hit when they already decide the node: a lower bound >= beta or an
+         * upper bound <= alpha.
+         */
+        bool probe(uint64_t key, int depth, int alpha, int beta, int& value) {
+            ++_probes;
+            Entry* bucket = &_entries[(key & _bucketMask) * kBucketSize];
+            for (int i = 0; i < kBucketSize; i++) {
+                if (bucket[i].key == key && bucket[i].depth == depth) {
+                    bucket[i].generation = _generation;
+                    Bound bound = (Bound)bucket[i].bound;
+                    if (bound == Bound::Exact || (bound == Bound::Lower && bucket[i].value >= beta) ||
+                        (bound == Bound::Upper && bucket[i].value <= alpha)) {
+                        ++_hits;
+                        value = bucket[i].value;
+                        return true;
+                    }
+                    return false;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @brief      Stores a node value. A bound does not replace an exact
+         * value of the same node.
+         */
+        void store(uint64_t key, int depth, int value, Bound bound = Bound::Exact);
+
+        /**
+         * @brief      Starts a new generation. Called once per search, older
+         * entries stay usable but are the first to be replaced.
+         */
+        void newSearch() { ++_generation; }
+
+        // Drops all entries
+        void clear();
+
+        uint64_t hits() const { return _hits; }
+        uint64_t probes() const { return _probes; }
+        double hitRate() const { return _probes ? (double)_hits / _probes : 0.0; }
+        void resetStats() { _hits = 0; _probes = 0; }
+
+        size_t sizeKb() const { return _entries.size() * sizeof(Entry) / 1024; }
+
+    private:
+        struct Entry {
+            uint64_t key;
+            int32_t value;
+            uint8_t depth;
+            uint8_t generation;
+            uint8_t bound;
+            uint8_t reserved;
+        };
+        static constexpr int kBucketSize = 4;
+
+        std::vector<Entry> _entries;
+        uint64_t _bucketMask;
+        uint8_t _generation = 0;
+        uint64_t _hits = 0;
+        uint64_t _probes = 0;
+};
+
+#endif
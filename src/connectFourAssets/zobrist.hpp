@@ -0,0 +1,120 @@
+/**
+ * @defgroup   ZOBRIST
+ *
+ * @brief      Zobrist keys for board positions. Every (slot, color) pair has a
+ * fixed random 64 bit value and a position's key is the xor of the values of
+ * its pieces, so a move or an undo updates the key with a single xor.
+ *
+ * The values are a pure function of the slot index and the color. Board and
+ * the bitboard code in the solvers each keep their own table and still agree
+ * on every key.
+ *
+ * The mirror key is the key of the position reflected left to right, kept up
+ * to date with a second table. The smaller of the two is the canonical key,
+ * which is the same for a position and its mirror image.
+ *
+ * @date       2021
+ */
+#ifndef __ZOBRIST__
+#define __ZOBRIST__
+
+#include "slotStatus.hpp"
+#include "player.hpp"
+
+#include <cstdint>
+
+namespace Zobrist
+{
+    // Key of the empty board. Not 0, so caches can use 0 for empty slots.
+    constexpr uint64_t kEmptyKey = 0x8A5CD789635D2DFFull;
+
+    // Mixed into keys of scores that depend on the player they are computed for
+    constexpr uint64_t kPlayerKey = 0xD6E8FEB86659FD93ull;
+
+    // Mixed into keys of search nodes where the scored player is to move
+    constexpr uint64_t kMaximizerKey = 0x5B1E2C7A93F04D61ull;
+
+    /**
+     * @brief      Value of a piece of the given color on the slot index.
+     */
+    inline uint64_t slotKey(int index, SlotStatus color) {
+        // splitmix64 of the (slot, color) pair
+        uint64_t x = 0x9E3779B97F4A7C15ull * (2 * (uint64_t)index + (color == SlotStatus::Yellow ? 2 : 1));
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    /**
+     * @brief      Fills a table with two values per slot, red at 2 * index and
+     * yellow at 2 * index + 1.
+     */
+    inline void fillTable(uint64_t* table, int numSlots) {
+        for (int i = 0; i < numSlots; i++) {
+            table[2 * i] = slotKey(i, SlotStatus::Red);
+            table[2 * i + 1] = slotKey(i, SlotStatus::Yellow);
+        }
+    }
+
+    /**
+     * @brief      Slot a piece moves to when the board is mirrored left to right.
+     */
+    inline int mirrorIndex(int index, int width) {
+        return index - 2 * (index % width) + width - 1;
+    }
+
+    /**
+     * @brief      Fills a table laid out like fillTable, with the values of the
+     * mirrored slots.
+     */
+    inline void fillMirrorTable(uint64_t* table, int width, int height) {
+        for (int i = 0; i < width * height; i++) {
+            table[2 * i] = slotKey(mirrorIndex(i, width), SlotStatus::Red);
+            table[2 * i + 1] = slotKey(mirrorIndex(i, width), SlotStatus::Yellow);
+        }
+    }
+
+    /**
+     * @brief      Canonical key from a key and its mirror key.
+     */
+    inline uint64_t canonicalKey(uint64_t key, uint64_t mirrorKey) {
+        return key < mirrorKey ? key : mirrorKey;
+    }
+
+    /**
+     * @brief      Key of a board computed from scratch.
+     */
+    inline uint64_t positionKey(const SlotStatus* board, int numSlots) {
+        uint64_t key = kEmptyKey;
+        for (int i = 0; i < numSlots; i++)
+            if (board[i] != SlotStatus::Empty) key ^= slotKey(i, board[i]);
+        return key;
+    }
+
+    /**
+     * @brief      Mirror key of a board computed from scratch.
+     */
+    inline uint64_t mirrorPositionKey(const SlotStatus* board, int width, int height) {
+        uint64_t key = kEmptyKey;
+        for (int i = 0; i < width * height; i++)
+            if (board[i] != SlotStatus::Empty) key ^= slotKey(mirrorIndex(i, width), board[i]);
+        return key;
+    }
+
+    /**
+     * @brief      Key of a score of the position for the given player.
+     */
+    inline uint64_t scoredKey(uint64_t key, Player player) {
+        return player == Player::Yellow ? key ^ kPlayerKey : key;
+    }
+
+    /**
+     * @brief      Key of a minimax node: the position, the player the scores
+     * are computed for and whether that player is the one to move.
+     */
+    inline uint64_t nodeKey(uint64_t key, Player player, bool maximizer) {
+        return scoredKey(key, player) ^ (maximizer ? kMaximizerKey : 0);
+    }
+}
+
+#endif
@@ -9,7 +9,9 @@
  */
 
 #include "cudaSolver.cuh"
+#include "connectFourAssets/evalWeights.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include "cublas_v2.h"
 
@@ -19,6 +21,13 @@
 // Current implementation seems to be limited to a depth of 6 because of memory requirements
 #define MAX_DEPTH 6
 
+// Below this many leaves the kernel launches and cuBLAS setup cost more than
+// scoring the boards on the host with the batch evaluator
+#define HOST_BATCH_MAX_LEAVES 4096
+
+// Leaves handed to the host batch evaluator per call
+#define HOST_BATCH_BLOCK 256
+
 // Error check macro
 // Based on https://github.com/NVIDIA-developer-blog/code-samples/blob/master/posts/tensor-cores/simpleTensorCoreGEMM.cu
 #define cudaErrCheck(stat) { cudaErrCheck_((stat), __FILE__, __LINE__); }
@@ -93,6 +102,11 @@ CudaSolver::CudaSolver(int width, int height, int winningStreakSize)
     for (int i = 0; i < _numStreams; i++) {
         cudaStreamCreate(&streams[i]);
     }
+
+    _hostEvaluator = nullptr;
+    if (BatchEvaluator::supportsGeometry(width, height, winningStreakSize)) {
+        _hostEvaluator = new BatchEvaluator(width, height, winningStreakSize);
+    }
 }
 
 CudaSolver::~CudaSolver() 
@@ -103,10 +117,12 @@ CudaSolver::~CudaSolver()
     } 
 
     delete[] streams;
+    delete _hostEvaluator;
 }
 
 int CudaSolver::solve(Player player, int maxDepth, double time_limit) 
 {
+	_lastColumn = -1;
     if (_board->DetermineWinner() != Player::None) {
         return -1;
     }
@@ -142,6 +158,7 @@ int CudaSolver::solve(Player player, int maxDepth, double time_limit)
 	if(bestMove > -1) {
 		_board->playMove(bestMove, SlotStatusHelpers::getSlotFromPlayer(player));
 		retval = bestMove % _board->getWidth();
+		_lastColumn = retval;
 	}
 
 	Player winner = _board->DetermineWinner();
@@ -174,7 +191,7 @@ int CudaSolver::EvaluateBoard(SlotStatus* board, Player player)
     double *h_y = new double[1];
     for (int strk_len = 0; strk_len < numStreakLengths; strk_len++) {
         for (int i = 0; i < numSlots*NUM_STREAK_DIR; i++) {
-            h_x[strk_len*numSlots*NUM_STREAK_DIR + i] = pow(strk_len+2, 3);
+            h_x[strk_len*numSlots*NUM_STREAK_DIR + i] = EvalWeights::streak(strk_len+2);
         }
     }
     h_y[0] = 0;
@@ -333,7 +350,7 @@ int CudaSolver::EvaluateBoards(const SlotStatus* concat_boards, const int numBoa
     cudaErrCheck( cudaMallocHost((void **)&h_x, entriesPerBoard*sizeof(double)) );
     for (int strk_len = 0; strk_len < numStreakLengths; strk_len++) {
         for (int i = 0; i < numSlots*NUM_STREAK_DIR; i++) {
-            h_x[strk_len*numSlots*NUM_STREAK_DIR + i] = pow(strk_len+2, 3);
+            h_x[strk_len*numSlots*NUM_STREAK_DIR + i] = EvalWeights::streak(strk_len+2);
         }
     }
 
@@ -442,6 +459,23 @@ int CudaSolver::EvaluateBoards(const SlotStatus* concat_boards, const int numBoa
     return 0;
 }
 
+void CudaSolver::evaluateBoardsOnHost(const std::vector<CudaSolver::boardAndPath>& endNodes, const Player player, double scores[])
+{
+    const int numSlots = _board->getWidth() * _board->getHeight();
+    const int numEndNodes = endNodes.size();
+    Position positions[HOST_BATCH_BLOCK];
+    int blockScores[HOST_BATCH_BLOCK];
+
+    for (int b = 0; b < numEndNodes; b += HOST_BATCH_BLOCK) {
+        int blockSize = std::min(HOST_BATCH_BLOCK, numEndNodes - b);
+        for (int n = 0; n < blockSize; n++) {
+            positions[n] = PositionHelpers::fromBoard(endNodes.at(b + n).board, numSlots, player);
+        }
+        _hostEvaluator->evaluateBatch(positions, blockSize, blockScores);
+        for (int n = 0; n < blockSize; n++) scores[b + n] = blockScores[n];
+    }
+}
+
 bool CudaSolver::isLegalMove(const SlotStatus *board, int width, int height, int index) 
 {
     if (board[index] != SlotStatus::Empty) return false;
@@ -566,36 +600,43 @@ int CudaSolver::findBestMove2(SlotStatus* board, Player player, int maxDepth)
     int numEndNodes = endNodes.size();
     _nodesTraversed = endNodes.size();
     int numSlots =  _board->getWidth() * _board->getHeight();
-    auto concatBoards = new SlotStatus[numEndNodes * numSlots];
 
     std::unordered_map<uint32_t, int> pathToIndex;
     for (int n = 0; n < numEndNodes; n++) {
-        for(int j = 0; j < numSlots; j++) concatBoards[n*numSlots + j] = endNodes.at(n).board[j];
-        // for (auto p : endNodes.at(n).path){
-        //     std::cout << p << ", ";
-        // }
-        // std::cout <<std::endl;
         pathToIndex[createPathMapping(&endNodes.at(n).path)] = n;
-        delete[] endNodes.at(n).board;
     }
 
     auto scores = new double[numEndNodes];
 
-    cudaEvent_t start;
-    cudaEvent_t stop;
-    cudaEventCreate(&start);
-    cudaEventCreate(&stop);
-    cudaEventRecord(start);
+    if (_hostEvaluator != nullptr && numEndNodes < HOST_BATCH_MAX_LEAVES) {
+        // Small leaf sets (the shallow iterations of iterative deepening) are
+        // scored on the host, which also catches wins the GPU streak count misses
+        evaluateBoardsOnHost(endNodes, player, scores);
+        for (int n = 0; n < numEndNodes; n++) delete[] endNodes.at(n).board;
+    } else {
+        auto concatBoards = new SlotStatus[numEndNodes * numSlots];
+        for (int n = 0; n < numEndNodes; n++) {
+            for(int j = 0; j < numSlots; j++) concatBoards[n*numSlots + j] = endNodes.at(n).board[j];
+            delete[] endNodes.at(n).board;
+        }
+
+        cudaEvent_t start;
+        cudaEvent_t stop;
+        cudaEventCreate(&start);
+        cudaEventCreate(&stop);
+        cudaEventRecord(start);
 
-    EvaluateBoards(concatBoards, numEndNodes, player, scores);
+        EvaluateBoards(concatBoards, numEndNodes, player, scores);
 
-    cudaEventRecord(stop);
-    cudaEventSynchronize(stop);
+        cudaEventRecord(stop);
+        cudaEventSynchronize(stop);
 
-    float ms;
-    cudaEventElapsedTime(&ms, start, stop);
-    // Uncoment to print GPU-intensive timing part
-    // std::cout << "time in GPU intense part: " << ms << std::endl;
+        float ms;
+        cudaEventElapsedTime(&ms, start, stop);
+        // Uncoment to print GPU-intensive timing part
+        // std::cout << "time in GPU intense part: " << ms << std::endl;
+        delete[] concatBoards;
+    }
 
     // std::cout << "scores ";
     // for (int as = 0; as < numEndNodes; as++) {
@@ -12,6 +12,7 @@
 
 #include "gameTreeSearchSolver.hpp"
 #include "connectFourAssets/slotStatus.hpp"
+#include "connectFourAssets/evalKernel.hpp"
 #include <vector>
 #include <unordered_map>
 
@@ -107,6 +108,20 @@ class CudaSolver : public GameTreeSearchSolver
         uint32_t _numStreams;
         void* _streams;
 
+        // Scores leaf sets that are too small to pay for the GPU launches,
+        // null if the geometry does not fit in a bitboard
+        BatchEvaluator* _hostEvaluator;
+
+        /**
+         * @brief      Scores the leaf boards on the host, feeding the batch
+         * evaluator in blocks.
+         *
+         * @param[in]  endNodes  The leaf boards
+         * @param[in]  player    The player
+         * @param      scores    Array to be filled with score for each board
+         */
+        void evaluateBoardsOnHost(const std::vector<CudaSolver::boardAndPath>& endNodes, const Player player, double scores[]);
+
         /** 
         * @deprecated  Use findBoards2 for full CUDA implementation.
         */
@@ -0,0 +1,436 @@
+#include "engine.hpp"
+#include "sequentialSolver/sequentialSolver.hpp"
+#include "exactSolver/exactSolver.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Engine
+{
+    // Feeds the handle of an asynchronous search from the worker running it
+    class AsyncSearch
+    {
+        public:
+            static std::shared_ptr<SearchHandle> create() {
+                std::shared_ptr<SearchHandle> handle(new SearchHandle);
+                handle->_current.status = Status::Searching;
+                return handle;
+            }
+
+            // Sets the function that stops the solver, or clears it with null
+            static void attach(SearchHandle& handle, std::function<void()> stop) {
+                std::lock_guard<std::mutex> lock(handle._mutex);
+                handle._stop = std::move(stop);
+                // A cancel() before the solver was set up stops it now
+                if (handle._stop && handle._cancelled) handle._stop();
+            }
+
+            static const std::atomic<bool>* cancelled(SearchHandle& handle) { return &handle._cancelled; }
+
+            static void report(SearchHandle& handle, const Result& result) {
+                std::lock_guard<std::mutex> lock(handle._mutex);
+                handle._current = result;
+            }
+
+            static void finish(SearchHandle& handle, const Result& result) {
+                {
+                    std::lock_guard<std::mutex> lock(handle._mutex);
+                    handle._result = result;
+                    handle._done = true;
+                    if (handle._cancelled)
+                        handle._cancelLatency = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - handle._cancelTime).count();
+                }
+                handle._ended.notify_all();
+            }
+    };
+}
+
+namespace
+{
+    // Board indexes its slots with 8 bit counters
+    constexpr int kMaxSlots = 255;
+
+    // One solver per thread and geometry, reused by the later queries of the
+    // thread. Every query sets up its own position on it.
+    template <typename Solver>
+    Solver& threadSolver(int width, int height, int winningStreakSize) {
+        struct Slot {
+            int width;
+            int height;
+            int winningStreakSize;
+            std::unique_ptr<Solver> solver;
+        };
+        thread_local std::vector<Slot> slots;
+        for (Slot& slot : slots) {
+            if (slot.width == width && slot.height == height &&
+                slot.winningStreakSize == winningStreakSize) return *slot.solver;
+        }
+        slots.push_back({width, height, winningStreakSize,
+                         std::make_unique<Solver>(width, height, winningStreakSize)});
+        return *slots.back().solver;
+    }
+
+    bool validQuery(int width, int height, int winningStreakSize, const Engine::Limits& limits) {
+        if (width < 1 || height < 1 || width * height > kMaxSlots || winningStreakSize < 2) return false;
+        if (limits.exact) return ExactSolver::supportsGeometry(width, height, winningStreakSize);
+        return limits.depth >= 1;
+    }
+
+    // Runs the asynchronous searches. Created by the first one and kept until
+    // the process exits, so searches still running then do not hold it up.
+    class WorkerPool
+    {
+        public:
+            static WorkerPool& instance() {
+                static WorkerPool* pool = new WorkerPool(std::max(1u, std::thread::hardware_concurrency()));
+                return *pool;
+            }
+
+            void submit(std::function<void()> task) {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _tasks.push_back(std::move(task));
+                }
+                _ready.notify_one();
+            }
+
+        private:
+            std::mutex _mutex;
+            std::condition_variable _ready;
+            std::deque<std::function<void()>> _tasks;
+
+            explicit WorkerPool(unsigned threads) {
+                for (unsigned i = 0; i < threads; i++) std::thread(&WorkerPool::work, this).detach();
+            }
+
+            void work() {
+                while (true) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(_mutex);
+                        _ready.wait(lock, [this] { return !_tasks.empty(); });
+                        task = std::move(_tasks.front());
+                        _tasks.pop_front();
+                    }
+                    task();
+                }
+            }
+    };
+
+    // Searches the position set up on the solver, reporting every completed
+    // depth to the handle of an asynchronous search
+    Engine::Result searchHeuristic(SequentialSolver& solver, int plies, const Engine::Limits& limits,
+                                   Engine::SearchHandle* handle) {
+        Engine::Result result;
+        if (solver.getWinner() != Player::None) {
+            result.status = Engine::Status::GameOver;
+            return result;
+        }
+        Player player = (plies % 2 == 0) ? Player::Red : Player::Yellow;
+        int score = 0;
+        if (handle) {
+            uint64_t nodes = 0;
+            solver.setSearchInfo([&](int depth, int depthScore, int column, uint64_t depthNodes) {
+                nodes += depthNodes;
+                Engine::Result completed;
+                completed.status = Engine::Status::Ok;
+                completed.column = column;
+                completed.score = depthScore;
+                completed.depth = depth;
+                completed.nodes = nodes;
+                Engine::AsyncSearch::report(*handle, completed);
+                return true;
+            });
+            Engine::AsyncSearch::attach(*handle, [&solver] { solver.stop(); });
+        }
+        result.column = solver.analyze(player, limits.depth, &score, limits.seconds);
+        if (handle) {
+            Engine::AsyncSearch::attach(*handle, nullptr);
+            solver.setSearchInfo(nullptr);
+        }
+        result.nodes = solver.getNodesTraversed();
+        if (result.column < 0) {
+            result.status = Engine::Status::GameOver;
+            return result;
+        }
+        result.status = Engine::Status::Ok;
+        result.score = score;
+        result.depth = solver.getSearchDepth();
+        return result;
+    }
+
+    Engine::Result searchExact(int width, int height, int winningStreakSize, const BitBoard& position,
+                               const Engine::Limits& limits, Engine::SearchHandle* handle) {
+        ExactSolver& solver = threadSolver<ExactSolver>(width, height, winningStreakSize);
+        if (handle) solver.setAbort(Engine::AsyncSearch::cancelled(*handle));
+        ExactSolver::Result solved = solver.solve(position, ExactSolver::Method::Auto, limits.nodes);
+        solver.setAbort(nullptr);
+        Engine::Result result;
+        result.nodes = solved.nodes;
+        if (!solved.solved) {
+            result.status = Engine::Status::Unsolved;
+            return result;
+        }
+        result.status = (solved.column < 0) ? Engine::Status::GameOver : Engine::Status::Ok;
+        result.column = solved.column;
+        result.score = solved.value;
+        result.depth = width * height - position.plies;
+        return result;
+    }
+
+    // Plays the moves on a bitboard, false if one is illegal. won is set when
+    // the last move won the game.
+    bool playMoves(const BitRules& rules, const char* moves, BitBoard& position, bool& won) {
+        won = false;
+        for (const char* m = moves; *m; m++) {
+            int c = *m - '1';
+            if (won || c < 0 || c >= rules.width()) return false;
+            uint64_t move = rules.possible(position) & rules.columnMask(c);
+            if (!move) return false;
+            won = rules.isWin(position.own | move);
+            rules.play(position, move);
+        }
+        return true;
+    }
+
+    // Solves the position after every legal move, the alpha-beta table
+    // carries over from one move to the next
+    Engine::Result solveColumns(int width, int height, int winningStreakSize, const BitBoard& position,
+                                const Engine::Limits& limits, std::vector<Engine::ColumnScore>& columns) {
+        ExactSolver& solver = threadSolver<ExactSolver>(width, height, winningStreakSize);
+        const BitRules& rules = solver.rules();
+        Engine::Result result;
+        for (int c = 0; c < width; c++) {
+            uint64_t move = rules.possible(position) & rules.columnMask(c);
+            if (!move) continue;
+            Engine::ColumnScore column;
+            column.column = c;
+            column.pv.push_back(c);
+            if (rules.isWin(position.own | move)) column.score = 1;
+            else {
+                BitBoard next = position;
+                rules.play(next, move);
+                ExactSolver::Result solved = solver.solve(next, ExactSolver::Method::Auto, limits.nodes);
+                result.nodes += solved.nodes;
+                if (!solved.solved) {
+                    columns.clear();
+                    result.status = Engine::Status::Unsolved;
+                    return result;
+                }
+                column.score = -solved.value;
+                if (solved.column >= 0) column.pv.push_back(solved.column);
+            }
+            columns.push_back(column);
+        }
+        std::stable_sort(columns.begin(), columns.end(),
+                         [](const Engine::ColumnScore& a, const Engine::ColumnScore& b) {
+                             return a.score > b.score;
+                         });
+        result.status = Engine::Status::Ok;
+        result.column = columns[0].column;
+        result.score = columns[0].score;
+        result.depth = width * height - position.plies;
+        return result;
+    }
+
+    // Searches the position after the moves, see Engine::search
+    Engine::Result query(int width, int height, int winningStreakSize, const char* moves,
+                         const Engine::Limits& limits, Engine::SearchHandle* handle) {
+        Engine::Result result;
+        if (!moves || !validQuery(width, height, winningStreakSize, limits)) return result;
+
+        if (limits.exact) {
+            // Played on bitboards, the exact solver takes the position as one
+            BitRules rules(width, height, winningStreakSize);
+            BitBoard position;
+            bool won;
+            if (!playMoves(rules, moves, position, won)) return result;
+            if (won) {
+                result.status = Engine::Status::GameOver;
+                return result;
+            }
+            return searchExact(width, height, winningStreakSize, position, limits, handle);
+        }
+
+        SequentialSolver& solver = threadSolver<SequentialSolver>(width, height, winningStreakSize);
+        solver.resetSolver();
+        int plies = solver.setPosition(moves);
+        if (plies < 0) return result;
+        return searchHeuristic(solver, plies, limits, handle);
+    }
+}
+
+Engine::Result Engine::search(int width, int height, int winningStreakSize, const char* moves,
+                              const Limits& limits)
+{
+    return query(width, height, winningStreakSize, moves, limits, nullptr);
+}
+
+Engine::Result Engine::searchColumns(int width, int height, int winningStreakSize, const char* moves,
+                                     const Limits& limits, std::vector<ColumnScore>& columns)
+{
+    columns.clear();
+    Result result;
+    if (!moves || !validQuery(width, height, winningStreakSize, limits)) return result;
+
+    if (limits.exact) {
+        BitRules rules(width, height, winningStreakSize);
+        BitBoard position;
+        bool won;
+        if (!playMoves(rules, moves, position, won)) return result;
+        if (won || position.plies == width * height) {
+            result.status = Status::GameOver;
+            return result;
+        }
+        return solveColumns(width, height, winningStreakSize, position, limits, columns);
+    }
+
+    SequentialSolver& solver = threadSolver<SequentialSolver>(width, height, winningStreakSize);
+    solver.resetSolver();
+    int plies = solver.setPosition(moves);
+    if (plies < 0) return result;
+    if (solver.getWinner() != Player::None) {
+        result.status = Status::GameOver;
+        return result;
+    }
+    std::vector<SequentialSolver::RootScore> scores;
+    Player player = (plies % 2 == 0) ? Player::Red : Player::Yellow;
+    result.column = solver.analyzeColumns(player, limits.depth, scores,
+                                          limits.columns > 0 ? limits.columns : INT_MAX);
+    result.nodes = solver.getNodesTraversed();
+    if (result.column < 0) {
+        result.status = Status::GameOver;
+        return result;
+    }
+    for (const SequentialSolver::RootScore& root : scores) {
+        ColumnScore column;
+        column.column = root.column;
+        column.score = root.score;
+        column.exact = root.bound == TranspositionTable::Bound::Exact;
+        column.pv = root.pv;
+        columns.push_back(column);
+    }
+    result.status = Status::Ok;
+    result.score = scores[0].score;
+    result.depth = limits.depth;
+    return result;
+}
+
+Engine::Result Engine::search(int width, int height, int winningStreakSize, const BitBoard& position,
+                              const Limits& limits)
+{
+    Result result;
+    if (!validQuery(width, height, winningStreakSize, limits) ||
+        !BitRules::supportsGeometry(width, height, winningStreakSize)) return result;
+
+    // Only slots of the board, stacked from the bottom of each column, with
+    // the player to move holding half of the pieces
+    BitRules rules(width, height, winningStreakSize);
+    uint64_t full = 0;
+    for (int c = 0; c < width; c++) {
+        uint64_t column = (position.mask & rules.columnMask(c)) >> (c * (height + 1));
+        if (column & (column + 1)) return result;
+        full |= rules.columnMask(c);
+    }
+    if ((position.mask & ~full) || (position.own & ~position.mask) ||
+        __builtin_popcountll(position.mask) != position.plies ||
+        __builtin_popcountll(position.own) != position.plies / 2) return result;
+
+    // The opponent made the last move, the player to move cannot have a line
+    if (rules.isWin(position.own)) return result;
+    if (rules.isWin(position.own ^ position.mask) || position.plies == width * height) {
+        result.status = Status::GameOver;
+        return result;
+    }
+
+    if (limits.exact) return searchExact(width, height, winningStreakSize, position, limits, nullptr);
+
+    const SlotStatus own = (position.plies % 2 == 0) ? SlotStatus::Red : SlotStatus::Yellow;
+    const SlotStatus other = (own == SlotStatus::Red) ? SlotStatus::Yellow : SlotStatus::Red;
+    SlotStatus slots[64];
+    for (int row = 0; row < height; row++) {
+        for (int c = 0; c < width; c++) {
+            uint64_t bit = uint64_t(1) << (c * (height + 1) + (height - 1 - row));
+            slots[row * width + c] = !(position.mask & bit) ? SlotStatus::Empty
+                                     : (position.own & bit) ? own : other;
+        }
+    }
+    SequentialSolver& solver = threadSolver<SequentialSolver>(width, height, winningStreakSize);
+    solver.resetSolver();
+    solver.setPosition(slots);
+    return searchHeuristic(solver, position.plies, limits, nullptr);
+}
+
+std::shared_ptr<Engine::SearchHandle> Engine::solveAsync(int width, int height, int winningStreakSize,
+                                                         const char* moves, const Limits& limits)
+{
+    std::shared_ptr<SearchHandle> handle = AsyncSearch::create();
+    Limits deepening = limits;
+    // Deepens iteratively even without a time limit, one completed depth at
+    // a time is what current() and cancel() give back
+    if (deepening.seconds <= 0) deepening.seconds = 1e9;
+    std::string position = moves ? moves : "";
+    bool valid = moves != nullptr;
+    WorkerPool::instance().submit([=] {
+        Result result;
+        if (valid) result = query(width, height, winningStreakSize, position.c_str(), deepening, handle.get());
+        AsyncSearch::finish(*handle, result);
+    });
+    return handle;
+}
+
+Engine::Result Engine::SearchHandle::wait()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _ended.wait(lock, [this] { return _done; });
+    return _result;
+}
+
+bool Engine::SearchHandle::waitFor(double seconds)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _ended.wait_for(lock, std::chrono::duration<double>(std::max(seconds, 0.0)), [this] { return _done; });
+}
+
+bool Engine::SearchHandle::done() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _done;
+}
+
+Engine::Result Engine::SearchHandle::current() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _done ? _result : _current;
+}
+
+void Engine::SearchHandle::cancel()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_done || _cancelled) return;
+    _cancelTime = std::chrono::steady_clock::now();
+    _cancelled = true;
+    if (_stop) _stop();
+}
+
+double Engine::SearchHandle::cancelLatency() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _cancelLatency;
+}
+
+const char* Engine::statusName(Status status)
+{
+    switch (status) {
+        case Status::Ok: return "ok";
+        case Status::GameOver: return "game over";
+        case Status::Unsolved: return "unsolved";
+        case Status::Searching: return "searching";
+        default: return "invalid position";
+    }
+}
@@ -0,0 +1,205 @@
+/**
+ * @defgroup   ENGINE
+ *
+ * @brief      Stateless entry point for embedding the engine. A query takes a
+ * position and search limits and returns the best move, its score, the depth
+ * searched and the node count. Nothing of one query is visible to the next,
+ * so any number of threads can query at the same time.
+ *
+ * Each thread keeps one solver per geometry it has seen and sets up every
+ * position on it from scratch, so a query allocates nothing once its thread
+ * has warmed up. The solver's transposition table is cleared for every query
+ * (the same move and score come out either way, only the node count would
+ * depend on earlier queries); with --tt-keep it is aged instead. The
+ * process-wide settings of EvalConfig apply to every query and should be set
+ * before the first one.
+ *
+ * solveAsync runs a query on a process-wide pool of workers, one per hardware
+ * thread, and returns a handle at once. The handle gives the result of the
+ * deepest completed depth while the search goes on, and cancel() ends the
+ * search early with that result. The heuristic search checks its stop flag at
+ * every node and the exact solver every AlphaBetaSolver::kAbortNodes nodes, so a cancelled
+ * query ends within about a node's evaluation (see --bench-cancel).
+ *
+ * @date       2021
+ */
+#ifndef __ENGINE__
+#define __ENGINE__
+
+#include "exactSolver/bitRules.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Engine
+{
+    enum class Status {
+        Ok,
+        // The game is decided or the board is full, there is no move
+        GameOver,
+        // Bad geometry or limits, an illegal move, or an impossible bitboard
+        InvalidPosition,
+        // The exact solver reached its node limit, or was cancelled
+        Unsolved,
+        // An asynchronous search has not completed a depth yet
+        Searching
+    };
+
+    struct Limits {
+        // Deepest search in plies
+        int depth = 8;
+        // Deepens iteratively up to depth within the time when positive
+        double seconds = -1;
+        // Solves the game to the end with the exact solver instead, see
+        // ExactSolver::supportsGeometry
+        bool exact = false;
+        // Nodes after which the exact solver gives up, 0 for no limit
+        uint64_t nodes = 0;
+        // Moves searchColumns scores exactly under the pruning drivers, the
+        // others get an upper bound; 0 for all of them
+        int columns = 0;
+    };
+
+    struct Result {
+        Status status = Status::InvalidPosition;
+        // Column (0 based) of the best move, -1 if there is none
+        int column = -1;
+        // Score for the player to move: the heuristic score of the search
+        // (INT_MAX for a win within the depth, INT_MIN for a loss), or 1, 0
+        // and -1 for an exact win, draw and loss
+        int score = 0;
+        // Plies searched, the plies left in the game for exact results
+        int depth = 0;
+        uint64_t nodes = 0;
+    };
+
+    /**
+     * @brief      Searches the position after a move sequence.
+     *
+     * @param[in]  width              The width of the board
+     * @param[in]  height             The height of the board
+     * @param[in]  winningStreakSize  The winning streak size
+     * @param[in]  moves              The columns of the moves as 1 based
+     * digits from the empty board, Red moving first
+     * @param[in]  limits             The limits
+     *
+     * @return     The result
+     */
+    Result search(int width, int height, int winningStreakSize, const char* moves,
+                  const Limits& limits);
+
+    // Score of one move in searchColumns
+    struct ColumnScore {
+        // Column (0 based) of the move
+        int column = -1;
+        // Score for the player to move, as in Result
+        int score = 0;
+        // False when the score only bounds the value from above
+        bool exact = true;
+        // Columns (0 based) of the line from the move on. The exact solver
+        // gives the move and the best reply only.
+        std::vector<int> pv;
+    };
+
+    /**
+     * @brief      Scores every legal move of the position after the moves in
+     * one search (multi-PV), see search for the parameters.
+     *
+     * @param      columns  Set to the scores of the moves, best first
+     *
+     * @return     The result of the best move, as search would give it
+     */
+    Result searchColumns(int width, int height, int winningStreakSize, const char* moves,
+                         const Limits& limits, std::vector<ColumnScore>& columns);
+
+    /**
+     * @brief      Searches a packed position, see BitRules for the layout. The
+     * player to move follows from the plies, Red moves on even plies.
+     */
+    Result search(int width, int height, int winningStreakSize, const BitBoard& position,
+                  const Limits& limits);
+
+    const char* statusName(Status status);
+
+    class AsyncSearch;
+
+    /**
+     * @brief      A search started by solveAsync. Every method can be called
+     * from any thread.
+     */
+    class SearchHandle
+    {
+        public:
+            /**
+             * @brief      Blocks until the search ends.
+             *
+             * @return     The result, that of the deepest completed depth if
+             * the search was cancelled
+             */
+            Result wait();
+
+            /**
+             * @brief      Blocks until the search ends or the time is up.
+             *
+             * @return     True if the search has ended
+             */
+            bool waitFor(double seconds);
+
+            bool done() const;
+
+            /**
+             * @brief      The result of the deepest depth completed so far,
+             * Status::Searching before the first one, the final result once
+             * the search has ended.
+             */
+            Result current() const;
+
+            /**
+             * @brief      Ends the search early. Does nothing once it has
+             * ended.
+             */
+            void cancel();
+
+            /**
+             * @brief      Milliseconds from cancel() to the end of the search,
+             * -1 if it was not cancelled or has not ended yet.
+             */
+            double cancelLatency() const;
+
+        private:
+            friend class AsyncSearch;
+
+            SearchHandle() = default;
+
+            mutable std::mutex _mutex;
+            std::condition_variable _ended;
+            Result _current;
+            Result _result;
+            bool _done = false;
+            // Read by the exact solver while it searches
+            std::atomic<bool> _cancelled{false};
+            // Stops the solver of the search, set while it runs
+            std::function<void()> _stop;
+            std::chrono::steady_clock::time_point _cancelTime;
+            double _cancelLatency = -1;
+    };
+
+    /**
+     * @brief      Starts a search on the worker pool, see search for the
+     * parameters. Heuristic searches deepen iteratively up to limits.depth,
+     * within limits.seconds when positive, so that there is a result to
+     * poll; they find the same move and score as search at the final depth.
+     *
+     * @return     The handle of the search
+     */
+    std::shared_ptr<SearchHandle> solveAsync(int width, int height, int winningStreakSize, const char* moves,
+                                             const Limits& limits);
+}
+
+#endif
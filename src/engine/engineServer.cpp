@@ -0,0 +1,240 @@
+#include "engineServer.hpp"
+#include "exactSolver/solvedStore.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+    // Longest request line, longer ones close the connection
+    constexpr size_t kMaxLine = 4096;
+
+    bool sendAll(int fd, const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            sent += n;
+        }
+        return true;
+    }
+}
+
+EngineServer::EngineServer(int width, int height, int winningStreakSize, const Engine::Limits& limits,
+                           int workers):
+                           _width(width), _height(height), _winningStreakSize(winningStreakSize),
+                           _limits(limits), _stopping(false), _requests(0), _errors(0), _maxQueue(0),
+                           _nextLatency(0) {
+    for (int i = 0; i < std::max(workers, 1); i++)
+        _workers.emplace_back(&EngineServer::work, this);
+}
+
+EngineServer::~EngineServer() {
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        _stopping = true;
+    }
+    _queueReady.notify_all();
+    for (std::thread& worker : _workers) worker.join();
+}
+
+void EngineServer::work() {
+    while (true) {
+        Job* job;
+        {
+            std::unique_lock<std::mutex> lock(_queueMutex);
+            _queueReady.wait(lock, [this] { return _stopping || !_queue.empty(); });
+            if (_queue.empty()) return;
+            job = _queue.front();
+            _queue.pop_front();
+        }
+        Engine::Result result = job->columns
+            ? Engine::searchColumns(_width, _height, _winningStreakSize, job->moves.c_str(), job->limits,
+                                    job->scores)
+            : Engine::search(_width, _height, _winningStreakSize, job->moves.c_str(), job->limits);
+        // The job dies with its connection's wait, the promise outlives it
+        std::promise<Engine::Result> promise = std::move(job->result);
+        promise.set_value(result);
+    }
+}
+
+std::string EngineServer::handle(const std::string& request) {
+    std::istringstream in(request);
+    std::string command;
+    in >> command;
+    if (command == "stats") return this->stats();
+    if (command != "analyze" && command != "columns") return "error unknown request";
+
+    Job job;
+    job.arrival = std::chrono::steady_clock::now();
+    job.limits = _limits;
+    job.columns = command == "columns";
+    std::string word;
+    if (in >> word && word != "-") job.moves = word;
+    if (in >> word) job.limits.depth = atoi(word.c_str());
+    if (in >> word) {
+        if (job.columns) job.limits.columns = atoi(word.c_str());
+        else job.limits.seconds = atof(word.c_str());
+    }
+    // A request cannot keep a worker longer than the server allows, searches
+    // deeper than the rest of the game find nothing new
+    const int remaining = _width * _height - (int)job.moves.size();
+    if (remaining > 0) job.limits.depth = std::min(job.limits.depth, remaining);
+    const double maxSeconds = _limits.seconds > 0 ? _limits.seconds : kMaxSeconds;
+    if (job.limits.seconds <= 0 || job.limits.seconds > maxSeconds) job.limits.seconds = maxSeconds;
+
+    std::future<Engine::Result> pending = job.result.get_future();
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        _queue.push_back(&job);
+        std::lock_guard<std::mutex> statsLock(_statsMutex);
+        _maxQueue = std::max(_maxQueue, _queue.size());
+    }
+    _queueReady.notify_one();
+    Engine::Result result = pending.get();
+
+    double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                              job.arrival).count();
+    this->recordLatency(millis, result.status != Engine::Status::Ok);
+    std::ostringstream out;
+    if (result.status != Engine::Status::Ok) out << "error " << Engine::statusName(result.status);
+    else out << "ok " << result.column + 1 << " " << result.score << " " << result.depth << " "
+             << result.nodes << " " << millis;
+    for (const Engine::ColumnScore& column : job.scores) {
+        out << " " << column.column + 1 << ":" << (column.exact ? "" : "<=") << column.score << ":";
+        for (int move : column.pv) out << move + 1;
+    }
+    return out.str();
+}
+
+void EngineServer::recordLatency(double millis, bool error) {
+    std::lock_guard<std::mutex> lock(_statsMutex);
+    ++_requests;
+    if (error) ++_errors;
+    if (_latencies.size() < kLatencyWindow) _latencies.push_back(millis);
+    else _latencies[_nextLatency] = millis;
+    _nextLatency = (_nextLatency + 1) % kLatencyWindow;
+}
+
+std::string EngineServer::stats() {
+    size_t queued;
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        queued = _queue.size();
+    }
+    std::vector<double> latencies;
+    std::ostringstream out;
+    {
+        std::lock_guard<std::mutex> lock(_statsMutex);
+        latencies = _latencies;
+        out << "stats requests " << _requests << " errors " << _errors << " queue " << queued
+            << " max_queue " << _maxQueue << " workers " << _workers.size();
+    }
+    double mean = 0, p50 = 0, p99 = 0, max = 0;
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        for (double latency : latencies) mean += latency;
+        mean /= latencies.size();
+        p50 = latencies[latencies.size() / 2];
+        p99 = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+        max = latencies.back();
+    }
+    out << " latency_ms mean " << mean << " p50 " << p50 << " p99 " << p99 << " max " << max;
+    SolvedStore& store = SolvedStore::shared();
+    if (store.isOpen())
+        out << " store_hits " << store.hits() << " store_probes " << store.probes() << " store_size "
+            << store.size();
+    return out.str();
+}
+
+void EngineServer::serveConnection(int fd) {
+    std::string buffer;
+    char chunk[1024];
+    while (true) {
+        size_t end;
+        while ((end = buffer.find('\n')) == std::string::npos) {
+            if (buffer.size() > kMaxLine) {
+                close(fd);
+                return;
+            }
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                close(fd);
+                return;
+            }
+            buffer.append(chunk, n);
+        }
+        std::string request = buffer.substr(0, end);
+        buffer.erase(0, end + 1);
+        if (!request.empty() && request.back() == '\r') request.pop_back();
+        if (request == "quit") break;
+        if (request.empty()) continue;
+        if (!sendAll(fd, this->handle(request) + "\n")) break;
+    }
+    close(fd);
+}
+
+int EngineServer::listenAndServe(int fd) {
+    if (listen(fd, SOMAXCONN) < 0) {
+        std::cerr << "[SERVER] listen failed: " << strerror(errno) << std::endl;
+        close(fd);
+        return -1;
+    }
+    while (true) {
+        int client = accept(fd, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            std::cerr << "[SERVER] accept failed: " << strerror(errno) << std::endl;
+            close(fd);
+            return -1;
+        }
+        std::thread(&EngineServer::serveConnection, this, client).detach();
+    }
+}
+
+int EngineServer::serveUnix(const std::string& path) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "[SERVER] Socket path too long: " << path << std::endl;
+        return -1;
+    }
+    strcpy(address.sun_path, path.c_str());
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path.c_str());
+    if (fd < 0 || bind(fd, (sockaddr*)&address, sizeof(address)) < 0) {
+        std::cerr << "[SERVER] Cannot bind " << path << ": " << strerror(errno) << std::endl;
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    std::cerr << "[SERVER] Listening on " << path << " with " << _workers.size() << " workers" << std::endl;
+    return this->listenAndServe(fd);
+}
+
+int EngineServer::serveTcp(int port) {
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    if (fd >= 0) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (fd < 0 || bind(fd, (sockaddr*)&address, sizeof(address)) < 0) {
+        std::cerr << "[SERVER] Cannot bind 127.0.0.1:" << port << ": " << strerror(errno) << std::endl;
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    std::cerr << "[SERVER] Listening on 127.0.0.1:" << port << " with " << _workers.size() << " workers"
+              << std::endl;
+    return this->listenAndServe(fd);
+}
@@ -0,0 +1,133 @@
+/**
+ * @defgroup   ENGINE_SERVER
+ *
+ * @brief      Long running engine behind a local socket, a Unix domain socket
+ * or a TCP port on 127.0.0.1. Clients send one request per line and get one
+ * line back:
+ *
+ *     analyze [moves] [depth] [seconds]
+ *         ok <column> <score> <depth> <nodes> <ms>, or error <status>
+ *         The moves are 1 based digits ("-" or nothing for the empty board),
+ *         depth and seconds default to the server limits. The depth is
+ *         capped at the plies left in the game, and the seconds at the
+ *         server's time limit, kMaxSeconds if it has none. The column is 1
+ *         based, the score is for the player to move (see Engine::Result).
+ *     columns [moves] [depth] [exact]
+ *         ok <column> <score> <depth> <nodes> <ms> <column>:<score>:<pv> ...
+ *         Scores every legal move in one search (Engine::searchColumns),
+ *         best first. The pv is the line from the move as 1 based digits, an
+ *         upper bound shows as <=<score>. exact is Limits::columns, all moves
+ *         by default. The depth is capped like for analyze.
+ *     stats
+ *         stats requests <n> errors <n> queue <n> max_queue <n> workers <n>
+ *         latency_ms mean <x> p50 <x> p99 <x> max <x>
+ *         [store_hits <n> store_probes <n> store_size <n>]
+ *         Latencies run from the arrival of a request to its answer, over
+ *         the last kLatencyWindow requests. The store counts are those of the
+ *         solved store (--solved-store) when one is open.
+ *     quit
+ *         Closes the connection.
+ *
+ * Every connection has a thread that reads its requests and waits for the
+ * answers, the searches run on a fixed pool of workers that take requests
+ * from one queue, whatever connection they came from. The workers keep their
+ * solvers (Engine) between requests, and with --tt-keep (which --serve turns
+ * on) the transposition tables are aged instead of cleared, so later
+ * requests start from a warm table and cache. A deeper entry an earlier
+ * request left can answer a shallower probe, so an answer may differ from
+ * the one of a cold solver.
+ *
+ * @date       2021
+ */
+#ifndef __ENGINE_SERVER__
+#define __ENGINE_SERVER__
+
+#include "engine.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class EngineServer
+{
+    public:
+        // Requests the latency statistics are computed over
+        static constexpr int kLatencyWindow = 4096;
+        // Longest analyze request when the server has no time limit
+        static constexpr double kMaxSeconds = 10;
+
+        /**
+         * @brief      Constructs a new instance and starts the workers.
+         *
+         * @param[in]  width              The width of the board
+         * @param[in]  height             The height of the board
+         * @param[in]  winningStreakSize  The winning streak size
+         * @param[in]  limits             The default limits of a request
+         * @param[in]  workers            The number of searching threads
+         */
+        EngineServer(int width, int height, int winningStreakSize, const Engine::Limits& limits,
+                     int workers);
+        ~EngineServer();
+
+        /**
+         * @brief      Serves on a Unix domain socket, replacing a stale socket
+         * file. Returns only if the socket cannot be set up.
+         *
+         * @return     -1 on failure
+         */
+        int serveUnix(const std::string& path);
+
+        /**
+         * @brief      Serves on a TCP port of 127.0.0.1, see serveUnix.
+         */
+        int serveTcp(int port);
+
+        /**
+         * @brief      Answers one request line, as a connection would.
+         */
+        std::string handle(const std::string& request);
+
+    private:
+        struct Job {
+            std::string moves;
+            Engine::Limits limits;
+            // A columns request, the worker fills in the scores
+            bool columns = false;
+            std::vector<Engine::ColumnScore> scores;
+            std::chrono::steady_clock::time_point arrival;
+            std::promise<Engine::Result> result;
+        };
+
+        const int _width;
+        const int _height;
+        const int _winningStreakSize;
+        const Engine::Limits _limits;
+
+        std::mutex _queueMutex;
+        std::condition_variable _queueReady;
+        std::deque<Job*> _queue;
+        bool _stopping;
+        std::vector<std::thread> _workers;
+
+        // Guarded by _statsMutex
+        std::mutex _statsMutex;
+        uint64_t _requests;
+        uint64_t _errors;
+        size_t _maxQueue;
+        std::vector<double> _latencies;
+        size_t _nextLatency;
+
+        void work();
+        int listenAndServe(int fd);
+        void serveConnection(int fd);
+        void recordLatency(double millis, bool error);
+        std::string stats();
+};
+
+#endif
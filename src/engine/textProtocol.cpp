@@ -0,0 +1,139 @@
+#include "textProtocol.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+
+TextProtocol::TextProtocol(int width, int height, int winningStreakSize, int maxDepth):
+                           _width(width), _height(height), _winningStreakSize(winningStreakSize),
+                           _maxDepth(maxDepth), _solver(width, height, winningStreakSize),
+                           _stopRequested(false), _out(&std::cout) {
+}
+
+TextProtocol::~TextProtocol() {
+    this->stopSearch();
+}
+
+void TextProtocol::run(std::istream& in, std::ostream& out) {
+    _out = &out;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream args(line);
+        std::string command;
+        if (!(args >> command)) continue;
+        if (command == "engine") {
+            std::ostringstream geometry;
+            geometry << "id geometry " << _width << " " << _height << " " << _winningStreakSize;
+            this->say("id name ConnectFour");
+            this->say(geometry.str());
+            this->say("engineok");
+        }
+        else if (command == "isready") this->say("readyok");
+        else if (command == "newgame") {
+            this->stopSearch();
+            _solver.resetSolver();
+            _moves.clear();
+            _moveWords.clear();
+        }
+        else if (command == "position") this->position(args);
+        else if (command == "go") this->go(args);
+        else if (command == "stop") this->stopSearch();
+        else if (command == "quit") break;
+        else this->say("info string unknown command " + command);
+    }
+    this->stopSearch();
+}
+
+void TextProtocol::position(std::istringstream& args) {
+    this->stopSearch();
+    _moves.clear();
+    _moveWords.clear();
+    std::string word;
+    while (args >> word) {
+        if (word == "startpos" || word == "moves") continue;
+        _moveWords += (_moveWords.empty() ? "" : " ") + word;
+        // Boards up to 9 wide have no two digit columns, a word of several
+        // digits is one move per digit there
+        if (_width <= 9 && word.size() > 1) {
+            _moves += word;
+            continue;
+        }
+        char* end;
+        long column = std::strtol(word.c_str(), &end, 10);
+        // Column 0 is illegal, setPosition rejects the moves
+        if (*end || column < 1 || column > _width) column = 0;
+        _moves += (char)('0' + column);
+    }
+}
+
+void TextProtocol::go(std::istringstream& args) {
+    this->stopSearch();
+    int depth = 0;
+    double movetime = 0;
+    bool infinite = false;
+    std::string word;
+    while (args >> word) {
+        if (word == "depth" && args >> depth) continue;
+        if (word == "movetime" && args >> movetime) continue;
+        if (word == "infinite") infinite = true;
+    }
+    // Without limits the search stops at the default depth
+    if (!depth) depth = (infinite || movetime > 0) ? INT_MAX : _maxDepth;
+
+    // Every search starts from the position, solve() plays its move
+    int plies = _solver.setPosition(_moves.c_str());
+    if (plies < 0) {
+        this->say("info string illegal moves " + _moveWords);
+        this->say("bestmove none");
+        return;
+    }
+    if (_solver.getWinner() != Player::None || plies == _width * _height) {
+        this->say("bestmove none");
+        return;
+    }
+
+    const Player player = (plies % 2 == 0) ? Player::Red : Player::Yellow;
+    const int remaining = _width * _height - plies;
+    const double seconds = (movetime > 0 && !infinite) ? movetime / 1000 : 1e9;
+    // Cleared here rather than on the search thread, a stop that comes
+    // before the thread gets going still ends the search
+    _stopRequested = false;
+    _solver.clearStop();
+    _search = std::thread([this, player, depth, remaining, seconds] {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t nodes = 0;
+        _solver.setSearchInfo([&](int searched, int score, int column, uint64_t depthNodes) {
+            nodes += depthNodes;
+            double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                                      start).count();
+            std::ostringstream info;
+            info << "info depth " << searched << " score ";
+            if (score == INT_MAX) info << "win";
+            else if (score == INT_MIN) info << "loss";
+            else info << score;
+            info << " nodes " << nodes << " nps " << (uint64_t)(nodes * 1000 / std::max(millis, 1.0))
+                 << " time " << (uint64_t)millis << " pv";
+            for (int move : _solver.bestLine(player, searched, column, score)) info << " " << move + 1;
+            this->say(info.str());
+            // Deeper than the rest of the game finds nothing new
+            return searched < depth && searched < remaining && !_stopRequested;
+        });
+        _solver.solve(player, depth, seconds);
+        _solver.setSearchInfo(nullptr);
+        int column = _solver.getLastColumn();
+        this->say(column < 0 ? std::string("bestmove none") : "bestmove " + std::to_string(column + 1));
+    });
+}
+
+void TextProtocol::stopSearch() {
+    if (!_search.joinable()) return;
+    _stopRequested = true;
+    _solver.stop();
+    _search.join();
+}
+
+void TextProtocol::say(const std::string& line) {
+    std::lock_guard<std::mutex> lock(_outputMutex);
+    *_out << line << std::endl;
+}
@@ -0,0 +1,88 @@
+/**
+ * @defgroup   TEXT_PROTOCOL
+ *
+ * @brief      Line based engine protocol on stdin and stdout, for game
+ * managers that run engines as child processes. Commands:
+ *
+ *     engine                   id name / id geometry <w> <h> <k> / engineok
+ *     isready                  readyok
+ *     newgame                  forgets the tables of the last game
+ *     position [startpos] [moves <column> ...]
+ *                              the position after the moves (1 based
+ *                              columns, Red first). Boards up to 9 wide also
+ *                              take the moves as one word of digits, like
+ *                              "position 4453".
+ *     go [depth <d>] [movetime <ms>] [infinite]
+ *                              searches the position, without limits to the
+ *                              default depth
+ *     stop                     ends the search with its best move so far
+ *     quit
+ *
+ * A search answers with an info line per completed depth and a bestmove line
+ * (1 based column, "none" when the game is over):
+ *
+ *     info depth <d> score <s|win|loss> nodes <n> nps <n> time <ms> pv <column> ...
+ *     bestmove <column>
+ *
+ * Searches run solve() of the sequential solver on a thread of their own, so
+ * stop and isready are answered while it searches. Depths grow in steps of
+ * two like in the games, so a depth limit can be passed by one ply. The
+ * tables keep values and no moves, so the principal variation is searched
+ * again after each depth (SequentialSolver::bestLine).
+ *
+ * @date       2021
+ */
+#ifndef __TEXT_PROTOCOL__
+#define __TEXT_PROTOCOL__
+
+#include "sequentialSolver/sequentialSolver.hpp"
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+class TextProtocol
+{
+    public:
+        /**
+         * @brief      Constructs a new instance.
+         *
+         * @param[in]  width              The width of the board
+         * @param[in]  height             The height of the board
+         * @param[in]  winningStreakSize  The winning streak size
+         * @param[in]  maxDepth           The depth of a go without limits
+         */
+        TextProtocol(int width, int height, int winningStreakSize, int maxDepth);
+        ~TextProtocol();
+
+        /**
+         * @brief      Answers commands until quit or the end of the input.
+         */
+        void run(std::istream& in, std::ostream& out);
+
+    private:
+        const int _width;
+        const int _height;
+        const int _winningStreakSize;
+        const int _maxDepth;
+        SequentialSolver _solver;
+        // The moves of the last position command, one character per move
+        // ('1' + column) as setPosition reads them, and as they were sent
+        std::string _moves;
+        std::string _moveWords;
+        std::thread _search;
+        std::atomic<bool> _stopRequested;
+        // Info lines come from the search thread, answers from the reader
+        std::mutex _outputMutex;
+        std::ostream* _out;
+
+        void position(std::istringstream& args);
+        void go(std::istringstream& args);
+        void stopSearch();
+        void say(const std::string& line);
+};
+
+#endif
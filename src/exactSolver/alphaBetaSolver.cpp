@@ -0,0 +1,92 @@
+#include "alphaBetaSolver.hpp"
+
+AlphaBetaSolver::AlphaBetaSolver(const BitRules& rules, size_t tableKb):
+                                 _rules(rules), _nodes(0), _nodeLimit(0), _abort(nullptr), _stalled(false) {
+    size_t entries = tableKb * 1024 / sizeof(Entry);
+    _table.assign(entries ? entries : 1, Entry{0, -1, 1});
+}
+
+int AlphaBetaSolver::solve(const BitBoard& position, uint64_t nodeLimit, int& column) {
+    _nodes = 0;
+    _nodeLimit = nodeLimit;
+    _stalled = false;
+
+    uint64_t wins = _rules.winningSpots(position.own, position.mask) & _rules.possible(position);
+    if(wins) {
+        column = _rules.column(wins & -wins);
+        return 1;
+    }
+    uint64_t moves = _rules.nonLosingMoves(position);
+    if(!moves) {
+        // Every move loses, play any of them
+        column = _rules.column(_rules.possible(position) & -_rules.possible(position));
+        return -1;
+    }
+
+    // The root keeps searching after a draw to find a win
+    uint64_t ordered[64];
+    int count = _rules.orderMoves(position, moves, ordered);
+    int best = -2;
+    for(int i = 0; i < count; i++) {
+        BitBoard next = position;
+        _rules.play(next, ordered[i]);
+        int value = -negamax(next, -1, best < -1 ? 1 : -best);
+        if(_stalled) return kStalled;
+        if(value > best) {
+            best = value;
+            column = _rules.column(ordered[i]);
+            if(best == 1) break;
+        }
+    }
+    return best;
+}
+
+int AlphaBetaSolver::negamax(const BitBoard& position, int alpha, int beta) {
+    if((_nodeLimit && _nodes >= _nodeLimit) ||
+       (_abort && _nodes % kAbortNodes == 0 && _abort->load(std::memory_order_relaxed))) {
+        _stalled = true;
+        return 0;
+    }
+    ++_nodes;
+
+    // Reached from a root with one empty slot
+    if(position.plies == _rules.numSlots()) return 0;
+    if(_rules.canWinNow(position)) return 1;
+    uint64_t moves = _rules.nonLosingMoves(position);
+    if(!moves) return -1;
+    // The opponent gets at most the last move, and it cannot win with it
+    if(position.plies >= _rules.numSlots() - 2) return 0;
+
+    const uint64_t key = _rules.key(position);
+    Entry& cached = entry(key);
+    if(cached.key == key) {
+        if(cached.lower >= beta) return cached.lower;
+        if(cached.upper <= alpha) return cached.upper;
+        if(cached.lower > alpha) alpha = cached.lower;
+        if(cached.upper < beta) beta = cached.upper;
+        if(alpha >= beta) return alpha;
+    }
+
+    uint64_t ordered[64];
+    int count = _rules.orderMoves(position, moves, ordered);
+    const int alphaOrig = alpha;
+    for(int i = 0; i < count; i++) {
+        BitBoard next = position;
+        _rules.play(next, ordered[i]);
+        int value = -negamax(next, -beta, -alpha);
+        if(_stalled) return 0;
+        if(value >= beta) {
+            Entry& slot = entry(key);
+            if(slot.key != key) slot = Entry{key, -1, 1};
+            slot.lower = value;
+            return value;
+        }
+        if(value > alpha) alpha = value;
+    }
+
+    Entry& slot = entry(key);
+    if(slot.key != key) slot = Entry{key, -1, 1};
+    if(alpha > alphaOrig) slot.lower = alpha;
+    slot.upper = alpha;
+    return alpha;
+}
@@ -0,0 +1,75 @@
+/**
+ * @defgroup   ALPHA_BETA_SOLVER
+ *
+ * @brief      Exact win/draw/loss solver. A negamax search with alpha-beta
+ * pruning over the values -1, 0 and 1, which never stops at a depth horizon.
+ * Moves that hand the opponent a win are never searched, the remaining ones
+ * are tried by the number of threats they create. Bounds found for a
+ * position are kept in a direct mapped table.
+ *
+ * @date       2021
+ */
+#ifndef __ALPHA_BETA_SOLVER__
+#define __ALPHA_BETA_SOLVER__
+
+#include "bitRules.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class AlphaBetaSolver
+{
+    public:
+        /**
+         * @brief      Constructs a new instance.
+         *
+         * @param[in]  rules    The rules of the geometry
+         * @param[in]  tableKb  The size of the bound table in KB
+         */
+        AlphaBetaSolver(const BitRules& rules, size_t tableKb);
+
+        /**
+         * @brief      Solves a position that is not decided yet.
+         *
+         * @param[in]  position   The position
+         * @param[in]  nodeLimit  Nodes after which the search gives up, 0 for
+         * no limit
+         * @param      column     Set to a column that keeps the value
+         *
+         * @return     1 if the player to move wins, 0 for a draw, -1 if it
+         * loses, kStalled if the node limit was reached
+         */
+        int solve(const BitBoard& position, uint64_t nodeLimit, int& column);
+
+        uint64_t nodes() const { return _nodes; }
+
+        /**
+         * @brief      Makes the searches give up like at the node limit once
+         * the flag is set, null for none. Checked every kAbortNodes nodes.
+         */
+        void setAbort(const std::atomic<bool>* abort) { _abort = abort; }
+
+        static constexpr int kStalled = 2;
+        static constexpr uint64_t kAbortNodes = 1024;
+
+    private:
+        struct Entry {
+            uint64_t key;
+            int8_t lower;
+            int8_t upper;
+        };
+
+        const BitRules& _rules;
+        std::vector<Entry> _table;
+        uint64_t _nodes;
+        uint64_t _nodeLimit;
+        const std::atomic<bool>* _abort;
+        bool _stalled;
+
+        int negamax(const BitBoard& position, int alpha, int beta);
+        Entry& entry(uint64_t key) { return _table[(key * 0x9E3779B97F4A7C15ULL) % _table.size()]; }
+};
+
+#endif
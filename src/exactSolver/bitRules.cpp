@@ -0,0 +1,123 @@
+#include "bitRules.hpp"
+
+BitRules::BitRules(int width, int height, int winningStreakSize):
+                   _width(width), _height(height), _streak(winningStreakSize) {
+    _steps[0] = 1;
+    _steps[1] = height + 1;
+    _steps[2] = height;
+    _steps[3] = height + 2;
+    _bottom = 0;
+    _full = 0;
+    for(int c = 0; c < width; c++) {
+        _bottom |= uint64_t(1) << (c * (height + 1));
+        _full |= columnMask(c);
+    }
+    for(int i = 0; i < width; i++)
+        _columnOrder[i] = width / 2 + (1 - 2 * (i % 2)) * (i + 1) / 2;
+}
+
+bool BitRules::supportsGeometry(int width, int height, int winningStreakSize) {
+    return width > 0 && height > 0 && width * (height + 1) <= 64 &&
+           winningStreakSize >= 2 && (winningStreakSize - 1) * (height + 2) < 64;
+}
+
+BitBoard BitRules::fromBoard(const SlotStatus* board, Player toMove) const {
+    BitBoard position;
+    const SlotStatus own = (toMove == Player::Red) ? SlotStatus::Red : SlotStatus::Yellow;
+    for(int row = 0; row < _height; row++) {
+        for(int c = 0; c < _width; c++) {
+            SlotStatus slot = board[row * _width + c];
+            if(slot == SlotStatus::Empty) continue;
+            uint64_t bit = uint64_t(1) << (c * (_height + 1) + (_height - 1 - row));
+            position.mask |= bit;
+            if(slot == own) position.own |= bit;
+            ++position.plies;
+        }
+    }
+    return position;
+}
+
+bool BitRules::fromMoves(const char* moves, BitBoard& position) const {
+    position = BitBoard();
+    for(const char* m = moves; *m; m++) {
+        int c = *m - '1';
+        if(c < 0 || c >= _width) return false;
+        uint64_t move = possible(position) & columnMask(c);
+        if(!move || isWin(position.own | move)) return false;
+        play(position, move);
+    }
+    return true;
+}
+
+BitBoard BitRules::mirror(const BitBoard& position) const {
+    BitBoard mirrored;
+    mirrored.plies = position.plies;
+    const int stride = _height + 1;
+    for(int c = 0; c < _width; c++) {
+        const int shift = (_width - 1 - 2 * c) * stride;
+        uint64_t own = position.own & columnMask(c);
+        uint64_t mask = position.mask & columnMask(c);
+        mirrored.own |= (shift >= 0) ? own << shift : own >> -shift;
+        mirrored.mask |= (shift >= 0) ? mask << shift : mask >> -shift;
+    }
+    return mirrored;
+}
+
+uint64_t BitRules::winningSpots(uint64_t pieces, uint64_t mask) const {
+    uint64_t spots = 0;
+    for(int d = 0; d < 4; d++) {
+        // Slot p is a spot when the other slots of a line through it are
+        // pieces, j is the position of p in the line
+        for(int j = 0; j < _streak; j++) {
+            uint64_t line = _full;
+            for(int i = 0; i < _streak && line; i++) {
+                int shift = (i - j) * _steps[d];
+                if(shift > 0) line &= pieces >> shift;
+                else if(shift < 0) line &= pieces << -shift;
+            }
+            spots |= line;
+        }
+    }
+    return spots & ~mask;
+}
+
+uint64_t BitRules::nonLosingMoves(const BitBoard& position) const {
+    uint64_t moves = possible(position);
+    uint64_t threats = winningSpots(position.own ^ position.mask, position.mask);
+    uint64_t forced = moves & threats;
+    if(forced) {
+        // Two threats cannot both be blocked
+        if(forced & (forced - 1)) return 0;
+        moves = forced;
+    }
+    // Never play right below a threat of the opponent
+    return moves & ~(threats >> 1);
+}
+
+bool BitRules::isWin(uint64_t pieces) const {
+    for(int d = 0; d < 4; d++) {
+        uint64_t line = pieces;
+        for(int k = 1; k < _streak && line; k++) line &= pieces >> (k * _steps[d]);
+        if(line) return true;
+    }
+    return false;
+}
+
+int BitRules::orderMoves(const BitBoard& position, uint64_t moves, uint64_t* ordered) const {
+    int scores[64];
+    int count = 0;
+    for(int i = 0; i < _width; i++) {
+        uint64_t move = moves & columnMask(_columnOrder[i]);
+        if(!move) continue;
+        int score = __builtin_popcountll(winningSpots(position.own | move, position.mask | move));
+        // Insertion sort, stable so equal scores keep the center first order
+        int k = count++;
+        for(; k > 0 && scores[k - 1] < score; k--) {
+            scores[k] = scores[k - 1];
+            ordered[k] = ordered[k - 1];
+        }
+        scores[k] = score;
+        ordered[k] = move;
+    }
+    return count;
+}
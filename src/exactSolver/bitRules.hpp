@@ -0,0 +1,117 @@
+/**
+ * @defgroup   BIT_RULES
+ *
+ * @brief      Connect-4 rules on 64 bit column major bitboards, shared by the
+ * exact solvers. Every column holds height slots plus an empty sentinel slot
+ * on top, bit 0 of a column is its bottom slot. A position is stored for the
+ * player to move: own holds its pieces, mask every piece on the board.
+ *
+ * Lines are found with shifts of the whole board. The sentinel row is never
+ * occupied, so a line that would wrap into the next column always runs into
+ * an empty slot.
+ *
+ * @date       2021
+ */
+#ifndef __BIT_RULES__
+#define __BIT_RULES__
+
+#include "connectFourAssets/slotStatus.hpp"
+#include "connectFourAssets/player.hpp"
+
+#include <cstdint>
+
+struct BitBoard {
+    uint64_t own = 0;
+    uint64_t mask = 0;
+    int plies = 0;
+};
+
+class BitRules
+{
+    public:
+        BitRules(int width, int height, int winningStreakSize);
+
+        /**
+         * @brief      Determines if the geometry can be handled, which needs
+         * width * (height + 1) <= 64.
+         */
+        static bool supportsGeometry(int width, int height, int winningStreakSize);
+
+        int width() const { return _width; }
+        int height() const { return _height; }
+        int streak() const { return _streak; }
+        int numSlots() const { return _width * _height; }
+
+        /**
+         * @brief      Builds the position of a board array (row major, row 0 at
+         * the top) for the player to move.
+         */
+        BitBoard fromBoard(const SlotStatus* board, Player toMove) const;
+
+        /**
+         * @brief      Plays a move sequence from the empty board, one digit per
+         * move with 1 for the leftmost column.
+         *
+         * @return     False if a move is illegal or the game ends before the
+         * last one
+         */
+        bool fromMoves(const char* moves, BitBoard& position) const;
+
+        // Slots a piece can be dropped on, one per open column
+        uint64_t possible(const BitBoard& position) const {
+            return (position.mask + _bottom) & _full;
+        }
+
+        // Empty slots that would complete a line of pieces
+        uint64_t winningSpots(uint64_t pieces, uint64_t mask) const;
+
+        bool canWinNow(const BitBoard& position) const {
+            return winningSpots(position.own, position.mask) & possible(position);
+        }
+
+        /**
+         * @brief      Moves that do not let the opponent win right away. Only
+         * meaningful when the player to move cannot win at once. A single
+         * forced block is returned alone, and no move is left when the
+         * opponent has two threats.
+         */
+        uint64_t nonLosingMoves(const BitBoard& position) const;
+
+        bool isWin(uint64_t pieces) const;
+
+        void play(BitBoard& position, uint64_t move) const {
+            position.own ^= position.mask;
+            position.mask |= move;
+            ++position.plies;
+        }
+
+        // Unique for a position, the player to move follows from the plies
+        uint64_t key(const BitBoard& position) const { return position.own + position.mask; }
+
+        // The position with the columns in reverse order, it has the same value
+        BitBoard mirror(const BitBoard& position) const;
+
+        int column(uint64_t move) const { return __builtin_ctzll(move) / (_height + 1); }
+        uint64_t columnMask(int c) const { return ((uint64_t(1) << _height) - 1) << (c * (_height + 1)); }
+
+        /**
+         * @brief      Moves in the order the solvers try them: the ones that
+         * create the most threats first, ties broken towards the center.
+         *
+         * @return     The number of moves written to ordered
+         */
+        int orderMoves(const BitBoard& position, uint64_t moves, uint64_t* ordered) const;
+
+    private:
+        int _width;
+        int _height;
+        int _streak;
+        // Slot step of the vertical, horizontal and both diagonal directions
+        int _steps[4];
+        uint64_t _bottom;
+        uint64_t _full;
+        // Columns from the center outwards
+        int _columnOrder[64];
+};
+
+#endif
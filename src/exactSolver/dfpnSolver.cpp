@@ -0,0 +1,202 @@
+#include "dfpnSolver.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr uint32_t kInfinity = 0x7fffffff;
+    // Never a key, own + mask stays below 2^63
+    constexpr uint64_t kNoKey = ~uint64_t(0);
+    // Thresholds of the best child are widened to (1 + kEpsilon) times the
+    // value of the second best one
+    constexpr double kEpsilon = 0.25;
+
+    uint32_t sum(uint32_t a, uint32_t b) {
+        return std::min<uint64_t>((uint64_t)a + b, kInfinity);
+    }
+
+    uint32_t widen(uint32_t second) {
+        if(second >= kInfinity) return kInfinity;
+        uint64_t widened = std::max<uint64_t>(second + 1, (uint64_t)(second * (1 + kEpsilon)));
+        return std::min<uint64_t>(widened, kInfinity);
+    }
+}
+
+DfpnSolver::DfpnSolver(const BitRules& rules, size_t tableKb):
+                       _rules(rules), _nodes(0), _nodeLimit(0), _abort(nullptr), _stalled(false) {
+    // Two entries per slot
+    size_t entries = tableKb * 1024 / sizeof(Entry) & ~size_t(1);
+    _table.resize(entries ? entries : 2);
+    clear();
+}
+
+void DfpnSolver::clear() {
+    std::fill(_table.begin(), _table.end(), Entry{kNoKey, 1, 1, 0});
+}
+
+int DfpnSolver::solve(const BitBoard& position, uint64_t nodeLimit, int& column) {
+    _nodes = 0;
+    _nodeLimit = nodeLimit;
+    _stalled = false;
+
+    uint64_t wins = _rules.winningSpots(position.own, position.mask) & _rules.possible(position);
+    if(wins) {
+        column = _rules.column(wins & -wins);
+        return 1;
+    }
+    uint64_t possible = _rules.possible(position);
+    uint64_t moves = _rules.nonLosingMoves(position);
+    if(!moves) {
+        column = _rules.column(possible & -possible);
+        return -1;
+    }
+    uint64_t ordered[64];
+    int count = _rules.orderMoves(position, moves, ordered);
+
+    // A move that wins is one after which the win of the player to move is
+    // proven. The proofs of the children are mostly still in the table.
+    clear();
+    Proof win = prove(position, true);
+    if(_stalled) return kStalled;
+    if(win == Proof::Proven) {
+        for(int i = 0; i < count; i++) {
+            BitBoard next = position;
+            _rules.play(next, ordered[i]);
+            if(prove(next, false) == Proof::Proven) {
+                column = _rules.column(ordered[i]);
+                return 1;
+            }
+            if(_stalled) return kStalled;
+        }
+    }
+
+    // No win, so a move that keeps the opponent from winning draws
+    clear();
+    Proof loss = prove(position, false);
+    if(_stalled) return kStalled;
+    column = _rules.column(ordered[0]);
+    if(loss == Proof::Proven) return -1;
+    for(int i = 0; i < count; i++) {
+        BitBoard next = position;
+        _rules.play(next, ordered[i]);
+        if(prove(next, true) == Proof::Disproven) {
+            column = _rules.column(ordered[i]);
+            break;
+        }
+        if(_stalled) return kStalled;
+    }
+    return 0;
+}
+
+DfpnSolver::Proof DfpnSolver::prove(const BitBoard& position, bool attackerToMove) {
+    Proof settled = settle(position, attackerToMove);
+    if(settled != Proof::Unknown) return settled;
+    uint32_t pn, dn;
+    mid(position, attackerToMove, kInfinity, kInfinity, pn, dn);
+    if(pn == 0) return Proof::Proven;
+    if(dn == 0) return Proof::Disproven;
+    return Proof::Unknown;
+}
+
+DfpnSolver::Proof DfpnSolver::settle(const BitBoard& position, bool attackerToMove) const {
+    if(position.plies == _rules.numSlots()) return Proof::Disproven;
+    if(_rules.canWinNow(position)) return attackerToMove ? Proof::Proven : Proof::Disproven;
+    if(!_rules.nonLosingMoves(position)) return attackerToMove ? Proof::Disproven : Proof::Proven;
+    // No more wins once the last two moves are not winning ones, and a full
+    // board is no win for the attacker
+    if(position.plies >= _rules.numSlots() - 2) return Proof::Disproven;
+    return Proof::Unknown;
+}
+
+void DfpnSolver::mid(const BitBoard& position, bool attackerToMove, uint32_t thpn, uint32_t thdn,
+                     uint32_t& pn, uint32_t& dn) {
+    const uint64_t key = _rules.key(position);
+    if((_nodeLimit && _nodes >= _nodeLimit) ||
+       (_abort && _nodes % kAbortNodes == 0 && _abort->load(std::memory_order_relaxed))) {
+        _stalled = true;
+        lookup(key, pn, dn);
+        return;
+    }
+    const uint64_t startNodes = _nodes++;
+
+    // Children that are decided right away keep their numbers, the others
+    // are read from the table on every pass
+    uint64_t moves[64];
+    const int count = _rules.orderMoves(position, _rules.nonLosingMoves(position), moves);
+    BitBoard children[64];
+    uint64_t keys[64];
+    bool open[64];
+    uint32_t childPn[64], childDn[64];
+    for(int i = 0; i < count; i++) {
+        children[i] = position;
+        _rules.play(children[i], moves[i]);
+        keys[i] = _rules.key(children[i]);
+        Proof settled = settle(children[i], !attackerToMove);
+        open[i] = settled == Proof::Unknown;
+        childPn[i] = settled == Proof::Proven ? 0 : settled == Proof::Disproven ? kInfinity : 1;
+        childDn[i] = settled == Proof::Disproven ? 0 : settled == Proof::Proven ? kInfinity : 1;
+    }
+
+    while(true) {
+        // The attacker needs one proven child, the defender all of them
+        pn = attackerToMove ? kInfinity : 0;
+        dn = attackerToMove ? 0 : kInfinity;
+        int best = 0;
+        uint32_t bestValue = kInfinity, second = kInfinity;
+        for(int i = 0; i < count; i++) {
+            if(open[i]) lookup(keys[i], childPn[i], childDn[i]);
+            uint32_t value = attackerToMove ? childPn[i] : childDn[i];
+            if(attackerToMove) {
+                pn = std::min(pn, childPn[i]);
+                dn = sum(dn, childDn[i]);
+            }
+            else {
+                pn = sum(pn, childPn[i]);
+                dn = std::min(dn, childDn[i]);
+            }
+            if(value < bestValue) {
+                second = bestValue;
+                bestValue = value;
+                best = i;
+            }
+            else if(value < second) {
+                second = value;
+            }
+        }
+        if(pn >= thpn || dn >= thdn || _stalled) break;
+
+        uint32_t childThpn, childThdn;
+        if(attackerToMove) {
+            childThpn = std::min(thpn, widen(second));
+            childThdn = thdn >= kInfinity ? kInfinity : thdn - dn + childDn[best];
+        }
+        else {
+            childThdn = std::min(thdn, widen(second));
+            childThpn = thpn >= kInfinity ? kInfinity : thpn - pn + childPn[best];
+        }
+        uint32_t bestPn, bestDn;
+        mid(children[best], !attackerToMove, childThpn, childThdn, bestPn, bestDn);
+    }
+    store(key, pn, dn, _nodes - startNodes);
+}
+
+void DfpnSolver::lookup(uint64_t key, uint32_t& pn, uint32_t& dn) const {
+    size_t slot = (key * 0x9E3779B97F4A7C15ULL) % (_table.size() / 2) * 2;
+    for(size_t i = slot; i < slot + 2; i++) {
+        if(_table[i].key == key) {
+            pn = _table[i].pn;
+            dn = _table[i].dn;
+            return;
+        }
+    }
+    pn = 1;
+    dn = 1;
+}
+
+void DfpnSolver::store(uint64_t key, uint32_t pn, uint32_t dn, uint64_t work) {
+    size_t slot = (key * 0x9E3779B97F4A7C15ULL) % (_table.size() / 2) * 2;
+    Entry* target = &_table[slot];
+    if(_table[slot + 1].key == key || (target->key != key && _table[slot + 1].work < target->work))
+        target = &_table[slot + 1];
+    *target = Entry{key, pn, dn, work};
+}
@@ -0,0 +1,102 @@
+/**
+ * @defgroup   DFPN_SOLVER
+ *
+ * @brief      Depth-first proof-number search (df-pn). Instead of a value
+ * window it tries to prove or disprove one goal, "the attacker wins", and
+ * always follows the child that is cheapest to settle: the one with the
+ * smallest proof number at the attacker's nodes and the smallest disproof
+ * number at the defender's. Long forced wins are found without searching the
+ * side lines alpha-beta has to refute one by one.
+ *
+ * Proof and disproof numbers live in a table of fixed size with two entries
+ * per slot. When a slot is taken, the entry that cost fewer nodes to compute
+ * is replaced, so the memory stays bounded however long the search runs.
+ * Thresholds of the best child are widened by the 1 + epsilon rule to keep
+ * the search from switching back and forth between siblings.
+ *
+ * A position takes two proofs: a win for the player to move, and if that
+ * fails a win for the opponent. Neither one means a draw.
+ *
+ * @date       2021
+ */
+#ifndef __DFPN_SOLVER__
+#define __DFPN_SOLVER__
+
+#include "bitRules.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class DfpnSolver
+{
+    public:
+        /**
+         * @brief      Constructs a new instance.
+         *
+         * @param[in]  rules    The rules of the geometry
+         * @param[in]  tableKb  The size of the proof number table in KB
+         */
+        DfpnSolver(const BitRules& rules, size_t tableKb);
+
+        /**
+         * @brief      Solves a position that is not decided yet.
+         *
+         * @param[in]  position   The position
+         * @param[in]  nodeLimit  Nodes after which the search gives up, 0 for
+         * no limit
+         * @param      column     Set to a column that keeps the value
+         *
+         * @return     1 if the player to move wins, 0 for a draw, -1 if it
+         * loses, kStalled if the node limit was reached
+         */
+        int solve(const BitBoard& position, uint64_t nodeLimit, int& column);
+
+        uint64_t nodes() const { return _nodes; }
+
+        /**
+         * @brief      Makes the searches give up like at the node limit once
+         * the flag is set, null for none. Checked every kAbortNodes nodes.
+         */
+        void setAbort(const std::atomic<bool>* abort) { _abort = abort; }
+
+        static constexpr int kStalled = 2;
+        static constexpr uint64_t kAbortNodes = 1024;
+
+    private:
+        struct Entry {
+            uint64_t key;
+            uint32_t pn;
+            uint32_t dn;
+            // Nodes searched below the entry, the cheaper one of a slot is
+            // replaced first
+            uint64_t work;
+        };
+
+        enum class Proof {Proven, Disproven, Unknown};
+
+        const BitRules& _rules;
+        std::vector<Entry> _table;
+        uint64_t _nodes;
+        uint64_t _nodeLimit;
+        const std::atomic<bool>* _abort;
+        bool _stalled;
+
+        // Tries to prove a win for the player to move (attackerToMove) or
+        // for the opponent
+        Proof prove(const BitBoard& position, bool attackerToMove);
+        // Searches until the proof or disproof number of the node reaches its
+        // threshold, and returns both
+        void mid(const BitBoard& position, bool attackerToMove, uint32_t thpn, uint32_t thdn,
+                 uint32_t& pn, uint32_t& dn);
+        // Value of a node that is decided without searching it
+        Proof settle(const BitBoard& position, bool attackerToMove) const;
+        // Proof and disproof numbers of an undecided node, (1, 1) when it is
+        // not in the table
+        void lookup(uint64_t key, uint32_t& pn, uint32_t& dn) const;
+        void store(uint64_t key, uint32_t pn, uint32_t dn, uint64_t work);
+        void clear();
+};
+
+#endif
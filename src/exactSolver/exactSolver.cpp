@@ -0,0 +1,71 @@
+#include "exactSolver.hpp"
+#include "solvedStore.hpp"
+#include "connectFourAssets/evalConfig.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+ExactSolver::ExactSolver(int width, int height, int winningStreakSize):
+                         _rules(width, height, winningStreakSize),
+                         _alphaBeta(_rules, std::max<size_t>(EvalConfig::transpositionKb(), 1)),
+                         _dfpn(_rules, std::max<size_t>(EvalConfig::transpositionKb(), 1)) {
+}
+
+bool ExactSolver::supportsGeometry(int width, int height, int winningStreakSize) {
+    return BitRules::supportsGeometry(width, height, winningStreakSize);
+}
+
+void ExactSolver::setAbort(const std::atomic<bool>* abort) {
+    _alphaBeta.setAbort(abort);
+    _dfpn.setAbort(abort);
+}
+
+ExactSolver::Result ExactSolver::solve(const BitBoard& position, Method method, uint64_t nodeLimit) {
+    Result result;
+    auto start = std::chrono::high_resolution_clock::now();
+    SolvedStore& store = SolvedStore::shared();
+
+    // Decided positions need no search
+    if(_rules.isWin(position.own ^ position.mask)) {
+        result.value = -1;
+        result.solved = true;
+    }
+    else if(position.plies == _rules.numSlots()) {
+        result.solved = true;
+    }
+    else if(store.matches(_rules.width(), _rules.height(), _rules.streak()) &&
+            store.lookup(_rules, position, result.value, result.column)) {
+        result.solved = true;
+        result.stored = true;
+    }
+    else {
+        int value = AlphaBetaSolver::kStalled;
+        if(method != Method::Dfpn) {
+            uint64_t limit = nodeLimit;
+            if(method == Method::Auto) limit = nodeLimit ? std::min(nodeLimit, kStallNodes) : kStallNodes;
+            value = _alphaBeta.solve(position, limit, result.column);
+            result.nodes += _alphaBeta.nodes();
+            result.method = Method::AlphaBeta;
+        }
+        if(value == AlphaBetaSolver::kStalled && method != Method::AlphaBeta) {
+            value = _dfpn.solve(position, nodeLimit, result.column);
+            result.nodes += _dfpn.nodes();
+            result.method = Method::Dfpn;
+        }
+        result.solved = value != AlphaBetaSolver::kStalled;
+        result.value = result.solved ? value : 0;
+        if(result.solved && store.matches(_rules.width(), _rules.height(), _rules.streak()))
+            store.append(_rules, position, result.value, result.column);
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    return result;
+}
+
+const char* ExactSolver::methodName(Method method) {
+    switch(method) {
+        case Method::AlphaBeta: return "alpha-beta";
+        case Method::Dfpn: return "df-pn";
+        default: return "auto";
+    }
+}
@@ -0,0 +1,85 @@
+/**
+ * @defgroup   EXACT_SOLVER
+ *
+ * @brief      Finds the game theoretic value of a position, win, draw or
+ * loss for the player to move, with the alpha-beta or the proof-number
+ * solver. In the automatic mode alpha-beta runs first and hands the position
+ * to df-pn when it stalls, i.e. when it has searched kStallNodes nodes
+ * without an answer. Both solvers size their tables from the transposition
+ * table setting (EvalConfig::transpositionKb). When the shared SolvedStore is
+ * open for the geometry, positions are looked up there first and solved ones
+ * are appended to it.
+ *
+ * @date       2021
+ */
+#ifndef __EXACT_SOLVER__
+#define __EXACT_SOLVER__
+
+#include "bitRules.hpp"
+#include "alphaBetaSolver.hpp"
+#include "dfpnSolver.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+class ExactSolver
+{
+    public:
+        enum class Method {AlphaBeta, Dfpn, Auto};
+
+        struct Result {
+            // 1 win, 0 draw, -1 loss for the player to move
+            int value = 0;
+            // Column (0 based) that keeps the value, -1 if the game is over
+            int column = -1;
+            // False when the node limit was reached first, or the abort flag
+            // was set
+            bool solved = false;
+            // The solver that gave the answer
+            Method method = Method::AlphaBeta;
+            // Read from the solved store, no solver ran
+            bool stored = false;
+            uint64_t nodes = 0;
+            double seconds = 0;
+        };
+
+        // Alpha-beta nodes before the automatic mode switches to df-pn
+        static constexpr uint64_t kStallNodes = 1 << 22;
+
+        ExactSolver(int width, int height, int winningStreakSize);
+
+        /**
+         * @brief      Determines if the geometry can be handled, see BitRules.
+         */
+        static bool supportsGeometry(int width, int height, int winningStreakSize);
+
+        /**
+         * @brief      Solves a position.
+         *
+         * @param[in]  position   The position, see BitRules::fromBoard and
+         * BitRules::fromMoves
+         * @param[in]  method     The method
+         * @param[in]  nodeLimit  Nodes after which each solver gives up, 0 for
+         * no limit
+         *
+         * @return     The result
+         */
+        Result solve(const BitBoard& position, Method method, uint64_t nodeLimit = 0);
+
+        /**
+         * @brief      Makes solve() give up like at the node limit once the
+         * flag is set, null for none.
+         */
+        void setAbort(const std::atomic<bool>* abort);
+
+        const BitRules& rules() const { return _rules; }
+
+        static const char* methodName(Method method);
+
+    private:
+        BitRules _rules;
+        AlphaBetaSolver _alphaBeta;
+        DfpnSolver _dfpn;
+};
+
+#endif
@@ -0,0 +1,199 @@
+#include "solvedStore.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    bool writeAll(int fd, const void* data, size_t size) {
+        const char* bytes = (const char*)data;
+        while(size > 0) {
+            ssize_t n = write(fd, bytes, size);
+            if(n < 0 && errno == EINTR) continue;
+            if(n <= 0) return false;
+            bytes += n;
+            size -= n;
+        }
+        return true;
+    }
+}
+
+SolvedStore::~SolvedStore() {
+    close();
+}
+
+SolvedStore& SolvedStore::shared() {
+    static SolvedStore store;
+    return store;
+}
+
+uint32_t SolvedStore::checksum(const SolvedRecord& record) {
+    uint64_t h = record.key ^ ((uint64_t)(uint8_t)record.value << 56) ^ ((uint64_t)(uint8_t)record.column << 48) ^
+                 ((uint64_t)record.reserved << 32);
+    h *= 0x9E3779B97F4A7C15ULL;
+    // Never 0, so a record of zeros from a torn write does not check out
+    return (uint32_t)(h >> 32) | 1;
+}
+
+bool SolvedStore::open(const std::string& path, int width, int height, int winningStreakSize) {
+    close();
+    std::lock_guard<std::mutex> lock(_mutex);
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if(fd < 0) {
+        std::cerr << "Could not open solved store " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat st;
+    fstat(fd, &st);
+
+    SolvedStoreHeader header = {};
+    if(st.st_size < (off_t)sizeof(header)) {
+        // New, or torn before its header was complete
+        memcpy(header.magic, "C4SS", 4);
+        header.version = kVersion;
+        header.width = width;
+        header.height = height;
+        header.winningStreakSize = winningStreakSize;
+        if(ftruncate(fd, 0) < 0 || !writeAll(fd, &header, sizeof(header)) || fdatasync(fd) < 0) {
+            std::cerr << "Could not create solved store " << path << std::endl;
+            ::close(fd);
+            return false;
+        }
+        st.st_size = sizeof(header);
+    }
+    else if(pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+            memcmp(header.magic, "C4SS", 4) || header.version != kVersion) {
+        std::cerr << "Solved store " << path << " is not a valid store" << std::endl;
+        ::close(fd);
+        return false;
+    }
+    if(header.width != width || header.height != height || header.winningStreakSize != winningStreakSize) {
+        std::cerr << "Solved store " << path << " was made for " << (int)header.width << "x"
+                  << (int)header.height << " with a streak of " << (int)header.winningStreakSize << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    // Index the records up to the first one that does not check out
+    std::vector<SolvedRecord> records((st.st_size - sizeof(header)) / sizeof(SolvedRecord));
+    size_t valid = 0;
+    if(!records.empty()) {
+        ssize_t n = pread(fd, records.data(), records.size() * sizeof(SolvedRecord), sizeof(header));
+        size_t read = n > 0 ? n / sizeof(SolvedRecord) : 0;
+        while(valid < read && records[valid].check == checksum(records[valid])) {
+            _index[records[valid].key] = {records[valid].value, records[valid].column};
+            valid++;
+        }
+    }
+    const off_t end = sizeof(header) + valid * sizeof(SolvedRecord);
+    if(end < st.st_size) {
+        std::cerr << "Solved store " << path << ": dropped " << st.st_size - end
+                  << " bytes after the last valid record" << std::endl;
+        if(ftruncate(fd, end) < 0 || fdatasync(fd) < 0) {
+            std::cerr << "Could not repair solved store " << path << std::endl;
+            _index.clear();
+            ::close(fd);
+            return false;
+        }
+    }
+    _fd = fd;
+    _end = end;
+    _header = header;
+    _unsynced = 0;
+    return true;
+}
+
+void SolvedStore::close() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(_fd < 0) return;
+    fdatasync(_fd);
+    ::close(_fd);
+    _fd = -1;
+    _index.clear();
+}
+
+bool SolvedStore::matches(int width, int height, int winningStreakSize) const {
+    return _fd >= 0 && _header.width == width && _header.height == height &&
+           _header.winningStreakSize == winningStreakSize;
+}
+
+bool SolvedStore::lookup(const BitRules& rules, const BitBoard& position, int& value, int& column) {
+    const uint64_t key = rules.key(position);
+    const uint64_t mirrorKey = rules.key(rules.mirror(position));
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_probes;
+    auto found = _index.find(std::min(key, mirrorKey));
+    if(found == _index.end()) return false;
+    ++_hits;
+    value = found->second.value;
+    column = found->second.column;
+    if(mirrorKey < key && column >= 0) column = rules.width() - 1 - column;
+    return true;
+}
+
+void SolvedStore::append(const BitRules& rules, const BitBoard& position, int value, int column) {
+    const uint64_t key = rules.key(position);
+    const uint64_t mirrorKey = rules.key(rules.mirror(position));
+    SolvedRecord record = {};
+    record.key = std::min(key, mirrorKey);
+    record.value = value;
+    record.column = (mirrorKey < key && column >= 0) ? rules.width() - 1 - column : column;
+    record.check = checksum(record);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(_fd < 0 || !_index.emplace(record.key, Stored{record.value, record.column}).second) return;
+    if(!writeAll(_fd, &record, sizeof(record))) {
+        // Later records must not land behind a torn one
+        std::cerr << "Could not append to the solved store: " << strerror(errno) << std::endl;
+        if(ftruncate(_fd, _end) < 0) {
+            ::close(_fd);
+            _fd = -1;
+        }
+        return;
+    }
+    _end += sizeof(record);
+    if(++_unsynced >= kSyncRecords) {
+        fdatasync(_fd);
+        _unsynced = 0;
+    }
+}
+
+void SolvedStore::sync() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(_fd < 0) return;
+    fdatasync(_fd);
+    _unsynced = 0;
+}
+
+size_t SolvedStore::size() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _index.size();
+}
+
+uint64_t SolvedStore::probes() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _probes;
+}
+
+uint64_t SolvedStore::hits() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _hits;
+}
+
+double SolvedStore::hitRate() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _probes ? (double)_hits / _probes : 0.0;
+}
+
+void SolvedStore::resetStats() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _probes = 0;
+    _hits = 0;
+}
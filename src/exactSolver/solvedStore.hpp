@@ -0,0 +1,132 @@
+/**
+ * @defgroup   SOLVED_STORE
+ *
+ * @brief      Exact results kept on disk across runs. ExactSolver::solve looks
+ * a position up before searching it and appends what it solved, so repeated
+ * analysis of overlapping positions reads the value instead of solving again.
+ *
+ * The file is a header followed by fixed size records, only ever appended
+ * to. Each record carries a checksum, and opening the store drops a torn or
+ * corrupt tail, so a crash in the middle of an append loses that record and
+ * nothing before it. Records are written with one write() each, which a
+ * crashing process cannot lose; fdatasync every kSyncRecords records and on
+ * close bounds what a power failure can lose.
+ *
+ * Positions are stored under the smaller key of the position and its mirror
+ * image, with the best column of that orientation. The records are indexed
+ * in memory when the store is opened. One process should append to a store
+ * at a time, others do not see its new records until they open it again.
+ *
+ * @date       2021
+ */
+#ifndef __SOLVED_STORE__
+#define __SOLVED_STORE__
+
+#include "bitRules.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <sys/types.h>
+
+struct SolvedStoreHeader {
+    char magic[4];          // "C4SS"
+    uint32_t version;
+    uint8_t width;
+    uint8_t height;
+    uint8_t winningStreakSize;
+    uint8_t reserved[5];
+};
+
+struct SolvedRecord {
+    uint64_t key;
+    // 1 win, 0 draw, -1 loss for the player to move
+    int8_t value;
+    // Column (0 based) that keeps the value, -1 if the game is over
+    int8_t column;
+    uint16_t reserved;
+    // Of the other fields, see SolvedStore::checksum
+    uint32_t check;
+};
+
+class SolvedStore
+{
+    public:
+        static constexpr uint32_t kVersion = 1;
+        // Appends between two fdatasync calls
+        static constexpr int kSyncRecords = 256;
+
+        SolvedStore() = default;
+        ~SolvedStore();
+        SolvedStore(const SolvedStore&) = delete;
+        SolvedStore& operator=(const SolvedStore&) = delete;
+
+        /**
+         * @brief      The store ExactSolver::solve consults.
+         */
+        static SolvedStore& shared();
+
+        /**
+         * @brief      Opens a store, creating it if the file does not exist,
+         * and indexes its records.
+         *
+         * @return     False if the file cannot be opened or was made for
+         * another geometry, the store stays closed then
+         */
+        bool open(const std::string& path, int width, int height, int winningStreakSize);
+
+        // Syncs and closes the store
+        void close();
+
+        bool isOpen() const { return _fd >= 0; }
+
+        bool matches(int width, int height, int winningStreakSize) const;
+
+        /**
+         * @brief      Looks up a position.
+         *
+         * @param[in]  rules     The rules of the geometry
+         * @param[in]  position  The position
+         * @param      value     Set to the value for the player to move
+         * @param      column    Set to the column that keeps it
+         *
+         * @return     True if the position is stored
+         */
+        bool lookup(const BitRules& rules, const BitBoard& position, int& value, int& column);
+
+        /**
+         * @brief      Stores a solved position, unless it is already stored.
+         */
+        void append(const BitRules& rules, const BitBoard& position, int value, int column);
+
+        // Writes the appended records through to the disk
+        void sync();
+
+        size_t size();
+        uint64_t probes();
+        uint64_t hits();
+        double hitRate();
+        void resetStats();
+
+        static uint32_t checksum(const SolvedRecord& record);
+
+    private:
+        struct Stored {
+            int8_t value;
+            int8_t column;
+        };
+
+        std::mutex _mutex;
+        int _fd = -1;
+        // End of the last valid record
+        off_t _end = 0;
+        SolvedStoreHeader _header = {};
+        std::unordered_map<uint64_t, Stored> _index;
+        int _unsynced = 0;
+        uint64_t _probes = 0;
+        uint64_t _hits = 0;
+};
+
+#endif
@@ -10,6 +10,8 @@
 class GameTreeSearchSolver
 {
     public:
+        virtual ~GameTreeSearchSolver() = default;
+
         virtual int solve(Player player, int maxDepth, double timeLimit) = 0;
 
         /**
@@ -71,10 +73,23 @@ class GameTreeSearchSolver
          */
         uint64_t getTotalNodesTraversed() { return _totalNodesTraversed; }
 
+        // Nodes of the last solve()
+        uint64_t getNodesTraversed() { return _nodesTraversed; }
+
+        // Column (0 based) the last solve() played, also when the move ended
+        // the game and solve() returned -1. -1 if no move was played.
+        int getLastColumn() { return _lastColumn; }
+
+        /**
+         * @brief      Gets the winner of the current game.
+         */
+        Player getWinner() { return _board->DetermineWinner(); }
+
     protected:
     	Board *_board;
     	uint64_t _nodesTraversed = 0;
         uint64_t _totalNodesTraversed = 0;
+        int _lastColumn = -1;
         
         std::chrono::high_resolution_clock::time_point _start;
 		std::chrono::high_resolution_clock::time_point _end;
@@ -3,7 +3,18 @@
 #endif
 #include "mpSolver.hpp"
 #include "sequentialSolver.hpp"
+#include "bookBuilder.hpp"
+#include "selfPlay.hpp"
+#include "evalTuner.hpp"
 #include "tournament.hpp"
+#include "engine/engineServer.hpp"
+#include "engine/textProtocol.hpp"
+#include "connectFourAssets/evalConfig.hpp"
+#include "connectFourAssets/evalWeights.hpp"
+#include "connectFourAssets/openingBook.hpp"
+#include "connectFourAssets/tablebase.hpp"
+#include "exactSolver/solvedStore.hpp"
+#include "connectFourAssets/gameRecord.hpp"
 
 #include <iostream>
 #include <unistd.h>
@@ -47,12 +58,36 @@ void parser(int argc, char** argv) {
     bool omp_vs_cuda = false;
     bool cuda_vs_cuda = false;
     bool omp_vs_omp = false;
+    bool mcts_vs_seq = false;
+    bool mcts_vs_omp = false;
     bool human_vs_cuda = false;
     bool human_vs_omp = false;
     bool human_vs_seq = false;
     bool time_seq = false;
     bool time_cuda = false;
     bool time_omp = false;
+    bool test_eval = false;
+    bool test_keys = false;
+    bool test_columns = false;
+    bool test_tablebase_values = false;
+    bool bench_playout = false;
+    const char* solve_moves = nullptr;
+    const char* bench_exact_file = nullptr;
+    const char* analyze_file = nullptr;
+    const char* serve_path = nullptr;
+    int serve_port = 0;
+    bool text_protocol = false;
+    bool bench_cancels = false;
+    ExactSolver::Method exact_method = ExactSolver::Method::Auto;
+    const char* build_book = nullptr;
+    const char* build_tablebase = nullptr;
+    const char* solved_store = nullptr;
+    const char* record_file = nullptr;
+    const char* replay_file = nullptr;
+    const char* self_play = nullptr;
+    SelfPlay::Options self_play_options;
+    const char* tune_prefix = nullptr;
+    int book_plies = 4;
 
     string help_message = "Available options are: \n\n"
                     "--no-time-limit    # No time limit per move.\n"
@@ -71,12 +106,47 @@ void parser(int argc, char** argv) {
                     "--omp-vs-cuda      # Plays a tournament b/w the cuda and omp solvers\n"
                     "--cuda-vs-cuda     # Plays a tournament b/w 2 cuda solvers\n"
                     "--omp-vs-omp       # Plays a tournament b/w 2 omp solvers\n"
+                    "--mcts-vs-seq      # Plays a tournament b/w the MCTS and seq solvers\n"
+                    "--mcts-vs-omp      # Plays a tournament b/w the MCTS and omp solvers\n"
                     "--human-vs-seq     # Plays a game b/w a human and the seq solver\n"
                     "--human-vs-cuda    # Plays a game b/w a human and the cuda solver\n"
                     "--human-vs-omp     # Plays a game b/w a human and the omp solver\n"
                     "--time-seq         # Runs sequential solver timing\n"
                     "--time-cuda        # Does some CUDA timing\n"
                     "--time-omp        # Runs OpenMP solver timing\n"
+                    "--test-eval        # Checks the vectorized evaluation against the scalar one\n"
+                    "--test-keys        # Checks the incremental position keys over random games\n"
+                    "--test-columns     # Checks the per move scores of a kept table against searches without one\n"
+                    "--test-tablebase   # Checks the open tablebase against the exact solver with either color first\n"
+                    "--bench-playouts   # Measures the batched random playouts per second per core\n"
+                    "--solve [moves]    # Solves the position after the moves (e.g. 4453) exactly\n"
+                    "--exact [alphabeta|dfpn|auto]   # Exact solver for --solve, auto moves to df-pn when alpha-beta stalls\n"
+                    "--bench-exact [file]    # Solves the positions of the file with alpha-beta and df-pn\n"
+                    "--analyze [file|-]      # Analyzes one move sequence per line in parallel, streams the results in order\n"
+                    "--serve [path]     # Serves analysis requests on a Unix socket with --num-threads workers\n"
+                    "--serve-port [port]     # Serves analysis requests on a TCP port of 127.0.0.1\n"
+                    "--protocol         # Speaks the text engine protocol on stdin and stdout for game managers\n"
+                    "--bench-cancel     # Measures how long cancelled asynchronous searches take to return\n"
+                    "--eval [streak|pattern]     # Selects the evaluation heuristic (default streak)\n"
+                    "--eval-parity      # Weights pattern threats by the parity of their row\n"
+                    "--eval-cache [on|off|KB]    # Leaf evaluation cache (default on, 256 KB)\n"
+                    "--tt [on|off|MB]   # Transposition table kept across moves (default on, 4 MB)\n"
+                    "--tt-keep          # Keeps the transposition tables across tournament games\n"
+                    "--ponder           # Solvers search on the opponent's time in games and tournaments\n"
+                    "--driver [minimax|alphabeta|aspiration|mtdf]   # Root search of the minimax solvers (default minimax)\n"
+                    "--build-book [file]     # Searches all positions up to --book-plies and writes an opening book\n"
+                    "--book-plies [plies]    # Number of plies the built book covers (default 4)\n"
+                    "--book [file]      # Solvers play from the opening book when the position is in it\n"
+                    "--build-tablebase [file]    # Solves every position of a small geometry and writes a tablebase\n"
+                    "--tablebase [file]     # Solvers play perfectly from the tablebase\n"
+                    "--solved-store [file]  # Keeps exact results in the file across runs, created if missing\n"
+                    "--record [file]    # Writes the tournament games with move times, nodes and scores to the file\n"
+                    "--replay [file]    # Prints the games of a --record file\n"
+                    "--self-play [prefix]    # Plays --num-games games on --num-threads threads and writes their labelled positions\n"
+                    "--random-plies [plies]  # Random moves at the start of every self-play game (default 6)\n"
+                    "--shards [num]     # Number of files the self-play positions are spread over (default 16)\n"
+                    "--weights [file]   # Reads the streak heuristic weights from the file\n"
+                    "--tune [prefix]    # Fits the streak weights to the --self-play positions, writes <prefix>.weights\n"
                     "--help             # Prints this message";
 
     // Start parsing all given options
@@ -141,6 +211,14 @@ void parser(int argc, char** argv) {
             omp_vs_omp = true;
             i++;
         }
+        else if(!strcmp(argv[i], "--mcts-vs-seq")) {
+            mcts_vs_seq = true;
+            i++;
+        }
+        else if(!strcmp(argv[i], "--mcts-vs-omp")) {
+            mcts_vs_omp = true;
+            i++;
+        }
         else if(!strcmp(argv[i], "--human-vs-seq")) {
             human_vs_seq = true;
             i++;
@@ -165,6 +243,248 @@ void parser(int argc, char** argv) {
             time_omp = true;
             i++;
         }
+        else if(!strcmp(argv[i], "--test-eval")) {
+            test_eval = true;
+            i++;
+        }
+        else if(!strcmp(argv[i], "--test-keys")) {
+            test_keys = true;
+            i++;
+        }
+        else if(!strcmp(argv[i], "--test-columns")) {
+            test_columns = true;
+            i++;
+        }
+        else if(!strcmp(argv[i], "--test-tablebase")) {
+            test_tablebase_values = true;
+            i++;
+        }
+        else if(!strcmp(argv[i], "--bench-playouts")) {
+            bench_playout = true;
+            i++;
+        }
+        else if(!strcmp(argv[i], "--solve")) {
+            if(i + 1 >= argc) {
+                cout << "[ERROR] --solve expects a move sequence" << endl;
+                return;
+            }
+            solve_moves = argv[i + 1];
+            i += 2;
+        }
+        else if(!strcmp(argv[i], "--exact")) {
+            if(i + 1 < argc && !strcmp(argv[i + 1], "alphabeta"))
+                exact_method = ExactSolver::Method::AlphaBeta;
+            else if(i + 1 < argc && !strcmp(argv[i + 1], "dfpn"))
+                exact_method = ExactSolver::Method::Dfpn;
+            else if(i + 1 < argc && !strcmp(argv[i + 1], "auto"))
+                exact_method = ExactSolver::Method::Auto;
+            else {
+                cout << "[ERROR] --exact expects alphabeta, dfpn or auto" << endl;
+                return;
+            }
+            i += 2;
+        }
+        else if(!strcmp(argv[i], "--analyze")) {
+            if(i + 1 >= argc) {
+                cout << "[ERROR] --analyze expects a file name or - for stdin" << endl;
+                return;
+            }
+            analyze_file = argv[i + 1];
+            i += 2;
+        }
+        else if(!strcmp(argv[i], "--serve")) {
+            if(i + 1 >= argc) {
+                cout << "[ERROR] --serve expects a socket path" << endl;
+                return;
+            }
+            serve_path = argv[i + 1];
+            i += 2;
+        }
+        else if(!strcmp(argv[i], "--serve-port")) {
+            if(i + 1 >= argc || atoi(argv[i + 1]) <= 0) {
+                cout << "[ERROR] --serve-port expects a port number" << endl;
+                return;
+            }
+            serve_port = atoi(argv[i + 1]);
+            i += 2;
+        }
+        else if(!strcmp(argv[i], "--protocol")) {
+            text_protocol = true;
+            i++;
+        }
+        else if(!strcmp(argv[i], "--bench-cancel")) {
+            bench_cancels = true;
+            i++;
+        }
+        else if(!strcmp(argv[i], "--bench-exact")) {
+            if(i + 1 >= argc) {
+                cout << "[ERROR] --bench-exact expects a file name" << endl;
+                return;
+            }
+            bench_exact_file = argv[i + 1];
+            i += 2;
+        }
+        else if(!strcmp(argv[i], "--eval")) {
+            if(i + 1 < argc && !strcmp(argv[i + 1], "pattern"))
+                EvalConfig::setHeuristic(EvalConfig::Heuristic::Pattern);
+            else if(i + 1 < argc && !strcmp(argv[i + 1], "streak"))
+                EvalConfig::setHeuristic(EvalConfig::Heuristic::Streak);
+            else {
+                cout << "[ERROR] --eval expects streak or pattern" << endl;
+                return;
+            }
+            i += 2;
+        }
+        else if(!strcmp(argv[i], "--eval-parity")) {
+            EvalConfig::setRowParity(true);
+            i++;
+        }
+        else if(!strcmp(argv[i], "--eval-cache")) {
+            if(i + 1 >= argc) {
+                cout << "[ERROR] --eval-cache expects on, off or a size in KB" << endl;
+                return;
+            }
+            if(!strcmp(argv[i + 1], "off"))
+                EvalConfig::setEvalCacheKb(0);
+            else if(!strcmp(argv[i + 1], "on"))
+                EvalConfig::setEvalCacheKb(EvalConfig::kDefaultEvalCacheKb);
+            else
+                EvalConfig::setEvalCacheKb(atoi(argv[i + 1]));
+            i += 2;
+        }
+        else if(!strcmp(argv[i], "--tt")) {
+            if(i + 1 >= argc) {
+                cout << "[ERROR] --tt expects on, off or a size in MB" << endl;
+                return;
+            }
+            if(!strcmp(argv[i + 1], "off"))
+                EvalConfig::setTranspositionKb(0);
+            else if(!strcmp(argv[i + 1], "on"))
+                EvalConfig::setTranspositionKb(EvalConfig::kDefaultTranspositionKb);
+            else
+                EvalConfig::setTranspositionKb(atoi(argv[i + 1]) * 1024);
+            i += 2;
+        }
+        else if(!strcmp(argv[i], "--tt-keep")) {
+            EvalConfig::setKeepTranspositions(true);
+            i++;
+        }
+        else if(!strcmp(argv[i], "--ponder")) {
+            EvalConfig::setPonder(true);
+            i++;
+        }
+        else if(!strcmp(argv[i], "--driver")) {
+            if(i + 1 < argc && !strcmp(argv[i + 1], "minimax"))
+                EvalConfig::setSearchDriver(EvalConfig::SearchDriver::Minimax);
+            else if(i + 1 < argc && !strcmp(argv[i + 1], "alphabeta"))
+                EvalConfig::setSearchDriver(EvalConfig::SearchDriver::AlphaBeta);
+            else if(i + 1 < argc && !strcmp(argv[i + 1], "aspiration"))
+                EvalConfig::setSearchDriver(EvalConfig::SearchDriver::Aspiration);
+            else if(i + 1 < argc && !strcmp(argv[i + 1], "mtdf"))
+                EvalConfig::setSearchDriver(EvalConfig::SearchDriver::Mtdf);
+            else {
+                cout << "[ERROR] --driver expects minimax, alphabeta, aspiration or mtdf" << endl;
+                return;
+            }
+            i += 2;
+        }
+        else if(!strcmp(argv[i], "--build-book")) {
+            if(i + 1 >= argc) {
+                cout << "[ERROR] --build-book expects a file name" << endl;
+                return;
+            }
+            build_book = argv[i + 1];
+            i += 2;
+        }
+        else if(!strcmp(argv[i], "--book-plies")) {
+            book_plies = atoi(argv[i + 1]);
+            i += 2;
+        }
+        else if(!strcmp(argv[i], "--book")) {
+            if(i + 1 >= argc || !OpeningBook::shared().open(argv[i + 1])) {
+                cout << "[ERROR] --book expects a valid opening book" << endl;
+                return;
+            }
+            i += 2;
+        }
+        else if(!strcmp(argv[i], "--build-tablebase")) {
+            if(i + 1 >= argc) {
+                cout << "[ERROR] --build-tablebase expects a file name" << endl;
+                return;
+            }
+            build_tablebase = argv[i + 1];
+            i += 2;
+        }
+        else if(!strcmp(argv[i], "--tablebase")) {
+            if(i + 1 >= argc || !Tablebase::shared().open(argv[i + 1])) {
+                cout << "[ERROR] --tablebase expects a valid tablebase" << endl;
+                return;
+            }
+            i += 2;
+        }
+        else if(!strcmp(argv[i], "--solved-store")) {
+            if(i + 1 >= argc) {
+                cout << "[ERROR] --solved-store expects a file name" << endl;
+                return;
+            }
+            solved_store = argv[i + 1];
+            i += 2;
+        }
+        else if(!strcmp(argv[i], "--record")) {
+            if(i + 1 >= argc) {
+                cout << "[ERROR] --record expects a file name" << endl;
+                return;
+            }
+            record_file = argv[i + 1];
+            i += 2;
+        }
+        else if(!strcmp(argv[i], "--replay")) {
+            if(i + 1 >= argc) {
+                cout << "[ERROR] --replay expects a file name" << endl;
+                return;
+            }
+            replay_file = argv[i + 1];
+            i += 2;
+        }
+        else if(!strcmp(argv[i], "--self-play")) {
+            if(i + 1 >= argc) {
+                cout << "[ERROR] --self-play expects a file prefix" << endl;
+                return;
+            }
+            self_play = argv[i + 1];
+            i += 2;
+        }
+        else if(!strcmp(argv[i], "--random-plies")) {
+            if(i + 1 >= argc || atoi(argv[i + 1]) < 0) {
+                cout << "[ERROR] --random-plies expects a number of moves" << endl;
+                return;
+            }
+            self_play_options.randomPlies = atoi(argv[i + 1]);
+            i += 2;
+        }
+        else if(!strcmp(argv[i], "--shards")) {
+            if(i + 1 >= argc || atoi(argv[i + 1]) <= 0) {
+                cout << "[ERROR] --shards expects a number of files" << endl;
+                return;
+            }
+            self_play_options.shards = atoi(argv[i + 1]);
+            i += 2;
+        }
+        else if(!strcmp(argv[i], "--weights")) {
+            if(i + 1 >= argc || !EvalWeights::load(argv[i + 1])) {
+                cout << "[ERROR] --weights expects a valid weights file" << endl;
+                return;
+            }
+            i += 2;
+        }
+        else if(!strcmp(argv[i], "--tune")) {
+            if(i + 1 >= argc) {
+                cout << "[ERROR] --tune expects the prefix of a --self-play corpus" << endl;
+                return;
+            }
+            tune_prefix = argv[i + 1];
+            i += 2;
+        }
         else if(!strcmp(argv[i], "--help")) {
             cout << help_message << endl;
             return;
@@ -177,11 +497,122 @@ void parser(int argc, char** argv) {
         }
     }
 
-    if (seq_vs_omp || omp_vs_cuda || omp_vs_omp || human_vs_omp || time_omp) {
+    // Opened once the geometry is known, a store holds one geometry
+    if (solved_store && !SolvedStore::shared().open(solved_store, width, height, winningStreak)) {
+        cout << "[ERROR] --solved-store expects a store of the same geometry" << endl;
+        return;
+    }
+
+    if (record_file && !GameRecordWriter::shared().open(record_file, width, height, winningStreak)) {
+        cout << "[ERROR] --record expects a file that can be written" << endl;
+        return;
+    }
+
+    if (replay_file) {
+        replay_games(replay_file);
+        return;
+    }
+
+    // Book moves are the ones of the heuristic the book was built with
+    const OpeningBook& book = OpeningBook::shared();
+    if (book.isOpen() && book.header().heuristic != (uint8_t)EvalConfig::heuristic())
+        cout << "[WARNING] The opening book was built with another --eval heuristic" << endl;
+
+    if (seq_vs_omp || omp_vs_cuda || omp_vs_omp || human_vs_omp || time_omp ||
+        mcts_vs_seq || mcts_vs_omp) {
         std::cout << "setting num threads " << num_threads << std::endl;
         omp_set_num_threads(num_threads);
     }
 
+    if (test_eval) {
+        test_eval_kernel(width, height, winningStreak, num_games * 10000);
+        return;
+    }
+
+    if (test_keys) {
+        test_position_keys(width, height, winningStreak, num_games * 10000);
+        return;
+    }
+
+    if (test_columns) {
+        test_column_scores(width, height, winningStreak, maxDepth, num_games * 20);
+        return;
+    }
+
+    if (test_tablebase_values) {
+        test_tablebase(width, height, winningStreak, num_games * 1000);
+        return;
+    }
+
+    if (bench_playout) {
+        bench_playouts(width, height, winningStreak, num_games * 100);
+        return;
+    }
+
+    if (solve_moves) {
+        solve_exact(width, height, winningStreak, solve_moves, exact_method);
+        return;
+    }
+
+    if (bench_exact_file) {
+        bench_exact(width, height, winningStreak, bench_exact_file);
+        return;
+    }
+
+    if (text_protocol) {
+        TextProtocol protocol(width, height, winningStreak, maxDepth);
+        protocol.run(cin, cout);
+        return;
+    }
+
+    if (serve_path || serve_port) {
+        // Tables are aged between requests instead of cleared
+        EvalConfig::setKeepTranspositions(true);
+        Engine::Limits limits;
+        limits.depth = maxDepth;
+        limits.seconds = time_limit;
+        EngineServer server(width, height, winningStreak, limits, num_threads);
+        if (serve_path) server.serveUnix(serve_path);
+        else server.serveTcp(serve_port);
+        return;
+    }
+
+    if (bench_cancels) {
+        bench_cancel(width, height, winningStreak, num_games * 10);
+        return;
+    }
+
+    if (analyze_file) {
+        analyze_positions(width, height, winningStreak, analyze_file, maxDepth, time_limit,
+                          num_threads);
+        return;
+    }
+
+    if (build_book) {
+        BookBuilder::build(build_book, width, height, winningStreak, book_plies, maxDepth);
+        return;
+    }
+
+    if (self_play) {
+        self_play_options.games = num_games;
+        self_play_options.searchDepth = maxDepth;
+        self_play_options.threads = num_threads;
+        SelfPlay::generate(self_play, width, height, winningStreak, self_play_options);
+        return;
+    }
+
+    if (tune_prefix) {
+        EvalTuner::Options tune_options;
+        tune_options.threads = num_threads;
+        EvalTuner::tune(tune_prefix, std::string(tune_prefix) + ".weights", tune_options);
+        return;
+    }
+
+    if (build_tablebase) {
+        Tablebase::generate(build_tablebase, width, height, winningStreak);
+        return;
+    }
+
     if (time_seq) {
         test_seq_timing(width, height, winningStreak);
 	return;
@@ -224,6 +655,16 @@ void parser(int argc, char** argv) {
                                 winningStreak, num_games);
         return;
     }
+    else if(mcts_vs_seq) {
+        tournament_mcts_vs_seq(p1, time_limit, maxDepth, width, height,
+                               winningStreak, num_games);
+        return;
+    }
+    else if(mcts_vs_omp) {
+        tournament_mcts_vs_omp(p1, time_limit, maxDepth, width, height,
+                               winningStreak, num_games);
+        return;
+    }
     else if(human_vs_seq) {
         cout << "You are playing the sequential solver SLO-MO! Prepare to be owned (slowly)!\n";
         tournament_human_vs_seq(p1, time_limit, maxDepth, width, height, 
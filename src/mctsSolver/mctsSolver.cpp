@@ -0,0 +1,345 @@
+#include "mctsSolver.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <iostream>
+#include <omp.h>
+
+namespace
+{
+    // Visits a walk adds to every node on its way down, taken back when its
+    // result is backed up
+    constexpr int kVirtualLoss = 3;
+    // UCT exploration constant for win rates in [0, 1]
+    constexpr double kExploration = 1.0;
+
+    inline uint64_t nextRandom(uint64_t& state) {
+        // xorshift64*
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1Dull;
+    }
+}
+
+MctsSolver::MctsSolver(uint_fast8_t width, uint_fast8_t height,
+                       uint_fast8_t winningStreakSize):
+                       _width(width), _height(height), _streak(winningStreakSize),
+                       _timeLimit(-1), _arenaUsed(0), _seed(0x9E3779B97F4A7C15ull) {
+    _ownedBoard.reset(new Board(width, height, winningStreakSize));
+    _board = _ownedBoard.get();
+    _arena.reset(new Node[kArenaNodes]);
+    if(PlayoutBatch::supportsGeometry(width, height, winningStreakSize))
+        _playoutBatch.reset(new PlayoutBatch(width, height, winningStreakSize));
+}
+
+bool MctsSolver::supportsGeometry(int width, int height, int winningStreakSize) {
+    // Lines are found with shifts of up to (streak - 1) * (height + 2) bits
+    return width > 0 && height > 0 && width * (height + 1) <= 128 && width <= 64 &&
+           winningStreakSize >= 2 && (winningStreakSize - 1) * (height + 2) < 128;
+}
+
+int MctsSolver::solve(Player player, int maxDepth, double timeLimit) {
+    _lastColumn = -1;
+    if(_board->DetermineWinner() != Player::None) return -1;
+    if(_board->IsFull()) {
+        std::cout << "Board is full" << std::endl;
+        return -1;
+    }
+
+    _nodesTraversed = 0;
+    _timeLimit = timeLimit;
+    int retval = -1;
+    int bestMove = _board->tablebaseMove(player);
+    if(bestMove < 0) bestMove = _board->bookMove(player);
+    if(bestMove < 0) bestMove = this->findBestMove(_board->getBoard(), player, maxDepth);
+
+    if(bestMove > -1) {
+        _board->playMove(bestMove, _board->getPlayerColor(player));
+        retval = bestMove % _width;
+        _lastColumn = retval;
+    }
+    if(_board->DetermineWinner() != Player::None) return -1;
+    _totalNodesTraversed += _nodesTraversed;
+    return retval;
+}
+
+int MctsSolver::findBestMove(SlotStatus* board, Player player, int maxDepth) {
+    const State root = stateFromBoard(board, player);
+    uint64_t legal = 0;
+    for(int c = 0; c < _width; c++)
+        if(canPlay(root, c)) legal |= uint64_t(1) << c;
+    if(!legal) return -1;
+
+    // Play a win right away, and keep out of the moves that hand the
+    // opponent one unless every move does
+    uint64_t safe = 0;
+    for(int c = 0; c < _width; c++) {
+        if(!(legal & (uint64_t(1) << c))) continue;
+        if(isWin(root.own | moveBit(root, c))) { safe = uint64_t(1) << c; break; }
+        State next = root;
+        this->play(next, c);
+        if(minimax(next, 1, false) != INT_MIN) safe |= uint64_t(1) << c;
+    }
+    uint64_t columns = safe ? safe : legal;
+
+    int column = -1;
+    if(__builtin_popcountll(columns) == 1) {
+        column = __builtin_ctzll(columns);
+    }
+    else {
+        _arenaUsed = 0;
+        Node& rootNode = _arena[allocate(1)];
+        rootNode.visits = 0;
+        rootNode.score = 0;
+        rootNode.expansion = kLeaf;
+        rootNode.terminal = kOpen;
+        expand(rootNode, root, columns);
+
+        const bool timed = _timeLimit > 0;
+        const int64_t budget = (int64_t)std::max(maxDepth, 1) * kPlayoutsPerDepth;
+        const auto deadline = std::chrono::high_resolution_clock::now() +
+            std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+                std::chrono::duration<double>(timed ? _timeLimit : 0));
+        std::atomic<int64_t> playouts(0);
+        _seed = nextRandom(_seed);
+
+        #pragma omp parallel
+        {
+            uint64_t rng = _seed ^ (0x9E3779B97F4A7C15ull * (omp_get_thread_num() + 1));
+            while(true) {
+                if(timed) {
+                    if(std::chrono::high_resolution_clock::now() >= deadline) break;
+                }
+                else if(playouts.load(std::memory_order_relaxed) >= budget) break;
+                playouts.fetch_add(iterate(root, rng), std::memory_order_relaxed);
+            }
+        }
+        _nodesTraversed += playouts.load();
+
+        // The most visited move is the most reliable one
+        int32_t bestVisits = -1;
+        for(int i = 0; i < rootNode.numChildren; i++) {
+            const Node& child = _arena[rootNode.firstChild + i];
+            if(child.visits.load() > bestVisits) {
+                bestVisits = child.visits.load();
+                column = child.column;
+            }
+        }
+    }
+
+    for(int row = _height - 1; row >= 0; row--) {
+        int index = row * _width + column;
+        if(board[index] == SlotStatus::Empty) return index;
+    }
+    return -1;
+}
+
+int MctsSolver::minimax(SlotStatus* board, int depth, Player player, bool maximizer) {
+    // The state is built for the player to move
+    Player toMove = maximizer ? player : PlayerHelpers::OppositePlayer(player);
+    return minimax(stateFromBoard(board, toMove), depth, maximizer);
+}
+
+int MctsSolver::minimax(const State& state, int depth, bool maximizer) const {
+    if(depth == 0 || state.plies == _width * _height) return 0;
+    bool anyOpen = false;
+    bool allLost = true;
+    for(int c = 0; c < _width; c++) {
+        if(!canPlay(state, c)) continue;
+        if(isWin(state.own | moveBit(state, c))) return maximizer ? INT_MAX : INT_MIN;
+        if(depth == 1) { allLost = false; continue; }
+        State next = state;
+        this->play(next, c);
+        int value = minimax(next, depth - 1, !maximizer);
+        // Scores are for the maximizer, the player to move wants its own
+        // side of them
+        int good = maximizer ? INT_MAX : INT_MIN;
+        int bad = maximizer ? INT_MIN : INT_MAX;
+        if(value == good) return good;
+        if(value != bad) allLost = false;
+        anyOpen = true;
+    }
+    if(anyOpen && allLost) return maximizer ? INT_MIN : INT_MAX;
+    return 0;
+}
+
+void MctsSolver::printStats() {
+    std::cout << "Total playouts: " << _nodesTraversed << std::endl;
+    std::cout << "Tree nodes: " << _arenaUsed.load() << " of " << kArenaNodes << std::endl;
+}
+
+MctsSolver::State MctsSolver::stateFromBoard(const SlotStatus* board, Player player) const {
+    State state = {0, 0, 0};
+    const SlotStatus own = (player == Player::Red) ? SlotStatus::Red : SlotStatus::Yellow;
+    for(int row = 0; row < _height; row++) {
+        for(int c = 0; c < _width; c++) {
+            SlotStatus slot = board[row * _width + c];
+            if(slot == SlotStatus::Empty) continue;
+            // Row 0 of the board is the top, bit 0 of a column its bottom
+            Bits bit = Bits(1) << (c * (_height + 1) + (_height - 1 - row));
+            state.mask |= bit;
+            if(slot == own) state.own |= bit;
+            ++state.plies;
+        }
+    }
+    return state;
+}
+
+bool MctsSolver::canPlay(const State& state, int column) const {
+    return !(state.mask & (Bits(1) << (column * (_height + 1) + _height - 1)));
+}
+
+MctsSolver::Bits MctsSolver::moveBit(const State& state, int column) const {
+    Bits columnMask = ((Bits(1) << _height) - 1) << (column * (_height + 1));
+    return (state.mask + (Bits(1) << (column * (_height + 1)))) & columnMask;
+}
+
+void MctsSolver::play(State& state, int column) const {
+    // After the move the pieces of the other player are the ones to move
+    Bits bit = moveBit(state, column);
+    state.own ^= state.mask;
+    state.mask |= bit;
+    ++state.plies;
+}
+
+bool MctsSolver::isWin(Bits pieces) const {
+    // Vertical, horizontal and both diagonals. The empty sentinel row keeps
+    // the shifted lines from wrapping into the next column.
+    const int steps[4] = {1, _height + 1, _height, _height + 2};
+    for(int d = 0; d < 4; d++) {
+        Bits line = pieces;
+        for(int k = 1; k < _streak && line; k++) line &= pieces >> (k * steps[d]);
+        if(line) return true;
+    }
+    return false;
+}
+
+uint32_t MctsSolver::allocate(int count) {
+    uint32_t used = _arenaUsed.load(std::memory_order_relaxed);
+    do {
+        if(used + count > kArenaNodes) return UINT32_MAX;
+    } while(!_arenaUsed.compare_exchange_weak(used, used + count, std::memory_order_relaxed));
+    return used;
+}
+
+bool MctsSolver::expand(Node& node, const State& state, uint64_t columns) {
+    int count = __builtin_popcountll(columns);
+    uint32_t first = allocate(count);
+    if(first == UINT32_MAX) {
+        node.expansion.store(kLeaf, std::memory_order_release);
+        return false;
+    }
+    int i = 0;
+    for(; columns; columns &= columns - 1, i++) {
+        int c = __builtin_ctzll(columns);
+        Node& child = _arena[first + i];
+        child.visits.store(0, std::memory_order_relaxed);
+        child.score.store(0, std::memory_order_relaxed);
+        child.expansion.store(kLeaf, std::memory_order_relaxed);
+        child.column = c;
+        child.numChildren = 0;
+        child.firstChild = 0;
+        if(isWin(state.own | moveBit(state, c))) child.terminal = kWon;
+        else if(state.plies + 1 == _width * _height) child.terminal = kDrawn;
+        else child.terminal = kOpen;
+    }
+    node.firstChild = first;
+    node.numChildren = count;
+    node.expansion.store(kExpanded, std::memory_order_release);
+    return true;
+}
+
+int MctsSolver::iterate(const State& root, uint64_t& rng) {
+    // Longest walk is one node per slot plus the root
+    Node* path[129];
+    int length = 0;
+    State state = root;
+    Node* node = &_arena[0];
+    path[length++] = node;
+
+    // Selection
+    while(node->terminal == kOpen && node->expansion.load(std::memory_order_acquire) == kExpanded) {
+        const int32_t parentVisits = node->visits.load(std::memory_order_relaxed);
+        const double logVisits = std::log((double)std::max(parentVisits, 1));
+        Node* best = nullptr;
+        double bestValue = -1;
+        for(int i = 0; i < node->numChildren; i++) {
+            Node* child = &_arena[node->firstChild + i];
+            int32_t visits = child->visits.load(std::memory_order_relaxed);
+            if(visits == 0) { best = child; break; }
+            double value = child->score.load(std::memory_order_relaxed) / (2.0 * visits) +
+                           kExploration * std::sqrt(logVisits / visits);
+            if(value > bestValue) {
+                bestValue = value;
+                best = child;
+            }
+        }
+        best->visits.fetch_add(kVirtualLoss, std::memory_order_relaxed);
+        this->play(state, best->column);
+        node = best;
+        path[length++] = node;
+    }
+
+    // Result in half points for the player to move at the node. Decided
+    // nodes count as many games as a leaf valued by playouts.
+    const int games = _playoutBatch ? kLeafPlayouts : 1;
+    int result;
+    if(node->terminal == kWon) result = 0;
+    else if(node->terminal == kDrawn) result = games;
+    else {
+        // Leaves are expanded on their second visit, a single walk claims it
+        uint8_t leaf = kLeaf;
+        if(node->visits.load(std::memory_order_relaxed) > kVirtualLoss &&
+           node->expansion.compare_exchange_strong(leaf, kExpanding, std::memory_order_acq_rel)) {
+            uint64_t columns = 0;
+            for(int c = 0; c < _width; c++)
+                if(canPlay(state, c)) columns |= uint64_t(1) << c;
+            expand(*node, state, columns);
+        }
+        result = _playoutBatch ? batchPlayout(state, rng) : playout(state, rng);
+    }
+
+    // Backup, the points alternate between the players on the way up
+    for(int i = length - 1; i >= 0; i--) {
+        result = 2 * games - result;
+        path[i]->score.fetch_add(result, std::memory_order_relaxed);
+        path[i]->visits.fetch_add(i == 0 ? games : games - kVirtualLoss, std::memory_order_relaxed);
+    }
+    return games;
+}
+
+int MctsSolver::playout(State state, uint64_t& rng) const {
+    const int numSlots = _width * _height;
+    const int startPlies = state.plies;
+    int columns[64];
+    while(state.plies < numSlots) {
+        int count = 0;
+        for(int c = 0; c < _width; c++)
+            if(canPlay(state, c)) columns[count++] = c;
+        int c = columns[nextRandom(rng) % count];
+        if(isWin(state.own | moveBit(state, c)))
+            return ((state.plies - startPlies) & 1) ? 0 : 2;
+        this->play(state, c);
+    }
+    return 1;
+}
+
+int MctsSolver::batchPlayout(const State& state, uint64_t& rng) const {
+    // The kernel takes row major boards and does not care about the colors,
+    // the player to move plays red
+    Position position;
+    for(int c = 0; c < _width; c++) {
+        for(int row = 0; row < _height; row++) {
+            Bits bit = Bits(1) << (c * (_height + 1) + (_height - 1 - row));
+            if(!(state.mask & bit)) continue;
+            uint64_t slot = uint64_t(1) << (row * _width + c);
+            if(state.own & bit) position.red |= slot;
+            else position.yellow |= slot;
+        }
+    }
+    PlayoutCounts counts;
+    _playoutBatch->run(&position, 1, kLeafPlayouts, nextRandom(rng), &counts);
+    return 2 * counts.wins + counts.draws;
+}
@@ -0,0 +1,149 @@
+/**
+ * @defgroup   MCTS_SOLVER
+ *
+ * @brief      Monte Carlo Tree Search (UCT) solver for Connect-4. Instead of
+ * a depth limited search around EvaluateBoard, positions are valued by the
+ * outcome of random games played to the end, which keeps working on wide
+ * boards and long streaks where the minimax horizon is too shallow.
+ *
+ * The tree lives in a fixed arena of nodes; the children of a node are one
+ * contiguous block handed out by an atomic bump allocator. The search is tree
+ * parallel: OpenMP workers walk the shared tree at the same time, and every
+ * node on a walk carries a virtual loss until its result is backed up, which
+ * spreads the workers over different lines. Playouts run on column major
+ * bitboards with a sentinel row, held in 128 bits so boards larger than the
+ * 64 slot limit of the minimax solvers fit. Boards that fit in 64 bits
+ * value every new leaf with a block of games from the batched PlayoutBatch
+ * kernel instead of a single one.
+ *
+ * @date       2021
+ */
+#ifndef __MCTS_SOLVER__
+#define __MCTS_SOLVER__
+
+#include "gameTreeSearchSolver.hpp"
+#include "connectFourAssets/playoutKernel.hpp"
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <memory>
+
+class MctsSolver : public GameTreeSearchSolver
+{
+    public:
+        // Playouts per ply of --search-depth when there is no time limit
+        static constexpr int kPlayoutsPerDepth = 20000;
+        // Nodes in the arena, the tree stops growing when it is full
+        static constexpr uint32_t kArenaNodes = 1 << 21;
+        // Playouts per leaf when the batched kernel handles the geometry
+        static constexpr int kLeafPlayouts = PlayoutKernel::detail::kLanes;
+
+        /**
+         * @brief      Constructs a new instance.
+         */
+        MctsSolver(uint_fast8_t width = 7, uint_fast8_t height = 6,
+                   uint_fast8_t winningStreakSize = 4);
+
+        /**
+         * @brief      Determines if the geometry can be handled, which needs
+         * width * (height + 1) <= 128.
+         */
+        static bool supportsGeometry(int width, int height, int winningStreakSize);
+
+        /**
+         * @brief      Find the best move for a given game board
+         *
+         * @param[in]  player     The player
+         * @param[in]  maxDepth   Sets the playout budget when there is no time
+         * limit (kPlayoutsPerDepth per ply)
+         * @param[in]  timeLimit  The time limit, the search runs until it is
+         * used up
+         *
+         * @return     Returns the column for the best move, -1 if no move exists
+         */
+        int solve(Player player, int maxDepth, double timeLimit) override;
+
+        /**
+         * @brief      Finds the best move with the time limit of the last
+         * solve() call.
+         *
+         * @return     Returns the index (row major) of the best move on the board
+         */
+        int findBestMove(SlotStatus* board, Player player, int maxDepth) override;
+
+        /**
+         * @brief      Exact win/loss search used to filter the root moves. It
+         * only looks for wins, the search itself does the positional play.
+         *
+         * @return     INT_MAX if player can force a win within depth plies,
+         * INT_MIN if the opponent can, 0 otherwise
+         */
+        int minimax(SlotStatus* board, int depth, Player player, bool maximizer) override;
+
+        /**
+         * @brief      Prints statistics.
+         */
+        void printStats() override;
+
+    private:
+        typedef unsigned __int128 Bits;
+
+        // Position as seen by the player to move
+        struct State {
+            Bits own;
+            Bits mask;
+            int plies;
+        };
+
+        struct Node {
+            // Visits including the virtual losses of walks in flight
+            std::atomic<int32_t> visits;
+            // Half points (2 per win, 1 per draw) of the player who moved
+            // into the node
+            std::atomic<int32_t> score;
+            // Leaf, being expanded, or expanded
+            std::atomic<uint8_t> expansion;
+            uint8_t column;
+            // Open, won by the move into the node, or a draw
+            uint8_t terminal;
+            uint8_t numChildren;
+            uint32_t firstChild;
+        };
+
+        enum : uint8_t {kLeaf = 0, kExpanding, kExpanded};
+        enum : uint8_t {kOpen = 0, kWon, kDrawn};
+
+        State stateFromBoard(const SlotStatus* board, Player player) const;
+        bool canPlay(const State& state, int column) const;
+        Bits moveBit(const State& state, int column) const;
+        void play(State& state, int column) const;
+        bool isWin(Bits pieces) const;
+        int minimax(const State& state, int depth, bool maximizer) const;
+
+        // Allocates a block of nodes, UINT32_MAX when the arena is full
+        uint32_t allocate(int count);
+        // Creates the children of a node for the given columns
+        bool expand(Node& node, const State& state, uint64_t columns);
+        // One selection, expansion, playout and backup. Returns the number
+        // of playouts the leaf was valued with.
+        int iterate(const State& root, uint64_t& rng);
+        // Result of a random game, in half points for the player to move
+        int playout(State state, uint64_t& rng) const;
+        // Half points of kLeafPlayouts games played by the batched kernel
+        int batchPlayout(const State& state, uint64_t& rng) const;
+
+        int _width;
+        int _height;
+        int _streak;
+        double _timeLimit;
+        // The board _board points to
+        std::unique_ptr<Board> _ownedBoard;
+        std::unique_ptr<Node[]> _arena;
+        std::atomic<uint32_t> _arenaUsed;
+        // Null when the board does not fit the batched kernel
+        std::unique_ptr<PlayoutBatch> _playoutBatch;
+        uint64_t _seed;
+};
+
+#endif
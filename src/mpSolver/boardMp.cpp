@@ -129,21 +129,9 @@ bool BoardMp::determineIfPlayerIsWinner(Player player)
 
 void BoardMp::Reset()
 {
-    const uint_fast8_t totalSlots = this->width * this->height;
-#pragma omp parallel for schedule (static)	
-    for (uint_fast8_t i = 0; i < totalSlots; i++)
-    {
-        this->board[i] = SlotStatus::Empty;
-    }
-
-#pragma omp parallel for schedule (static)	
-    for (uint_fast8_t i = 0; i < this->width; i++)
-    {
-        this->next_row[i] = 0;
-    }
-
-    this->winner = Player::None;
-    this->isGameOver = false;
+    // The base class owns the dimensions and the position key. The width and
+    // height BoardMp redeclares are never initialized.
+    Board::Reset();
 }
 
 /**
@@ -154,91 +142,11 @@ void BoardMp::Reset()
  *
  */
 int BoardMp::EvaluateBoard(Player player) {
-    // Heuristics for finding the score of the current board
-    
-    /**
-     * SATVIK: This if-else could be avoided if we use simpler data structures 
-     * that can be complemented
-     */
-    SlotStatus color_for, color_against;
-    color_for = this->getPlayerColor(player);
-    if(player == Player::Red) { 
-        color_against = SlotStatus::Yellow;
-    }
-    else if (player == Player::Yellow) {
-        color_against = SlotStatus::Red;
-    }
-
-    // Determine if a leaf node has been reached- in this case, the score will
-    // be either INT_MAX or INT_MIN, depending on the winner.
-    Player winner = this->DetermineWinner();
-    if(winner == player) {
-        return INT_MAX;
-    }
-    else if(winner == this->oppPlayer(player)) {
-        return INT_MIN;
-    }
-    // Simple heuristic- find the streaks in the horizontal, vertical, and 
-    // diagonal directions.
-    // Early game stages may have very few or no streaks at all. A static map
-    // will serve as a better heuristic where the player who has more pieces in
-    // the center of the board is in a stronger position.
-    
-    /**
-     * Streaks of a longer length should have a higher impact on the score-
-     * An polynomial distribution can be used.
-     */
-
-    uint32_t score_for = 0;
-    uint32_t score_against = 0;
-    uint32_t val   = 0;
-    uint32_t score = 0;
-//#pragma omp parallel for reduction (+:score) 
-    for(int streak = this->winningStreakSize; streak >= 2; streak--) {
-        	score_for 	= this->checkStreak(color_for, streak);
-        	score_against 	= this->checkStreak(color_against, streak);
-        	score += (score_for - score_against) * streak * streak * streak;
-    }
-
-//#pragma omp parallel sections private(val) reduction(+:score)
-//    {
-//    #pragma omp section
-//	{
-//    	    val = this->checkStreakMp(color_for, 4); 
-//	    score += val*4*4*4;
-//        }
-//
-//    #pragma omp section
-//	 {
-//    	    val = this->checkStreakMp(color_for, 3); 
-//	    score += val*3*3*3;
-//	 }
-//    
-//    #pragma omp section
-//	 {
-//    	    val = this->checkStreakMp(color_for, 2); 
-//	    score += val*3*3*3;
-//	 }
-//
-//    #pragma omp section
-//	 {
-//	    val = this->checkStreakMp(color_against, 4);
-//	    score -= val*4*4*4;
-//	 }
-//
-//    #pragma omp section
-//	 {
-//	    val = this->checkStreakMp(color_against, 3);
-//	    score -= val*3*3*3;
-//	 }
-//
-//    #pragma omp section
-//	 {
-//	    val = this->checkStreakMp(color_against, 2);
-//	    score -= val*2*2*2;
-//	 }
-//    }
-    return score;
+    // Splitting the streak counts across OpenMP sections costs more than the
+    // counts themselves, so use the same vectorized kernel as the base board.
+    // Board::EvaluateBoard uses the base class geometry, which is the one that
+    // is actually initialized.
+    return Board::EvaluateBoard(player);
 }   
 
 uint32_t BoardMp::checkStreakMp(SlotStatus color, int streak) {
@@ -9,6 +9,8 @@
 #include <sstream>
 #include <omp.h>
 #include "mpSolver.hpp"
+#include "../connectFourAssets/evalConfig.hpp"
+#include "../connectFourAssets/zobrist.hpp"
 
 #define DEBUG 1
 
@@ -17,24 +19,55 @@
 								   GameTreeSearchSolver(), _nodesTraversed(0) {*/
 MpSolver::MpSolver(uint_fast8_t width, uint_fast8_t height,
 								   uint_fast8_t winningStreakSize):
-								   _nodesTraversed(0), _totalNodesTraversed(0) {
+								   _searchDepth(0), _lastScore(0), _lastColumn(-1), _stopSearch(false), _ponderReply(-1),
+								   _ponderMoves(0), _ponderHits(0), _nodesTraversed(0),
+								   _totalNodesTraversed(0) {
 	_boardMp = new BoardMp(width, height, winningStreakSize);
+	_leafBatch = nullptr;
+	_evalCache = nullptr;
+	_transpositions = nullptr;
+	if(EvalConfig::transpositionKb() > 0)
+		_transpositions = new TranspositionTable(EvalConfig::transpositionKb());
+	if(EvalConfig::evalCacheKb() > 0)
+		_evalCache = new EvalCache(EvalConfig::evalCacheKb());
+	if(LeafBatch::supportsGeometry(width, height, winningStreakSize)) {
+		_leafBatch = new LeafBatch(width, height, winningStreakSize);
+		if(_evalCache) _leafBatch->setEvalCache(_evalCache);
+	}
 	int max_thr = omp_get_max_threads();
 	printf("OpenMP initiated. Prepare for Doom. Max threads %d \n", max_thr);
 }
 
+MpSolver::~MpSolver() {
+	this->stopPondering();
+	delete _leafBatch;
+	delete _evalCache;
+	delete _transpositions;
+	delete _boardMp;
+}
+
 int MpSolver::solve(Player player, int maxDepth, double time_limit)
 {
+	this->stopPondering();
+	_lastColumn = -1;
     if (_boardMp->DetermineWinner() != Player::None) {
         return -1;
     }
 
 	_nodesTraversed = 0;
 	int retval = -1;
-	int bestMove = -1;
+	// Entries of earlier moves stay valid, they just age
+	if(_transpositions) _transpositions->newSearch();
+	// Small geometries are answered exactly by the tablebase, positions
+	// covered by the opening book without a search
+	int bestMove = _boardMp->tablebaseMove(player);
+	if(bestMove < 0) bestMove = _boardMp->bookMove(player);
 	auto nodesTraversed = _nodesTraversed;
 
-	if(time_limit > 0) {
+	if(bestMove > -1) {
+		// Tablebase or book move, nothing to search
+	}
+	else if(time_limit > 0) {
 		// Implement Iterative Deepening to adhere to a time limit per move
 		this->startTimer();
 		for (int depth = 2; this->isTimeLeft(time_limit); depth += 2) {
@@ -42,6 +75,7 @@ int MpSolver::solve(Player player, int maxDepth, double time_limit)
 			int move = this->findBestMove(_boardMp->getBoard(), player, depth, time_limit);
 			if(this->isTimeLeft(time_limit)) {
 				bestMove = move;
+				_searchDepth = depth;
 				nodesTraversed = _nodesTraversed;
 				_nodesTraversed = 0;
 			}
@@ -50,6 +84,7 @@ int MpSolver::solve(Player player, int maxDepth, double time_limit)
 	}
 	else {
 		bestMove = this->findBestMove(_boardMp->getBoard(), player, maxDepth, time_limit);
+		_searchDepth = maxDepth;
 	}
 
 	if(_boardMp->IsFull()) {
@@ -61,6 +96,7 @@ int MpSolver::solve(Player player, int maxDepth, double time_limit)
 		_boardMp->playMove(bestMove, this->getPlayerColor(player));
 		//this->printBoard();
 		retval = bestMove % _boardMp->getWidth();
+		_lastColumn = retval;
 	}
 
 	Player winner = _boardMp->DetermineWinner();
@@ -73,7 +109,17 @@ int MpSolver::solve(Player player, int maxDepth, double time_limit)
     return retval;
 }
 
-int MpSolver::findBestMove(SlotStatus* board, Player player, int maxDepth, double time_limit){
+int MpSolver::analyze(Player player, int maxDepth, int* score)
+{
+	this->stopPondering();
+	_nodesTraversed = 0;
+	int move = this->findBestMove(_boardMp->getBoard(), player, maxDepth, -1, score);
+	_totalNodesTraversed += _nodesTraversed;
+	return (move > -1) ? move % _boardMp->getWidth() : -1;
+}
+
+int MpSolver::findBestMove(SlotStatus* board, Player player, int maxDepth, double time_limit,
+						   int* bestScoreOut) {
 	// Will return the index of the best move in the board for the given player
 	// Return if the board is full
 	if(_boardMp->IsFull()) return -1;
@@ -82,25 +128,49 @@ int MpSolver::findBestMove(SlotStatus* board, Player player, int maxDepth, doubl
 	int move = -1;
 	int bestScore = INT_MIN;
 	bool empty_slot_avl = false;
+	_emptySlots = 0;
+	for(int i = 0; i < _boardMp->getWidth() * _boardMp->getHeight(); i++)
+		if(board[i] == SlotStatus::Empty) ++_emptySlots;
 
-	// Traverse through the board to find legal moves and see the maximum score
-	// Since the board fills from the last row, it's better to traverse the 
-	// board in a reverse order
-	for(int i = _boardMp->getWidth() * _boardMp->getHeight() - 1; (i >= 0) && 
-	                                                              	       this->isTimeLeft(time_limit) ; i--) {
-		if(board[i] == SlotStatus::Empty) {
-			if(!_boardMp->isLegalMove(i)) continue;
-			empty_slot_avl = true;
-			board[i] = color;
-			int score = this->minimax(board, maxDepth, player, false);
-			board[i] = SlotStatus::Empty;
-			++_nodesTraversed;
-			if(score > bestScore) {
-				move = i;
-				bestScore = score;
+	// On a position that is its own mirror image, a move and its mirrored
+	// move score the same under a symmetric heuristic, so only one of each
+	// pair is searched. The higher column is kept since it is the one the scan
+	// below settles ties on.
+	const int width = _boardMp->getWidth();
+	bool skipMirrored = _boardMp->isSymmetric() && _boardMp->evalMirrorSymmetric();
+
+	// The pruning drivers search the same tree with alpha-beta windows
+	EvalConfig::SearchDriver driver = EvalConfig::searchDriver();
+	if(driver != EvalConfig::SearchDriver::Minimax) {
+		bestScore = this->searchWithDriver(board, player, maxDepth, time_limit, driver, move);
+		empty_slot_avl = _emptySlots > 0;
+	}
+	else {
+		// Traverse through the board to find legal moves and see the maximum score
+		// Since the board fills from the last row, it's better to traverse the 
+		// board in a reverse order
+		for(int i = _boardMp->getWidth() * _boardMp->getHeight() - 1; (i >= 0) && 
+		                                                              	       this->isTimeLeft(time_limit) &&
+											!_stopSearch.load(std::memory_order_relaxed); i--) {
+			if(board[i] == SlotStatus::Empty) {
+				if(!_boardMp->isLegalMove(i)) continue;
+				empty_slot_avl = true;
+				if(skipMirrored && (i % width) < width - 1 - (i % width)) continue;
+				_boardMp->makeMove(i, color);
+				--_emptySlots;
+				int score = this->minimax(board, maxDepth, player, false, i);
+				++_emptySlots;
+				_boardMp->undoMove(i);
+				++_nodesTraversed;
+				if(score > bestScore) {
+					move = i;
+					bestScore = score;
+				}
 			}
 		}
 	}
+	if(this->isTimeLeft(time_limit) && !_stopSearch.load(std::memory_order_relaxed))
+		_lastScore = bestScore;
 	// This means that there is no move which can avoid defeat, so at this point
         // it doesn't really matter where the move is played
         if(move == -1 && empty_slot_avl) {
@@ -113,22 +183,194 @@ int MpSolver::findBestMove(SlotStatus* board, Player player, int maxDepth, doubl
         		}
         	}
         }
+	if(bestScoreOut) *bestScoreOut = bestScore;
 	return move;
 }
 
+int MpSolver::searchRoot(SlotStatus* board, Player player, int maxDepth, double time_limit,
+						 int alpha, int beta, int& move) {
+	SlotStatus color = this->getPlayerColor(player);
+	const int width = _boardMp->getWidth();
+	bool skipMirrored = _boardMp->isSymmetric() && _boardMp->evalMirrorSymmetric();
+	int bestScore = INT_MIN;
+	move = -1;
+
+	// Same scan order and tie break as the minimax root, so a search that
+	// ends inside its window picks the same move
+	for(int i = _boardMp->getWidth() * _boardMp->getHeight() - 1; (i >= 0) &&
+										this->isTimeLeft(time_limit) &&
+										!_stopSearch.load(std::memory_order_relaxed); i--) {
+		if(board[i] != SlotStatus::Empty || !_boardMp->isLegalMove(i)) continue;
+		if(skipMirrored && (i % width) < width - 1 - (i % width)) continue;
+		_boardMp->makeMove(i, color);
+		--_emptySlots;
+		int score = this->alphaBeta(board, maxDepth, player, false, i, std::max(alpha, bestScore), beta);
+		++_emptySlots;
+		_boardMp->undoMove(i);
+		++_nodesTraversed;
+		if(score > bestScore) {
+			move = i;
+			bestScore = score;
+			if(bestScore >= beta) break;
+		}
+	}
+	return bestScore;
+}
+
+int MpSolver::searchWithDriver(SlotStatus* board, Player player, int maxDepth, double time_limit,
+							   EvalConfig::SearchDriver driver, int& move) {
+	int bestScore = INT_MIN;
+	// The score of the last search is the first guess, a decided game is
+	// searched with the full window
+	int guess = _lastScore;
+	if(guess == INT_MIN || guess == INT_MAX) driver = EvalConfig::SearchDriver::AlphaBeta;
+
+	if(driver == EvalConfig::SearchDriver::Aspiration) {
+		// Widen the side the search failed on until the score falls inside
+		int64_t delta = kAspirationDelta;
+		int alpha = (int)std::max<int64_t>((int64_t)guess - delta, INT_MIN);
+		int beta = (int)std::min<int64_t>((int64_t)guess + delta, INT_MAX);
+		while(true) {
+			bestScore = this->searchRoot(board, player, maxDepth, time_limit, alpha, beta, move);
+			if(!this->isTimeLeft(time_limit) || _stopSearch.load(std::memory_order_relaxed)) break;
+			delta *= 4;
+			if(bestScore <= alpha && alpha > INT_MIN)
+				alpha = (int)std::max<int64_t>((int64_t)guess - delta, INT_MIN);
+			else if(bestScore >= beta && beta < INT_MAX)
+				beta = (int)std::min<int64_t>((int64_t)guess + delta, INT_MAX);
+			else
+				break;
+		}
+	}
+	else if(driver == EvalConfig::SearchDriver::Mtdf) {
+		// Null window searches move the bounds towards the score until they
+		// meet. The move is the one of the last search that failed high, the
+		// first move reaching the final lower bound.
+		int lower = INT_MIN;
+		int upper = INT_MAX;
+		int g = guess;
+		move = -1;
+		while(lower < upper) {
+			int beta = (g == lower) ? g + 1 : g;
+			int found;
+			g = this->searchRoot(board, player, maxDepth, time_limit, beta - 1, beta, found);
+			if(!this->isTimeLeft(time_limit) || _stopSearch.load(std::memory_order_relaxed)) break;
+			if(g < beta) upper = g;
+			else {
+				lower = g;
+				move = found;
+			}
+		}
+		bestScore = lower;
+	}
+	else {
+		bestScore = this->searchRoot(board, player, maxDepth, time_limit, INT_MIN, INT_MAX, move);
+	}
+	return bestScore;
+}
+
+int MpSolver::alphaBeta(SlotStatus* board, int depth, Player player, bool maximizer,
+						int lastMove, int alpha, int beta) {
+	if(_boardMp->isWinningMove(lastMove))
+		return (board[lastMove] == this->getPlayerColor(player)) ? INT_MAX : INT_MIN;
+
+	if(_emptySlots == 0 || depth == 0)
+		return this->evaluateLeaf(player);
+
+	// Exact values fit any window
+	if(_leafBatch && depth <= LeafBatch::kMaxDepth)
+		return _leafBatch->minimax(board, _boardMp->key(), _boardMp->mirrorKey(), depth, player,
+								   maximizer, _nodesTraversed);
+
+	if(_stopSearch.load(std::memory_order_relaxed)) return 0;
+
+	// Shares the entries of minimax, exact values and bounds that already
+	// decide the window end the search of the node
+	uint64_t nodeKey = 0;
+	if(_transpositions && depth >= TranspositionTable::kMinDepth) {
+		nodeKey = Zobrist::nodeKey(_boardMp->evalMirrorSymmetric() ? _boardMp->canonicalKey() : _boardMp->key(),
+								   player, maximizer);
+		int value;
+		if(_transpositions->probe(nodeKey, depth, alpha, beta, value)) return value;
+	}
+
+	const int alphaOrig = alpha;
+	const int betaOrig = beta;
+	SlotStatus color = this->getPlayerColor(maximizer ? player : this->oppPlayer(player));
+	int bestScore = maximizer ? INT_MIN : INT_MAX;
+	for(int i = _boardMp->getWidth() * _boardMp->getHeight() - 1; i >= 0 && alpha < beta; i--) {
+		if(board[i] != SlotStatus::Empty || !_boardMp->isLegalMove(i)) continue;
+		_boardMp->makeMove(i, color);
+		--_emptySlots;
+		int score = this->alphaBeta(board, depth - 1, player, !maximizer, i, alpha, beta);
+		++_emptySlots;
+		_boardMp->undoMove(i);
+		++_nodesTraversed;
+		if(maximizer) {
+			bestScore = std::max(score, bestScore);
+			alpha = std::max(alpha, score);
+		}
+		else {
+			bestScore = std::min(score, bestScore);
+			beta = std::min(beta, score);
+		}
+	}
+
+	// Fail soft, a score outside the window only bounds the value
+	if(nodeKey && !_stopSearch.load(std::memory_order_relaxed)) {
+		TranspositionTable::Bound bound = TranspositionTable::Bound::Exact;
+		if(bestScore <= alphaOrig) bound = TranspositionTable::Bound::Upper;
+		else if(bestScore >= betaOrig) bound = TranspositionTable::Bound::Lower;
+		_transpositions->store(nodeKey, depth, bestScore, bound);
+	}
+	return bestScore;
+}
+
+int MpSolver::evaluateLeaf(Player player) {
+	if(!_evalCache) return _boardMp->EvaluateBoard(player);
+	// Keyed like the leaves of the leaf batch, so both share entries
+	uint64_t key = Zobrist::scoredKey(_boardMp->evalMirrorSymmetric() ? _boardMp->canonicalKey() : _boardMp->key(), player);
+	int score;
+	if(_evalCache->probe(key, score)) return score;
+	score = _boardMp->EvaluateBoard(player);
+	_evalCache->store(key, score);
+	return score;
+}
+
 int MpSolver::minimax(SlotStatus* board, int depth, Player player, 
-								bool maximizer) {
+								bool maximizer, int lastMove) {
+	// The search stops at the first win, so only the last move can have
+	// ended the game. Checking the lines through it is all the interior nodes
+	// need, the heuristic only runs at the leaves.
+	if(_boardMp->isWinningMove(lastMove))
+		return (board[lastMove] == this->getPlayerColor(player)) ? INT_MAX : INT_MIN;
+
 	// Board evaluations are static: The player won't change, it will always be
 	// the maximizer wrt whom the score will be calculated.
-	int score = _boardMp->EvaluateBoard(player);
+	if(_emptySlots == 0 || depth == 0)
+		return this->evaluateLeaf(player);
 
-	if(score == INT_MAX || score == INT_MIN) // someone has won already
-		return score;
+	// The last plies are generated and scored as one block, which gives the
+	// same value as the node by node search below
+	if(_leafBatch && depth <= LeafBatch::kMaxDepth)
+		return _leafBatch->minimax(board, _boardMp->key(), _boardMp->mirrorKey(), depth, player,
+								   maximizer, _nodesTraversed);
 
-	if(_boardMp->IsFull()) return score;
+	// Pondering was stopped, unwind without storing anything
+	if(_stopSearch.load(std::memory_order_relaxed)) return 0;
 
-	if(depth == 0) return score;
+	// Values are exact, so any stored value for the same node and depth can
+	// be returned as is. Mirror images share entries when the heuristic is
+	// symmetric.
+	uint64_t nodeKey = 0;
+	if(_transpositions && depth >= TranspositionTable::kMinDepth) {
+		nodeKey = Zobrist::nodeKey(_boardMp->evalMirrorSymmetric() ? _boardMp->canonicalKey() : _boardMp->key(),
+								   player, maximizer);
+		int value;
+		if(_transpositions->probe(nodeKey, depth, value)) return value;
+	}
 
+	int score;
 	SlotStatus color;
 	if(maximizer) 
 		color = (player == Player::Red)?(SlotStatus::Red):(SlotStatus::Yellow);
@@ -141,14 +383,18 @@ int MpSolver::minimax(SlotStatus* board, int depth, Player player,
 		for(int i = _boardMp->getWidth() * _boardMp->getHeight() - 1; i >= 0 ; i--) {
 			if(board[i] == SlotStatus::Empty) {
 				if(_boardMp->isLegalMove(i)) {
-					board[i] = color;
-					score = this->minimax(board, depth - 1, player, !maximizer);
+					_boardMp->makeMove(i, color);
+					--_emptySlots;
+					score = this->minimax(board, depth - 1, player, !maximizer, i);
+					++_emptySlots;
 					bestScore = std::max(score, bestScore);
-					board[i] = SlotStatus::Empty;
+					_boardMp->undoMove(i);
 					++_nodesTraversed;
 				}
 			}
 		}
+		if(nodeKey && !_stopSearch.load(std::memory_order_relaxed))
+			_transpositions->store(nodeKey, depth, bestScore);
 		return bestScore;
 	}
 	else {
@@ -157,27 +403,45 @@ int MpSolver::minimax(SlotStatus* board, int depth, Player player,
 		for(int i = _boardMp->getWidth() * _boardMp->getHeight() - 1; i >= 0 ; i--) {
 			if(board[i] == SlotStatus::Empty) {
 				if(_boardMp->isLegalMove(i)) {
-					board[i] = color;
-					score = this->minimax(board, depth - 1, player, !maximizer);
+					_boardMp->makeMove(i, color);
+					--_emptySlots;
+					score = this->minimax(board, depth - 1, player, !maximizer, i);
+					++_emptySlots;
 					bestScore = std::min(bestScore, score);
-					board[i] = SlotStatus::Empty;
+					_boardMp->undoMove(i);
 					++_nodesTraversed;
 				}
 			}
 		}
+		if(nodeKey && !_stopSearch.load(std::memory_order_relaxed))
+			_transpositions->store(nodeKey, depth, bestScore);
 		return bestScore;
 	}
 }
 
 void MpSolver::printBoard() {
+	this->stopPondering();
 	_boardMp->printBoard();
 }
 
 void MpSolver::printStats() {
 	std::cout << "Total Nodes traversed: " << _nodesTraversed << std::endl;
+	if(_evalCache)
+		std::cout << "Eval cache hit rate: " << 100.0 * _evalCache->hitRate() << "% ("
+				  << _evalCache->hits() << "/" << _evalCache->probes() << ")" << std::endl;
+	if(_transpositions)
+		std::cout << "Transposition table hit rate: " << 100.0 * _transpositions->hitRate() << "% ("
+				  << _transpositions->hits() << "/" << _transpositions->probes() << ")" << std::endl;
 }
 
 int MpSolver::playMove(int column, Player player) {
+	if(_ponderThread.joinable()) {
+		this->stopPondering();
+		if(_ponderReply > -1) {
+			++_ponderMoves;
+			if(_ponderReply % _boardMp->getWidth() == column - 1) ++_ponderHits;
+		}
+	}
 	return _boardMp->playMove(column, player);
 }
 
@@ -213,7 +477,55 @@ uint64_t MpSolver::getTotalNodesTraversed() {
 }
 
 void MpSolver::resetSolver() {
+	this->stopPondering();
 	_nodesTraversed = 0;
 	_totalNodesTraversed = 0;
+	_lastScore = 0;
+	if(_evalCache) _evalCache->resetStats();
+	if(_transpositions) {
+		// A new game ages the table like a new move unless asked to start cold
+		if(EvalConfig::keepTranspositions()) _transpositions->newSearch();
+		else _transpositions->clear();
+		_transpositions->resetStats();
+	}
 	_boardMp->Reset();
 }
+
+double MpSolver::getEvalCacheHitRate() {
+	return _evalCache ? _evalCache->hitRate() : 0.0;
+}
+
+void MpSolver::startPondering(Player player, int maxDepth) {
+	this->stopPondering();
+	if(_boardMp->DetermineWinner() != Player::None || _boardMp->IsFull()) return;
+	_ponderReply = -1;
+	_ponderThread = std::thread(&MpSolver::ponder, this, player, maxDepth);
+}
+
+void MpSolver::stopPondering() {
+	if(!_ponderThread.joinable()) return;
+	_stopSearch = true;
+	_ponderThread.join();
+	_stopSearch = false;
+}
+
+void MpSolver::ponder(Player player, int maxDepth) {
+	SlotStatus* board = _boardMp->getBoard();
+	Player opponent = this->oppPlayer(player);
+	// The searches score other positions than the last solve(), whose score
+	// stays the first guess of the next one
+	const int lastScore = _lastScore;
+	int reply = this->findBestMove(board, opponent, std::max(2, _searchDepth - 2), -1);
+	if(reply >= 0 && !_stopSearch) {
+		// Search the answer to the predicted reply on the solver's own board,
+		// the reply is taken back before the thread finishes
+		_boardMp->makeMove(reply, this->getPlayerColor(opponent));
+		if(!_boardMp->isWinningMove(reply) && !_boardMp->IsFull()) {
+			_ponderReply = reply;
+			for(int depth = 2; depth <= maxDepth && !_stopSearch; depth += 2)
+				this->findBestMove(board, player, depth, -1);
+		}
+		_boardMp->undoMove(reply);
+	}
+	_lastScore = lastScore;
+}
@@ -10,11 +10,16 @@
 #define __MP_SOLVER__
 
 #include "boardMp.hpp"
+#include "../connectFourAssets/evalConfig.hpp"
+#include "../connectFourAssets/leafBatch.hpp"
+#include "../connectFourAssets/transpositionTable.hpp"
 //#include "gameTreeSearchSolver.hpp"
+#include <atomic>
 #include <climits>
 #include <chrono>
 #include <iostream>
 #include <sstream>
+#include <thread>
 
 //class MpSolver : GameTreeSearchSolver
 class MpSolver
@@ -26,6 +31,11 @@ class MpSolver
     	MpSolver(uint_fast8_t width = 7, uint_fast8_t height = 6,
     					 uint_fast8_t winningStreakLength = 4);
 
+        /**
+         * @brief      Stops pondering before the solver goes away.
+         */
+        ~MpSolver();
+
         /**
          * @brief     Find the best move for a given game board
          *
@@ -37,6 +47,17 @@ class MpSolver
          */
         int solve(Player player, int maxDepth = 6, double time_limit = -1);
 
+        /**
+         * @brief      Searches the current position without playing the move.
+         *
+         * @param[in]  player    The player to move
+         * @param[in]  maxDepth  The depth of the search
+         * @param      score     Set to the score of the best move
+         *
+         * @return     Returns the column for the best move, -1 if no move exists
+         */
+        int analyze(Player player, int maxDepth, int* score);
+
         /**
          * @brief      Finds the best move.
          *
@@ -44,10 +65,12 @@ class MpSolver
          * @param[in]  player     The player
          * @param[in]  maxDepth   The maximum depth for the search
          * @param[in]  time_limit The maximum time limit for the search
+         * @param      bestScore  Set to the score of the best move if not null
          *
          * @return     Returns the index (row major) of the best move on the board
          */
-        int findBestMove(SlotStatus* board, Player player, int maxDepth, double time_limit);
+        int findBestMove(SlotStatus* board, Player player, int maxDepth, double time_limit,
+                         int* bestScore = nullptr);
 
         /**
          * @brief      Finds the opponent for the given player
@@ -74,10 +97,44 @@ class MpSolver
          * @param[in]  depth      The depth
          * @param[in]  player     The player
          * @param[in]  maximizer  The maximizer
+         * @param[in]  lastMove   The index of the move that led to this node
          *
          * @return     Returns the best possible score for the current player
          */
-        int minimax(SlotStatus* board, int depth, Player player, bool maximizer);
+        int minimax(SlotStatus* board, int depth, Player player, bool maximizer,
+                    int lastMove);
+
+        /**
+         * @brief      Alpha-beta search of the game tree, fail soft. Returns
+         * the minimax value when it lies inside the window, otherwise a bound
+         * on the wrong side of it.
+         *
+         * @param      board      The board
+         * @param[in]  depth      The depth
+         * @param[in]  player     The player
+         * @param[in]  maximizer  The maximizer
+         * @param[in]  lastMove   The index of the move that led to this node
+         * @param[in]  alpha      The score the maximizer is already sure of
+         * @param[in]  beta       The score the minimizer is already sure of
+         *
+         * @return     Returns the score of the node for the current player
+         */
+        int alphaBeta(SlotStatus* board, int depth, Player player, bool maximizer,
+                      int lastMove, int alpha, int beta);
+
+        // Evaluation of the board at the search horizon, through the eval
+        // cache when there is one
+        int evaluateLeaf(Player player);
+
+        // Column (0 based) the last solve() played, also when the move ended
+        // the game and solve() returned -1. -1 if no move was played.
+        int getLastColumn() { return _lastColumn; }
+
+        // Depth of the last completed search, the nodes it traversed and the
+        // score it found
+        int getSearchDepth() { return _searchDepth; }
+        uint64_t getNodesTraversed() { return _nodesTraversed; }
+        int getLastScore() { return _lastScore; }
 
         /**
          * @brief      Prints the board.
@@ -101,6 +158,19 @@ class MpSolver
          */
         uint64_t getTotalNodesTraversed();
 
+        /**
+         * @brief      Gets the winner of the current game.
+         */
+        Player getWinner() { return _boardMp->DetermineWinner(); }
+
+        /**
+         * @brief      Gets the hit rate of the leaf evaluation cache since the
+         * last reset.
+         *
+         * @return     The hit rate in [0, 1], 0 when the cache is off.
+         */
+        double getEvalCacheHitRate();
+
         /**
          * @brief      Inserts a piece in the specified column
          *
@@ -125,8 +195,69 @@ class MpSolver
          */
         bool isTimeLeft(double seconds);
 
+        /**
+         * @brief      Searches in a background thread while the opponent
+         * thinks. The opponent's reply is predicted with a shorter search and
+         * the answer to it is searched with iterative deepening, which fills
+         * the transposition table and the evaluation cache. Every other call
+         * on the solver stops pondering first, so after a correct prediction
+         * solve() picks up the finished part of the search from the table.
+         *
+         * @param[in]  player    The player this solver plays
+         * @param[in]  maxDepth  The deepest search to ponder
+         */
+        void startPondering(Player player, int maxDepth);
+
+        /**
+         * @brief      Stops pondering and waits for the background search to
+         * unwind. Nothing the aborted search computed is stored.
+         */
+        void stopPondering();
+
+        // Moves played while pondering, and how many of them were predicted
+        uint64_t getPonderMoves() { return _ponderMoves; }
+        uint64_t getPonderHits() { return _ponderHits; }
+
     private:
+        // Body of the pondering thread
+        void ponder(Player player, int maxDepth);
+        // Searches the root moves with alpha-beta and the window, sets move to
+        // the best one and returns its score
+        int searchRoot(SlotStatus* board, Player player, int maxDepth, double time_limit,
+                       int alpha, int beta, int& move);
+        // Runs the root searches of a pruning driver (EvalConfig::searchDriver)
+        int searchWithDriver(SlotStatus* board, Player player, int maxDepth, double time_limit,
+                             EvalConfig::SearchDriver driver, int& move);
+
+        // Half width of the first aspiration window
+        static constexpr int kAspirationDelta = 64;
+
     	BoardMp* _boardMp;
+        // Scores the last plies of the search as one block, null if the
+        // geometry does not fit in a bitboard
+        LeafBatch* _leafBatch;
+        // Horizon evaluations reused across transpositions, shared with the
+        // leaf batch. Null when turned off with --eval-cache off
+        EvalCache* _evalCache;
+        // Interior node values kept across moves, null when turned off with
+        // --tt off
+        TranspositionTable* _transpositions;
+        // Empty slots left on the searched board, kept up to date by the search
+        int _emptySlots;
+        // Depth of the last search solve() completed, pondering predicts
+        // replies two plies shallower
+        int _searchDepth;
+        // Score of the last completed search, the first guess of the
+        // aspiration and MTD(f) drivers
+        int _lastScore;
+        int _lastColumn;
+        std::thread _ponderThread;
+        // Set to make the pondering search unwind
+        std::atomic<bool> _stopSearch;
+        // Slot index of the reply being pondered on, -1 if none
+        int _ponderReply;
+        uint64_t _ponderMoves;
+        uint64_t _ponderHits;
     	uint64_t _nodesTraversed;
 	uint64_t _totalNodesTraversed;
 		std::chrono::high_resolution_clock::time_point _start;
@@ -0,0 +1,121 @@
+#include "bookBuilder.hpp"
+#include "sequentialSolver.hpp"
+#include "connectFourAssets/evalConfig.hpp"
+#include "connectFourAssets/openingBook.hpp"
+#include "connectFourAssets/zobrist.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+	// A position to search, stored as the columns (0-indexed) that lead to it
+	struct BookPosition {
+		std::vector<uint8_t> moves;
+		uint64_t key;
+		Player player;
+		// The position is the mirror image of the orientation it is keyed by
+		bool mirrored;
+	};
+
+	// Depth first walk over the game tree. A position that was already
+	// reached through another move order, or as a mirror image under a
+	// symmetric heuristic, has the same subtree (up to mirroring) and is not
+	// expanded again. The keys are the ones Board::bookMove looks up.
+	void enumerate(BoardSequential& board, std::vector<uint8_t>& moves, Player player,
+				   int plies, std::unordered_set<uint64_t>& seen,
+				   std::vector<BookPosition>& positions) {
+		uint64_t positionKey = board.evalMirrorSymmetric() ? board.canonicalKey() : board.key();
+		uint64_t key = Zobrist::scoredKey(positionKey, player);
+		if(!seen.insert(key).second) return;
+		if(board.IsFull()) return;
+		positions.push_back({moves, key, player, board.key() != positionKey});
+		if((int)moves.size() == plies) return;
+
+		const int width = board.getWidth();
+		const int height = board.getHeight();
+		SlotStatus* slots = board.getBoard();
+		SlotStatus color = board.getPlayerColor(player);
+		for(int column = 0; column < width; column++) {
+			for(int row = height - 1; row >= 0; row--) {
+				int index = row * width + column;
+				if(slots[index] != SlotStatus::Empty) continue;
+				board.makeMove(index, color);
+				// Games that are already decided need no book move
+				if(!board.isWinningMove(index)) {
+					moves.push_back(column);
+					enumerate(board, moves, board.oppPlayer(player), plies, seen, positions);
+					moves.pop_back();
+				}
+				board.undoMove(index);
+				break;
+			}
+		}
+	}
+}
+
+long BookBuilder::build(const std::string& path, int width, int height, int winningStreakSize,
+						int plies, int searchDepth) {
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::vector<BookPosition> positions;
+	{
+		BoardSequential board(width, height, winningStreakSize);
+		std::vector<uint8_t> moves;
+		std::unordered_set<uint64_t> seen;
+		enumerate(board, moves, Player::Red, plies, seen, positions);
+	}
+	std::cout << "Opening book: searching " << positions.size() << " positions up to ply "
+			  << plies << " at depth " << searchDepth << std::endl;
+
+	std::vector<BookEntry> entries(positions.size());
+	std::vector<char> found(positions.size(), 0);
+	#pragma omp parallel
+	{
+		// Every thread searches with its own solver, the positions are
+		// independent of each other
+		SequentialSolver solver(width, height, winningStreakSize);
+		#pragma omp for schedule(dynamic, 16)
+		for(long i = 0; i < (long)positions.size(); i++) {
+			const BookPosition& position = positions[i];
+			// The table is kept from position to position, the subtrees of
+			// neighbouring positions overlap
+			std::string moves;
+			for(uint8_t column : position.moves) moves += (char)('1' + column);
+			solver.setPosition(moves.c_str());
+			int score = 0;
+			int column = solver.analyze(position.player, searchDepth, &score);
+			if(column < 0) continue;
+			// Entries are stored for the orientation of the key
+			BookEntry& entry = entries[i];
+			entry.key = position.key;
+			entry.score = score;
+			entry.column = position.mirrored ? width - 1 - column : column;
+			found[i] = 1;
+		}
+	}
+
+	size_t kept = 0;
+	for(size_t i = 0; i < entries.size(); i++)
+		if(found[i]) entries[kept++] = entries[i];
+	entries.resize(kept);
+
+	BookHeader header = {};
+	header.width = width;
+	header.height = height;
+	header.winningStreakSize = winningStreakSize;
+	header.plies = plies;
+	header.heuristic = (uint8_t)EvalConfig::heuristic();
+	header.canonicalKeys = EvalConfig::mirrorSymmetric(width, height, winningStreakSize);
+	header.searchDepth = searchDepth;
+	if(!OpeningBook::write(path, header, entries)) return -1;
+
+	std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+	std::cout << "Opening book: wrote " << entries.size() << " entries to " << path
+			  << " in " << elapsed.count() << " s" << std::endl;
+	return (long)entries.size();
+}
@@ -0,0 +1,36 @@
+/**
+ * @defgroup   BOOK_BUILDER
+ *
+ * @brief      Offline builder for the opening book. Every distinct position
+ * up to a number of plies is enumerated (transpositions, and mirror images
+ * under a symmetric heuristic, are visited once), searched with the
+ * sequential solver in parallel, and written out sorted by key for
+ * OpeningBook to map.
+ *
+ * @date       2021
+ */
+#ifndef __BOOK_BUILDER__
+#define __BOOK_BUILDER__
+
+#include <string>
+
+namespace BookBuilder
+{
+    /**
+     * @brief      Builds an opening book. Red is assumed to move first.
+     *
+     * @param[in]  path               The path of the book to write
+     * @param[in]  width              The width of the board
+     * @param[in]  height             The height of the board
+     * @param[in]  winningStreakSize  The winning streak size
+     * @param[in]  plies              Positions with up to this many pieces are
+     * searched
+     * @param[in]  searchDepth        The depth every position is searched to
+     *
+     * @return     The number of entries written, -1 on failure
+     */
+    long build(const std::string& path, int width, int height, int winningStreakSize,
+               int plies, int searchDepth);
+}
+
+#endif
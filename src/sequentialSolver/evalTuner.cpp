@@ -0,0 +1,200 @@
+#include "evalTuner.hpp"
+#include "connectFourAssets/board.hpp"
+#include "connectFourAssets/evalWeights.hpp"
+#include "connectFourAssets/positionSamples.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+	// Streak count differences of every position, for the lengths 2 to the
+	// winning streak, and the results they are fitted to
+	struct Corpus {
+		int lengths = 0;
+		std::vector<int32_t> features;
+		std::vector<float> targets;
+		std::vector<char> heldOut;
+
+		size_t size() const { return targets.size(); }
+	};
+
+	bool readCorpus(const std::string& prefix, SampleShardHeader& header, std::vector<PositionSample>& samples) {
+		SampleReader reader;
+		if(!reader.open(SampleWriter::shardPath(prefix, 0))) return false;
+		header = reader.header();
+		for(uint32_t shard = 0; shard < header.shards; shard++) {
+			if(shard > 0 && !reader.open(SampleWriter::shardPath(prefix, shard))) return false;
+			const SampleShardHeader& other = reader.header();
+			if(other.width != header.width || other.height != header.height ||
+			   other.winningStreakSize != header.winningStreakSize) {
+				std::cerr << "Tuner: shard " << shard << " of " << prefix << " has another geometry" << std::endl;
+				return false;
+			}
+			PositionSample sample;
+			while(reader.next(sample)) samples.push_back(sample);
+		}
+		return true;
+	}
+
+	// Counts the streaks of every position with Board::checkStreak, the
+	// counts EvaluateBoardScalar weighs, and checks a share of the positions
+	// against it. Positions with a winner have no streak score and are left out.
+	bool buildCorpus(const SampleShardHeader& header, const std::vector<PositionSample>& samples, int threads,
+					 Corpus& corpus) {
+		const int width = header.width;
+		const int numSlots = width * header.height;
+		const int streak = header.winningStreakSize;
+		const int lengths = streak - 1;
+		std::vector<int32_t> features(samples.size() * lengths);
+		std::vector<char> keep(samples.size(), 0);
+		long mismatches = 0;
+		#pragma omp parallel num_threads(threads) reduction(+:mismatches)
+		{
+			Board board(width, header.height, streak);
+			const int32_t* weights = EvalWeights::streakTable();
+			#pragma omp for schedule(static)
+			for(long i = 0; i < (long)samples.size(); i++) {
+				const PositionSample& sample = samples[i];
+				board.Reset();
+				for(int slot = 0; slot < numSlots; slot++) {
+					if(sample.red >> slot & 1) board.makeMove(slot, SlotStatus::Red);
+					else if(sample.yellow >> slot & 1) board.makeMove(slot, SlotStatus::Yellow);
+				}
+				if(board.DetermineWinner() != Player::None) continue;
+				Player player = sample.toMove();
+				SlotStatus colorFor = board.getPlayerColor(player);
+				SlotStatus colorAgainst = board.getPlayerColor(board.oppPlayer(player));
+				uint32_t score = 0;
+				for(int length = 2; length <= streak; length++) {
+					uint32_t difference = board.checkStreak(colorFor, length) - board.checkStreak(colorAgainst, length);
+					features[i * lengths + length - 2] = (int32_t)difference;
+					score += difference * (uint32_t)weights[length];
+				}
+				if(i % 64 == 0 && (int)score != board.EvaluateBoardScalar(player)) mismatches++;
+				keep[i] = 1;
+			}
+		}
+		if(mismatches) {
+			std::cerr << "Tuner: " << mismatches << " streak counts do not match the evaluation" << std::endl;
+			return false;
+		}
+
+		corpus.lengths = lengths;
+		for(size_t i = 0; i < samples.size(); i++) {
+			if(!keep[i]) continue;
+			corpus.features.insert(corpus.features.end(), features.begin() + i * lengths,
+								   features.begin() + (i + 1) * lengths);
+			corpus.targets.push_back((samples[i].result + 1) / 2.0f);
+			// Held out by key, so the split does not depend on the shard order
+			corpus.heldOut.push_back((samples[i].key >> 40) % 10 == 0);
+		}
+		return true;
+	}
+
+	// Mean squared error of the predicted results on the fitted or the held
+	// out positions
+	double loss(const Corpus& corpus, const std::vector<double>& weights, double k, bool heldOut, int threads) {
+		double sum = 0;
+		long count = 0;
+		const int lengths = corpus.lengths;
+		#pragma omp parallel for num_threads(threads) reduction(+:sum, count) schedule(static)
+		for(long i = 0; i < (long)corpus.size(); i++) {
+			if((bool)corpus.heldOut[i] != heldOut) continue;
+			const int32_t* features = &corpus.features[i * lengths];
+			double score = 0;
+			for(int l = 0; l < lengths; l++) score += features[l] * weights[l];
+			double error = corpus.targets[i] - 1.0 / (1.0 + std::exp(-k * score));
+			sum += error * error;
+			count++;
+		}
+		return count ? sum / count : 0.0;
+	}
+
+	// Golden section search of K on a log scale
+	double fitScale(const Corpus& corpus, const std::vector<double>& weights, int threads) {
+		const double ratio = (std::sqrt(5.0) - 1) / 2;
+		double lo = -8, hi = 1;
+		for(int i = 0; i < 60; i++) {
+			double a = hi - ratio * (hi - lo), b = lo + ratio * (hi - lo);
+			if(loss(corpus, weights, std::pow(10.0, a), false, threads) <
+			   loss(corpus, weights, std::pow(10.0, b), false, threads)) hi = b;
+			else lo = a;
+		}
+		return std::pow(10.0, (lo + hi) / 2);
+	}
+}
+
+bool EvalTuner::tune(const std::string& prefix, const std::string& path, const Options& options) {
+	auto start = std::chrono::high_resolution_clock::now();
+	SampleShardHeader header;
+	std::vector<PositionSample> samples;
+	if(!readCorpus(prefix, header, samples)) return false;
+	Corpus corpus;
+	if(!buildCorpus(header, samples, options.threads, corpus)) return false;
+	if(corpus.size() == 0) {
+		std::cerr << "Tuner: " << prefix << " holds no positions to tune on" << std::endl;
+		return false;
+	}
+	const int streak = header.winningStreakSize;
+	std::cout << "Tuner: " << corpus.size() << " positions of " << (int)header.width << "x" << (int)header.height
+			  << " with a streak of " << streak << " on " << options.threads << " threads" << std::endl;
+
+	// Weights whose streaks never occur cannot be fitted and stay as they are
+	std::vector<double> weights(corpus.lengths);
+	std::vector<char> tuned(corpus.lengths, 0);
+	for(int l = 0; l < corpus.lengths; l++) {
+		weights[l] = EvalWeights::streak(l + 2);
+		for(size_t i = 0; i < corpus.size() && !tuned[l]; i++) tuned[l] = corpus.features[i * corpus.lengths + l] != 0;
+	}
+	const double k = fitScale(corpus, weights, options.threads);
+	const double startLoss = loss(corpus, weights, k, false, options.threads);
+	const double startHeldOut = loss(corpus, weights, k, true, options.threads);
+	std::cout << "Tuner: K = " << k << " loss = " << startLoss << " held out = " << startHeldOut << std::endl;
+
+	std::vector<int> steps(corpus.lengths);
+	for(int l = 0; l < corpus.lengths; l++) steps[l] = std::max(1, (int)std::abs(weights[l]) / 4);
+	double best = startLoss;
+	for(int pass = 0; pass < options.passes; pass++) {
+		bool improved = false, refining = false;
+		for(int l = 0; l < corpus.lengths; l++) {
+			if(!tuned[l]) continue;
+			bool moved = false;
+			for(int sign = 1; sign >= -1 && !moved; sign -= 2) {
+				weights[l] += sign * steps[l];
+				double current = loss(corpus, weights, k, false, options.threads);
+				if(current < best) {
+					best = current;
+					moved = true;
+				}
+				else weights[l] -= sign * steps[l];
+			}
+			improved |= moved;
+			if(!moved && steps[l] > 1) {
+				steps[l] /= 2;
+				refining = true;
+			}
+		}
+		std::cout << "Tuner: pass " << pass + 1 << " loss = " << best << std::endl;
+		if(!improved && !refining) break;
+	}
+
+	for(int l = 0; l < corpus.lengths; l++) EvalWeights::setStreak(l + 2, (int32_t)weights[l]);
+	const double heldOut = loss(corpus, weights, k, true, options.threads);
+	std::ostringstream comment;
+	comment << "Tuned on " << corpus.size() << " positions of " << prefix << ", K = " << k << ", held out loss "
+			<< startHeldOut << " -> " << heldOut;
+	if(!EvalWeights::save(path, streak, comment.str())) return false;
+
+	std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+	std::cout << "Tuner: loss " << startLoss << " -> " << best << ", held out " << startHeldOut << " -> " << heldOut
+			  << ", weights";
+	for(int l = 0; l < corpus.lengths; l++) std::cout << " " << l + 2 << ":" << (int32_t)weights[l];
+	std::cout << " written to " << path << " in " << elapsed.count() << " s" << std::endl;
+	return true;
+}
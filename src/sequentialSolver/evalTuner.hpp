@@ -0,0 +1,43 @@
+/**
+ * @defgroup   EVAL_TUNER
+ *
+ * @brief      Fits the streak weights of evalWeights.hpp to self-play
+ * positions with a Texel style logistic loss: the evaluation of a position,
+ * squashed by sigmoid(K * score), should predict the result of its game for
+ * the player to move (1 win, 1/2 draw, 0 loss).
+ *
+ * The streak counts of every position are computed once, after which a loss
+ * costs one dot product per position, summed on all threads. K is fitted to
+ * the starting weights and then held, and the weights move by coordinate
+ * descent: each is stepped up or down while that lowers the loss, with steps
+ * halving down to 1. One position in ten is held out to check the fit.
+ *
+ * @date       2021
+ */
+#ifndef __EVAL_TUNER__
+#define __EVAL_TUNER__
+
+#include <string>
+
+namespace EvalTuner
+{
+    struct Options {
+        int threads = 1;
+        // Passes over all the weights at most
+        int passes = 100;
+    };
+
+    /**
+     * @brief      Tunes the weights and writes them to a weights file. The
+     * weights in effect (defaults or --weights) are the starting point.
+     *
+     * @param[in]  prefix   The corpus, shards <prefix>.<shard> of --self-play
+     * @param[in]  path     The weights file to write
+     * @param[in]  options  The options
+     *
+     * @return     False if the corpus cannot be read or the file written
+     */
+    bool tune(const std::string& prefix, const std::string& path, const Options& options);
+}
+
+#endif
@@ -0,0 +1,112 @@
+#include "selfPlay.hpp"
+#include "sequentialSolver.hpp"
+#include "connectFourAssets/positionSamples.hpp"
+#include "connectFourAssets/zobrist.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// Index of the slot a piece dropped in the column lands on, -1 if full
+	int dropSlot(Board& board, int column) {
+		SlotStatus* slots = board.getBoard();
+		for(int row = board.getHeight() - 1; row >= 0; row--)
+			if(slots[row * board.getWidth() + column] == SlotStatus::Empty) return row * board.getWidth() + column;
+		return -1;
+	}
+
+	PositionSample sampleOf(Board& board, Player player, int plies) {
+		PositionSample sample = {};
+		SlotStatus* slots = board.getBoard();
+		const int numSlots = board.getWidth() * board.getHeight();
+		for(int i = 0; i < numSlots; i++) {
+			if(slots[i] == SlotStatus::Red) sample.red |= 1ull << i;
+			else if(slots[i] == SlotStatus::Yellow) sample.yellow |= 1ull << i;
+		}
+		sample.key = Zobrist::scoredKey(board.canonicalKey(), player);
+		sample.plies = plies;
+		return sample;
+	}
+
+	// Plays one game on the solver, reset, and the board and appends its
+	// samples.
+	// False if the random moves already ended the game.
+	bool playGame(SequentialSolver& solver, Board& board, const SelfPlay::Options& options,
+				  std::mt19937_64& rng, std::vector<PositionSample>& samples) {
+		const int numSlots = board.getWidth() * board.getHeight();
+		std::string moves;
+		Player player = randomPosition(board, rng, options.randomPlies, &moves);
+		if(board.DetermineWinner() != Player::None) return false;
+		solver.setPosition(moves.c_str());
+		int plies = (int)moves.size();
+
+		const size_t first = samples.size();
+		Player winner = Player::None;
+		for(; plies < numSlots; plies++) {
+			PositionSample sample = sampleOf(board, player, plies);
+			int score = 0;
+			int column = solver.analyze(player, options.searchDepth, &score);
+			if(column < 0) break;
+			sample.score = score;
+			sample.column = column;
+			sample.depth = solver.getSearchDepth();
+			samples.push_back(sample);
+
+			int index = dropSlot(board, column);
+			board.makeMove(index, board.getPlayerColor(player));
+			solver.playMove(column + 1, player);
+			if(board.isWinningMove(index)) {
+				winner = player;
+				break;
+			}
+			player = board.oppPlayer(player);
+		}
+		for(size_t i = first; i < samples.size(); i++) {
+			if(winner == Player::None) samples[i].result = 0;
+			else samples[i].result = (samples[i].toMove() == winner) ? 1 : -1;
+		}
+		return true;
+	}
+}
+
+long SelfPlay::generate(const std::string& prefix, int width, int height, int winningStreakSize,
+						const Options& options) {
+	SampleWriter writer;
+	if(!writer.open(prefix, width, height, winningStreakSize, options.shards)) return -1;
+	std::cout << "Self-play: " << options.games << " games at depth " << options.searchDepth << " after "
+			  << options.randomPlies << " random moves on " << options.threads << " threads" << std::endl;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	std::atomic<uint64_t> positions(0);
+	#pragma omp parallel num_threads(options.threads)
+	{
+		SequentialSolver solver(width, height, winningStreakSize);
+		Board board(width, height, winningStreakSize);
+		std::vector<PositionSample> samples;
+		#pragma omp for schedule(dynamic, 1)
+		for(int game = 0; game < options.games; game++) {
+			std::mt19937_64 rng(options.seed + game);
+			samples.clear();
+			// Random moves that end the game are drawn again
+			do {
+				solver.resetSolver();
+			} while(!playGame(solver, board, options, rng, samples));
+			positions += samples.size();
+			for(const PositionSample& sample : samples) writer.add(sample);
+		}
+	}
+	const uint64_t written = writer.written();
+	const uint64_t duplicates = writer.duplicates();
+	writer.close();
+
+	std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+	std::cout << "Self-play: " << positions << " positions, " << written << " written and "
+			  << duplicates << " duplicates dropped in " << elapsed.count() << " s ("
+			  << positions / elapsed.count() << " positions/s)" << std::endl;
+	return (long)written;
+}
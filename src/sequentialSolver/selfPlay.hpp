@@ -0,0 +1,52 @@
+/**
+ * @defgroup   SELF_PLAY
+ *
+ * @brief      Self-play generator for training and tuning corpora. Games
+ * start with a few random moves and are played out by the sequential solver,
+ * every position the solver moves from becomes a sample labelled with its
+ * score, move and depth and, once the game is over, its result. Samples go to
+ * a sharded SampleWriter that keeps the first sample of every position.
+ *
+ * Games run in parallel, one solver per thread. Threads share nothing but the
+ * shard locks, which they take once per position, so the throughput grows
+ * with the threads for as long as there are cores.
+ *
+ * @date       2021
+ */
+#ifndef __SELF_PLAY__
+#define __SELF_PLAY__
+
+#include <cstdint>
+#include <string>
+
+namespace SelfPlay
+{
+    struct Options {
+        // Number of games to play
+        int games = 100;
+        // Random moves at the start of every game
+        int randomPlies = 6;
+        // Depth the solver searches every position to
+        int searchDepth = 6;
+        int shards = 16;
+        int threads = 1;
+        // Game i is played with the random moves of seed + i
+        uint64_t seed = 1;
+    };
+
+    /**
+     * @brief      Plays the games and writes the samples. Red moves first.
+     *
+     * @param[in]  prefix             The shards are written to <prefix>.<shard>
+     * @param[in]  width              The width of the board
+     * @param[in]  height             The height of the board
+     * @param[in]  winningStreakSize  The winning streak size
+     * @param[in]  options            The options
+     *
+     * @return     The number of samples written, -1 on failure
+     */
+    long generate(const std::string& prefix, int width, int height, int winningStreakSize,
+                  const Options& options);
+}
+
+#endif
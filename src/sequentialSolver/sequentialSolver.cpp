@@ -1,4 +1,8 @@
 #include "sequentialSolver.hpp"
+#include "connectFourAssets/evalConfig.hpp"
+#include "connectFourAssets/zobrist.hpp"
+
+#include <algorithm>
 
 #define DEBUG 1
 
@@ -7,37 +11,83 @@
 								   GameTreeSearchSolver(), _nodesTraversed(0) {*/
 SequentialSolver::SequentialSolver(uint_fast8_t width, uint_fast8_t height,
 								   uint_fast8_t winningStreakSize):
-								   _nodesTraversed(0), _totalNodesTraversed(0) {
+								   _searchDepth(0), _lastScore(0), _lastColumn(-1), _stopSearch(false), _stopDeferred(false),
+								   _stopPending(false), _ponderReply(-1),
+								   _ponderMoves(0), _ponderHits(0), _nodesTraversed(0),
+								   _totalNodesTraversed(0) {
 	_boardSeq = new BoardSequential(width, height, winningStreakSize);
+	_leafBatch = nullptr;
+	_evalCache = nullptr;
+	_transpositions = nullptr;
+	if(EvalConfig::transpositionKb() > 0)
+		_transpositions = new TranspositionTable(EvalConfig::transpositionKb());
+	if(EvalConfig::evalCacheKb() > 0)
+		_evalCache = new EvalCache(EvalConfig::evalCacheKb());
+	if(LeafBatch::supportsGeometry(width, height, winningStreakSize)) {
+		_leafBatch = new LeafBatch(width, height, winningStreakSize);
+		if(_evalCache) _leafBatch->setEvalCache(_evalCache);
+	}
+}
+
+SequentialSolver::~SequentialSolver() {
+	this->stopPondering();
+	delete _leafBatch;
+	delete _evalCache;
+	delete _transpositions;
+	delete _boardSeq;
 }
 
 int SequentialSolver::solve(Player player, int maxDepth, double time_limit)
 {
+	this->stopPondering();
+	_lastColumn = -1;
     if (_boardSeq->DetermineWinner() != Player::None) {
         return -1;
     }
 
 	_nodesTraversed = 0;
 	int retval = -1;
-	int bestMove = -1;
+	// Entries of earlier moves stay valid, they just age
+	if(_transpositions) _transpositions->newSearch();
+	// Small geometries are answered exactly by the tablebase, positions
+	// covered by the opening book without a search
+	int bestMove = _boardSeq->tablebaseMove(player);
+	if(bestMove < 0) bestMove = _boardSeq->bookMove(player);
 	auto nodesTraversed = _nodesTraversed;
 
-	if(time_limit > 0) {
+	if(bestMove > -1) {
+		// Tablebase or book move, nothing to search
+	}
+	else if(time_limit > 0) {
 		// Implement Iterative Deepening to adhere to a time limit per move
 		this->startTimer();
 		for (int depth = 2; this->isTimeLeft(time_limit); depth += 2) {
 			// Find the best move
-			int move = this->findBestMove(_boardSeq->getBoard(), player, depth, time_limit);
-			if(this->isTimeLeft(time_limit)) {
+			int score;
+			if(depth == 2) this->deferStop(true);
+			int move = this->findBestMove(_boardSeq->getBoard(), player, depth, (depth == 2) ? -1 : time_limit,
+										  &score);
+			if(depth == 2) this->deferStop(false);
+			bool completed = this->isTimeLeft(time_limit) && !_stopSearch.load(std::memory_order_relaxed);
+			// A search cut short still beats having no move at all
+			if(completed || bestMove < 0) {
 				bestMove = move;
+				_searchDepth = depth;
 				nodesTraversed = _nodesTraversed;
 				_nodesTraversed = 0;
 			}
+			if(!completed) break;
+			if(_searchInfo && !_searchInfo(depth, score, bestMove % _boardSeq->getWidth(), nodesTraversed))
+				break;
 		}
 		_nodesTraversed = nodesTraversed;
 	}
 	else {
-		bestMove = this->findBestMove(_boardSeq->getBoard(), player, maxDepth, time_limit);
+		int score;
+		bestMove = this->findBestMove(_boardSeq->getBoard(), player, maxDepth, time_limit, &score);
+		_searchDepth = maxDepth;
+		if(_searchInfo && bestMove > -1 && !_stopSearch.load(std::memory_order_relaxed))
+			_searchInfo(maxDepth, score, bestMove % _boardSeq->getWidth(), _nodesTraversed);
 	}
 
 	if(_boardSeq->IsFull()) {
@@ -49,6 +99,7 @@ int SequentialSolver::solve(Player player, int maxDepth, double time_limit)
 		_boardSeq->playMove(bestMove, this->getPlayerColor(player));
 		//this->printBoard();
 		retval = bestMove % _boardSeq->getWidth();
+		_lastColumn = retval;
 	}
 
 	Player winner = _boardSeq->DetermineWinner();
@@ -61,7 +112,206 @@ int SequentialSolver::solve(Player player, int maxDepth, double time_limit)
     return retval;
 }
 
-int SequentialSolver::findBestMove(SlotStatus* board, Player player, int maxDepth, double time_limit) {
+int SequentialSolver::analyze(Player player, int maxDepth, int* score, double time_limit)
+{
+	this->stopPondering();
+	_nodesTraversed = 0;
+	int move = -1;
+	if(time_limit > 0 && maxDepth >= 2) {
+		// Iterative deepening like solve() up to maxDepth, the nodes of every
+		// depth count. Depth 2 runs to the end and is always accepted, so there
+		// is a move however short the time or early the stop().
+		this->startTimer();
+		for(int depth = 2; ; depth = std::min(depth + 2, maxDepth)) {
+			int depthScore;
+			uint64_t nodes = _nodesTraversed;
+			if(depth == 2) this->deferStop(true);
+			int found = this->findBestMove(_boardSeq->getBoard(), player, depth,
+										   (depth == 2) ? -1 : time_limit, &depthScore);
+			if(depth == 2) this->deferStop(false);
+			if(depth > 2 && (!this->isTimeLeft(time_limit) || _stopSearch.load(std::memory_order_relaxed)))
+				break;
+			move = found;
+			if(score) *score = depthScore;
+			_searchDepth = depth;
+			bool deeper = depth < maxDepth;
+			if(_searchInfo && move > -1 &&
+			   !_searchInfo(depth, depthScore, move % _boardSeq->getWidth(), _nodesTraversed - nodes))
+				deeper = false;
+			if(!deeper) break;
+		}
+	}
+	else {
+		move = this->findBestMove(_boardSeq->getBoard(), player, maxDepth, -1, score);
+		_searchDepth = maxDepth;
+	}
+	_totalNodesTraversed += _nodesTraversed;
+	return (move > -1) ? move % _boardSeq->getWidth() : -1;
+}
+
+int SequentialSolver::analyzeColumns(Player player, int maxDepth, std::vector<RootScore>& scores,
+									 int exactColumns)
+{
+	this->stopPondering();
+	_nodesTraversed = 0;
+	scores.clear();
+	if(_boardSeq->DetermineWinner() != Player::None || _boardSeq->IsFull()) return -1;
+
+	SlotStatus* board = _boardSeq->getBoard();
+	SlotStatus color = this->getPlayerColor(player);
+	const int width = _boardSeq->getWidth();
+	const int numSlots = width * _boardSeq->getHeight();
+	bool skipMirrored = _boardSeq->isSymmetric() && _boardSeq->evalMirrorSymmetric();
+	bool pruning = EvalConfig::searchDriver() != EvalConfig::SearchDriver::Minimax;
+	_emptySlots = 0;
+	for(int i = 0; i < numSlots; i++)
+		if(board[i] == SlotStatus::Empty) ++_emptySlots;
+
+	// Exact scores so far, best first. Once there are exactColumns of them a
+	// move is searched against the last one, and failing low bounds it.
+	std::vector<int> exact;
+	for(int i = numSlots - 1; i >= 0 && !_stopSearch.load(std::memory_order_relaxed); i--) {
+		if(board[i] != SlotStatus::Empty || !_boardSeq->isLegalMove(i)) continue;
+		if(skipMirrored && (i % width) < width - 1 - (i % width)) continue;
+		int alpha = (pruning && exactColumns > 0 && (int)exact.size() >= exactColumns)
+					? exact[exactColumns - 1] : INT_MIN;
+		RootScore root{i % width, 0, TranspositionTable::Bound::Exact, {i % width}};
+		_boardSeq->makeMove(i, color);
+		--_emptySlots;
+		root.score = pruning ? this->alphaBeta(board, maxDepth, player, false, i, alpha, INT_MAX)
+							 : this->minimax(board, maxDepth, player, false, i);
+		if(alpha > INT_MIN && root.score <= alpha) root.bound = TranspositionTable::Bound::Upper;
+		else {
+			exact.insert(std::upper_bound(exact.begin(), exact.end(), root.score, std::greater<int>()),
+						 root.score);
+			this->principalVariation(board, maxDepth, player, i, root.score, root.pv);
+		}
+		++_emptySlots;
+		_boardSeq->undoMove(i);
+		++_nodesTraversed;
+		scores.push_back(root);
+	}
+
+	// The skipped moves score like their mirror images
+	if(skipMirrored) {
+		const size_t searched = scores.size();
+		for(size_t n = 0; n < searched; n++) {
+			if(2 * scores[n].column == width - 1) continue;
+			RootScore mirrored = scores[n];
+			for(int& column : mirrored.pv) column = width - 1 - column;
+			mirrored.column = mirrored.pv[0];
+			scores.push_back(mirrored);
+		}
+	}
+	// Ties keep the scan order, so the first move is the one findBestMove
+	// plays
+	std::stable_sort(scores.begin(), scores.end(), [](const RootScore& a, const RootScore& b) {
+		if(a.score != b.score) return a.score > b.score;
+		return a.bound == TranspositionTable::Bound::Exact && b.bound != TranspositionTable::Bound::Exact;
+	});
+	_totalNodesTraversed += _nodesTraversed;
+	return scores.empty() ? -1 : scores[0].column;
+}
+
+std::vector<int> SequentialSolver::bestLine(Player player, int depth, int column, int score)
+{
+	std::vector<int> pv{column};
+	SlotStatus* board = _boardSeq->getBoard();
+	const int width = _boardSeq->getWidth();
+	const int numSlots = width * _boardSeq->getHeight();
+	if(board[column] != SlotStatus::Empty) return pv;
+	int index = column;
+	while(index + width < numSlots && board[index + width] == SlotStatus::Empty) index += width;
+	const uint64_t nodes = _nodesTraversed;
+	_boardSeq->makeMove(index, this->getPlayerColor(player));
+	--_emptySlots;
+	this->principalVariation(board, depth, player, index, score, pv);
+	++_emptySlots;
+	_boardSeq->undoMove(index);
+	_nodesTraversed = nodes;
+	return pv;
+}
+
+void SequentialSolver::principalVariation(SlotStatus* board, int depth, Player player, int lastMove,
+										  int score, std::vector<int>& pv)
+{
+	// The tables keep values and no moves, so the line follows the first
+	// child that searches to the score again. Those searches mostly end on
+	// the entries the search of the move left.
+	const int width = _boardSeq->getWidth();
+	const int numSlots = width * _boardSeq->getHeight();
+	bool maximizer = false;
+	std::vector<int> played;
+	while(depth > 0 && _emptySlots > 0 && !_boardSeq->isWinningMove(lastMove)) {
+		SlotStatus color = this->getPlayerColor(maximizer ? player : this->oppPlayer(player));
+		int next = -1;
+		for(int i = numSlots - 1; i >= 0 && next < 0; i--) {
+			if(board[i] != SlotStatus::Empty || !_boardSeq->isLegalMove(i)) continue;
+			_boardSeq->makeMove(i, color);
+			--_emptySlots;
+			if(this->alphaBeta(board, depth - 1, player, !maximizer, i, INT_MIN, INT_MAX) == score) next = i;
+			++_emptySlots;
+			_boardSeq->undoMove(i);
+		}
+		if(next < 0 || _stopSearch.load(std::memory_order_relaxed)) break;
+		_boardSeq->makeMove(next, color);
+		--_emptySlots;
+		played.push_back(next);
+		pv.push_back(next % width);
+		lastMove = next;
+		maximizer = !maximizer;
+		--depth;
+	}
+	for(auto move = played.rbegin(); move != played.rend(); ++move) {
+		++_emptySlots;
+		_boardSeq->undoMove(*move);
+	}
+}
+
+int SequentialSolver::setPosition(const char* moves)
+{
+	this->stopPondering();
+	_boardSeq->Reset();
+	const int width = _boardSeq->getWidth();
+	const int numSlots = width * _boardSeq->getHeight();
+	SlotStatus* board = _boardSeq->getBoard();
+	SlotStatus color = SlotStatus::Red;
+	bool won = false;
+	int plies = 0;
+	for(const char* m = moves; *m; m++, plies++) {
+		int column = *m - '1';
+		// No move follows the one that won the game
+		if(won || column < 0 || column >= width || board[column] != SlotStatus::Empty) return -1;
+		int index = column;
+		while(index + width < numSlots && board[index + width] == SlotStatus::Empty) index += width;
+		_boardSeq->makeMove(index, color);
+		won = _boardSeq->isWinningMove(index);
+		color = (color == SlotStatus::Red) ? SlotStatus::Yellow : SlotStatus::Red;
+	}
+	return plies;
+}
+
+bool SequentialSolver::setPosition(const SlotStatus* slots)
+{
+	this->stopPondering();
+	_boardSeq->Reset();
+	const int width = _boardSeq->getWidth();
+	const int height = _boardSeq->getHeight();
+	// Columns are filled from the bottom, the key does not depend on the order
+	for(int column = 0; column < width; column++) {
+		bool empty = false;
+		for(int row = height - 1; row >= 0; row--) {
+			int index = row * width + column;
+			if(slots[index] == SlotStatus::Empty) empty = true;
+			else if(empty) return false;
+			else _boardSeq->makeMove(index, slots[index]);
+		}
+	}
+	return true;
+}
+
+int SequentialSolver::findBestMove(SlotStatus* board, Player player, int maxDepth, double time_limit,
+								   int* bestScoreOut) {
 	// Will return the index of the best move in the board for the given player
 	// Return if the board is full
 	if(_boardSeq->IsFull()) return -1;
@@ -70,25 +320,49 @@ int SequentialSolver::findBestMove(SlotStatus* board, Player player, int maxDept
 	int move = -1;
 	int bestScore = INT_MIN;
 	bool empty_slot_avl = false;
+	_emptySlots = 0;
+	for(int i = 0; i < _boardSeq->getWidth() * _boardSeq->getHeight(); i++)
+		if(board[i] == SlotStatus::Empty) ++_emptySlots;
 
-	// Traverse through the board to find legal moves and see the maximum score
-	// Since the board fills from the last row, it's better to traverse the 
-	// board in a reverse order
-	for(int i = _boardSeq->getWidth() * _boardSeq->getHeight() - 1; (i >= 0) && 
-										this->isTimeLeft(time_limit) ; i--) {
-		if(board[i] == SlotStatus::Empty) {
-			if(!_boardSeq->isLegalMove(i)) continue;
-			empty_slot_avl = true;
-			board[i] = color;
-			int score = this->minimax(board, maxDepth, player, false);
-			board[i] = SlotStatus::Empty;
-			++_nodesTraversed;
-			if(score > bestScore) {
-				move = i;
-				bestScore = score;
+	// On a position that is its own mirror image, a move and its mirrored
+	// move score the same under a symmetric heuristic, so only one of each
+	// pair is searched. The higher column is kept since it is the one the scan
+	// below settles ties on.
+	const int width = _boardSeq->getWidth();
+	bool skipMirrored = _boardSeq->isSymmetric() && _boardSeq->evalMirrorSymmetric();
+
+	// The pruning drivers search the same tree with alpha-beta windows
+	EvalConfig::SearchDriver driver = EvalConfig::searchDriver();
+	if(driver != EvalConfig::SearchDriver::Minimax) {
+		bestScore = this->searchWithDriver(board, player, maxDepth, time_limit, driver, move);
+		empty_slot_avl = _emptySlots > 0;
+	}
+	else {
+		// Traverse through the board to find legal moves and see the maximum score
+		// Since the board fills from the last row, it's better to traverse the 
+		// board in a reverse order
+		for(int i = _boardSeq->getWidth() * _boardSeq->getHeight() - 1; (i >= 0) && 
+											this->isTimeLeft(time_limit) &&
+											!_stopSearch.load(std::memory_order_relaxed); i--) {
+			if(board[i] == SlotStatus::Empty) {
+				if(!_boardSeq->isLegalMove(i)) continue;
+				empty_slot_avl = true;
+				if(skipMirrored && (i % width) < width - 1 - (i % width)) continue;
+				_boardSeq->makeMove(i, color);
+				--_emptySlots;
+				int score = this->minimax(board, maxDepth, player, false, i);
+				++_emptySlots;
+				_boardSeq->undoMove(i);
+				++_nodesTraversed;
+				if(score > bestScore) {
+					move = i;
+					bestScore = score;
+				}
 			}
 		}
 	}
+	if(this->isTimeLeft(time_limit) && !_stopSearch.load(std::memory_order_relaxed))
+		_lastScore = bestScore;
 	// This means that there is no move which can avoid defeat, so at this point
 	// it doesn't really matter where the move is played
 	if(move == -1 && empty_slot_avl) {
@@ -101,22 +375,194 @@ int SequentialSolver::findBestMove(SlotStatus* board, Player player, int maxDept
 			}
 		}
 	}
+	if(bestScoreOut) *bestScoreOut = bestScore;
 	return move;
 }
 
+int SequentialSolver::searchRoot(SlotStatus* board, Player player, int maxDepth, double time_limit,
+								 int alpha, int beta, int& move) {
+	SlotStatus color = this->getPlayerColor(player);
+	const int width = _boardSeq->getWidth();
+	bool skipMirrored = _boardSeq->isSymmetric() && _boardSeq->evalMirrorSymmetric();
+	int bestScore = INT_MIN;
+	move = -1;
+
+	// Same scan order and tie break as the minimax root, so a search that
+	// ends inside its window picks the same move
+	for(int i = _boardSeq->getWidth() * _boardSeq->getHeight() - 1; (i >= 0) &&
+										this->isTimeLeft(time_limit) &&
+										!_stopSearch.load(std::memory_order_relaxed); i--) {
+		if(board[i] != SlotStatus::Empty || !_boardSeq->isLegalMove(i)) continue;
+		if(skipMirrored && (i % width) < width - 1 - (i % width)) continue;
+		_boardSeq->makeMove(i, color);
+		--_emptySlots;
+		int score = this->alphaBeta(board, maxDepth, player, false, i, std::max(alpha, bestScore), beta);
+		++_emptySlots;
+		_boardSeq->undoMove(i);
+		++_nodesTraversed;
+		if(score > bestScore) {
+			move = i;
+			bestScore = score;
+			if(bestScore >= beta) break;
+		}
+	}
+	return bestScore;
+}
+
+int SequentialSolver::searchWithDriver(SlotStatus* board, Player player, int maxDepth, double time_limit,
+									   EvalConfig::SearchDriver driver, int& move) {
+	int bestScore = INT_MIN;
+	// The score of the last search is the first guess, a decided game is
+	// searched with the full window
+	int guess = _lastScore;
+	if(guess == INT_MIN || guess == INT_MAX) driver = EvalConfig::SearchDriver::AlphaBeta;
+
+	if(driver == EvalConfig::SearchDriver::Aspiration) {
+		// Widen the side the search failed on until the score falls inside
+		int64_t delta = kAspirationDelta;
+		int alpha = (int)std::max<int64_t>((int64_t)guess - delta, INT_MIN);
+		int beta = (int)std::min<int64_t>((int64_t)guess + delta, INT_MAX);
+		while(true) {
+			bestScore = this->searchRoot(board, player, maxDepth, time_limit, alpha, beta, move);
+			if(!this->isTimeLeft(time_limit) || _stopSearch.load(std::memory_order_relaxed)) break;
+			delta *= 4;
+			if(bestScore <= alpha && alpha > INT_MIN)
+				alpha = (int)std::max<int64_t>((int64_t)guess - delta, INT_MIN);
+			else if(bestScore >= beta && beta < INT_MAX)
+				beta = (int)std::min<int64_t>((int64_t)guess + delta, INT_MAX);
+			else
+				break;
+		}
+	}
+	else if(driver == EvalConfig::SearchDriver::Mtdf) {
+		// Null window searches move the bounds towards the score until they
+		// meet. The move is the one of the last search that failed high, the
+		// first move reaching the final lower bound.
+		int lower = INT_MIN;
+		int upper = INT_MAX;
+		int g = guess;
+		move = -1;
+		while(lower < upper) {
+			int beta = (g == lower) ? g + 1 : g;
+			int found;
+			g = this->searchRoot(board, player, maxDepth, time_limit, beta - 1, beta, found);
+			if(!this->isTimeLeft(time_limit) || _stopSearch.load(std::memory_order_relaxed)) break;
+			if(g < beta) upper = g;
+			else {
+				lower = g;
+				move = found;
+			}
+		}
+		bestScore = lower;
+	}
+	else {
+		bestScore = this->searchRoot(board, player, maxDepth, time_limit, INT_MIN, INT_MAX, move);
+	}
+	return bestScore;
+}
+
+int SequentialSolver::alphaBeta(SlotStatus* board, int depth, Player player, bool maximizer,
+								int lastMove, int alpha, int beta) {
+	if(_boardSeq->isWinningMove(lastMove))
+		return (board[lastMove] == this->getPlayerColor(player)) ? INT_MAX : INT_MIN;
+
+	if(_emptySlots == 0 || depth == 0)
+		return this->evaluateLeaf(player);
+
+	// Exact values fit any window
+	if(_leafBatch && depth <= LeafBatch::kMaxDepth)
+		return _leafBatch->minimax(board, _boardSeq->key(), _boardSeq->mirrorKey(), depth, player,
+								   maximizer, _nodesTraversed);
+
+	if(_stopSearch.load(std::memory_order_relaxed)) return 0;
+
+	// Shares the entries of minimax, exact values and bounds that already
+	// decide the window end the search of the node
+	uint64_t nodeKey = 0;
+	if(_transpositions && depth >= TranspositionTable::kMinDepth) {
+		nodeKey = Zobrist::nodeKey(_boardSeq->evalMirrorSymmetric() ? _boardSeq->canonicalKey() : _boardSeq->key(),
+								   player, maximizer);
+		int value;
+		if(_transpositions->probe(nodeKey, depth, alpha, beta, value)) return value;
+	}
+
+	const int alphaOrig = alpha;
+	const int betaOrig = beta;
+	SlotStatus color = this->getPlayerColor(maximizer ? player : this->oppPlayer(player));
+	int bestScore = maximizer ? INT_MIN : INT_MAX;
+	for(int i = _boardSeq->getWidth() * _boardSeq->getHeight() - 1; i >= 0 && alpha < beta; i--) {
+		if(board[i] != SlotStatus::Empty || !_boardSeq->isLegalMove(i)) continue;
+		_boardSeq->makeMove(i, color);
+		--_emptySlots;
+		int score = this->alphaBeta(board, depth - 1, player, !maximizer, i, alpha, beta);
+		++_emptySlots;
+		_boardSeq->undoMove(i);
+		++_nodesTraversed;
+		if(maximizer) {
+			bestScore = std::max(score, bestScore);
+			alpha = std::max(alpha, score);
+		}
+		else {
+			bestScore = std::min(score, bestScore);
+			beta = std::min(beta, score);
+		}
+	}
+
+	// Fail soft, a score outside the window only bounds the value
+	if(nodeKey && !_stopSearch.load(std::memory_order_relaxed)) {
+		TranspositionTable::Bound bound = TranspositionTable::Bound::Exact;
+		if(bestScore <= alphaOrig) bound = TranspositionTable::Bound::Upper;
+		else if(bestScore >= betaOrig) bound = TranspositionTable::Bound::Lower;
+		_transpositions->store(nodeKey, depth, bestScore, bound);
+	}
+	return bestScore;
+}
+
+int SequentialSolver::evaluateLeaf(Player player) {
+	if(!_evalCache) return _boardSeq->EvaluateBoard(player);
+	// Keyed like the leaves of the leaf batch, so both share entries
+	uint64_t key = Zobrist::scoredKey(_boardSeq->evalMirrorSymmetric() ? _boardSeq->canonicalKey() : _boardSeq->key(), player);
+	int score;
+	if(_evalCache->probe(key, score)) return score;
+	score = _boardSeq->EvaluateBoard(player);
+	_evalCache->store(key, score);
+	return score;
+}
+
 int SequentialSolver::minimax(SlotStatus* board, int depth, Player player, 
-								bool maximizer) {
+								bool maximizer, int lastMove) {
+	// The search stops at the first win, so only the last move can have
+	// ended the game. Checking the lines through it is all the interior nodes
+	// need, the heuristic only runs at the leaves.
+	if(_boardSeq->isWinningMove(lastMove))
+		return (board[lastMove] == this->getPlayerColor(player)) ? INT_MAX : INT_MIN;
+
 	// Board evaluations are static: The player won't change, it will always be
 	// the maximizer wrt whom the score will be calculated.
-	int score = _boardSeq->EvaluateBoard(player);
+	if(_emptySlots == 0 || depth == 0)
+		return this->evaluateLeaf(player);
 
-	if(score == INT_MAX || score == INT_MIN) // someone has won already
-		return score;
+	// The last plies are generated and scored as one block, which gives the
+	// same value as the node by node search below
+	if(_leafBatch && depth <= LeafBatch::kMaxDepth)
+		return _leafBatch->minimax(board, _boardSeq->key(), _boardSeq->mirrorKey(), depth, player,
+								   maximizer, _nodesTraversed);
 
-	if(_boardSeq->IsFull()) return score;
+	// Pondering was stopped, unwind without storing anything
+	if(_stopSearch.load(std::memory_order_relaxed)) return 0;
 
-	if(depth == 0) return score;
+	// Values are exact, so any stored value for the same node and depth can
+	// be returned as is. Mirror images share entries when the heuristic is
+	// symmetric.
+	uint64_t nodeKey = 0;
+	if(_transpositions && depth >= TranspositionTable::kMinDepth) {
+		nodeKey = Zobrist::nodeKey(_boardSeq->evalMirrorSymmetric() ? _boardSeq->canonicalKey() : _boardSeq->key(),
+								   player, maximizer);
+		int value;
+		if(_transpositions->probe(nodeKey, depth, value)) return value;
+	}
 
+	int score;
 	SlotStatus color;
 	if(maximizer) 
 		color = (player == Player::Red)?(SlotStatus::Red):(SlotStatus::Yellow);
@@ -130,14 +576,18 @@ int SequentialSolver::minimax(SlotStatus* board, int depth, Player player,
 																		 i--) {
 			if(board[i] == SlotStatus::Empty) {
 				if(_boardSeq->isLegalMove(i)) {
-					board[i] = color;
-					score = this->minimax(board, depth - 1, player, !maximizer);
+					_boardSeq->makeMove(i, color);
+					--_emptySlots;
+					score = this->minimax(board, depth - 1, player, !maximizer, i);
+					++_emptySlots;
 					bestScore = std::max(score, bestScore);
-					board[i] = SlotStatus::Empty;
+					_boardSeq->undoMove(i);
 					++_nodesTraversed;
 				}
 			}
 		}
+		if(nodeKey && !_stopSearch.load(std::memory_order_relaxed))
+			_transpositions->store(nodeKey, depth, bestScore);
 		return bestScore;
 	}
 	else {
@@ -147,27 +597,45 @@ int SequentialSolver::minimax(SlotStatus* board, int depth, Player player,
 																		i--) {
 			if(board[i] == SlotStatus::Empty) {
 				if(_boardSeq->isLegalMove(i)) {
-					board[i] = color;
-					score = this->minimax(board, depth - 1, player, !maximizer);
+					_boardSeq->makeMove(i, color);
+					--_emptySlots;
+					score = this->minimax(board, depth - 1, player, !maximizer, i);
+					++_emptySlots;
 					bestScore = std::min(bestScore, score);
-					board[i] = SlotStatus::Empty;
+					_boardSeq->undoMove(i);
 					++_nodesTraversed;
 				}
 			}
 		}
+		if(nodeKey && !_stopSearch.load(std::memory_order_relaxed))
+			_transpositions->store(nodeKey, depth, bestScore);
 		return bestScore;
 	}
 }
 
 void SequentialSolver::printBoard() {
+	this->stopPondering();
 	_boardSeq->printBoard();
 }
 
 void SequentialSolver::printStats() {
 	std::cout << "Total Nodes traversed: " << _nodesTraversed << std::endl;
+	if(_evalCache)
+		std::cout << "Eval cache hit rate: " << 100.0 * _evalCache->hitRate() << "% ("
+				  << _evalCache->hits() << "/" << _evalCache->probes() << ")" << std::endl;
+	if(_transpositions)
+		std::cout << "Transposition table hit rate: " << 100.0 * _transpositions->hitRate() << "% ("
+				  << _transpositions->hits() << "/" << _transpositions->probes() << ")" << std::endl;
 }
 
 int SequentialSolver::playMove(int column, Player player) {
+	if(_ponderThread.joinable()) {
+		this->stopPondering();
+		if(_ponderReply > -1) {
+			++_ponderMoves;
+			if(_ponderReply % _boardSeq->getWidth() == column - 1) ++_ponderHits;
+		}
+	}
 	return _boardSeq->playMove(column, player);
 }
 
@@ -203,7 +671,79 @@ uint64_t SequentialSolver::getTotalNodesTraversed() {
 }
 
 void SequentialSolver::resetSolver() {
+	this->stopPondering();
+	_stopSearch = false;
 	_nodesTraversed = 0;
 	_totalNodesTraversed = 0;
+	_lastScore = 0;
+	if(_evalCache) _evalCache->resetStats();
+	if(_transpositions) {
+		// A new game ages the table like a new move unless asked to start cold
+		if(EvalConfig::keepTranspositions()) _transpositions->newSearch();
+		else _transpositions->clear();
+		_transpositions->resetStats();
+	}
 	_boardSeq->Reset();
 }
+
+double SequentialSolver::getEvalCacheHitRate() {
+	return _evalCache ? _evalCache->hitRate() : 0.0;
+}
+
+void SequentialSolver::startPondering(Player player, int maxDepth) {
+	this->stopPondering();
+	if(_boardSeq->DetermineWinner() != Player::None || _boardSeq->IsFull()) return;
+	_ponderReply = -1;
+	_ponderThread = std::thread(&SequentialSolver::ponder, this, player, maxDepth);
+}
+
+void SequentialSolver::stop() {
+	std::lock_guard<std::mutex> lock(_stopMutex);
+	if(_stopDeferred) _stopPending = true;
+	else _stopSearch = true;
+}
+
+void SequentialSolver::clearStop() {
+	std::lock_guard<std::mutex> lock(_stopMutex);
+	_stopSearch = false;
+	_stopPending = false;
+}
+
+void SequentialSolver::deferStop(bool defer) {
+	std::lock_guard<std::mutex> lock(_stopMutex);
+	if(defer) _stopPending = _stopSearch.exchange(false);
+	else if(_stopPending) _stopSearch = true;
+	_stopDeferred = defer;
+}
+
+void SequentialSolver::stopPondering() {
+	if(!_ponderThread.joinable()) return;
+	// Held back like depth 2 of a search, a stop() from before or during the
+	// join stays in effect once the thread is gone
+	this->deferStop(true);
+	_stopSearch = true;
+	_ponderThread.join();
+	_stopSearch = false;
+	this->deferStop(false);
+}
+
+void SequentialSolver::ponder(Player player, int maxDepth) {
+	SlotStatus* board = _boardSeq->getBoard();
+	Player opponent = this->oppPlayer(player);
+	// The searches score other positions than the last solve(), whose score
+	// stays the first guess of the next one
+	const int lastScore = _lastScore;
+	int reply = this->findBestMove(board, opponent, std::max(2, _searchDepth - 2), -1);
+	if(reply >= 0 && !_stopSearch) {
+		// Search the answer to the predicted reply on the solver's own board,
+		// the reply is taken back before the thread finishes
+		_boardSeq->makeMove(reply, this->getPlayerColor(opponent));
+		if(!_boardSeq->isWinningMove(reply) && !_boardSeq->IsFull()) {
+			_ponderReply = reply;
+			for(int depth = 2; depth <= maxDepth && !_stopSearch; depth += 2)
+				this->findBestMove(board, player, depth, -1);
+		}
+		_boardSeq->undoMove(reply);
+	}
+	_lastScore = lastScore;
+}
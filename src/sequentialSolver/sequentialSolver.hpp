@@ -10,11 +10,19 @@
 #define __SEQ_SOLVER__
 
 #include "boardSeq.hpp"
+#include "connectFourAssets/evalConfig.hpp"
+#include "connectFourAssets/leafBatch.hpp"
+#include "connectFourAssets/transpositionTable.hpp"
 //#include "gameTreeSearchSolver.hpp"
+#include <atomic>
 #include <climits>
 #include <chrono>
+#include <functional>
 #include <iostream>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 //class SequentialSolver : GameTreeSearchSolver
 class SequentialSolver
@@ -26,6 +34,11 @@ class SequentialSolver
     	SequentialSolver(uint_fast8_t width = 7, uint_fast8_t height = 6,
     					 uint_fast8_t winningStreakLength = 4);
 
+        /**
+         * @brief      Stops pondering before the solver goes away.
+         */
+        ~SequentialSolver();
+
         /**
          * @brief     Find the best move for a given game board
          *
@@ -37,6 +50,78 @@ class SequentialSolver
          */
         int solve(Player player, int maxDepth = 6, double time_limit = -1);
 
+        /**
+         * @brief      Searches the current position without playing the move.
+         *
+         * @param[in]  player      The player to move
+         * @param[in]  maxDepth    The depth of the search
+         * @param      score       Set to the score of the best move
+         * @param[in]  time_limit  Deepens iteratively up to maxDepth within
+         * the time when positive, see getSearchDepth. Completed depths are
+         * passed to the SearchInfo callback and stop() ends the deepening.
+         *
+         * @return     Returns the column for the best move, -1 if no move exists
+         */
+        int analyze(Player player, int maxDepth, int* score, double time_limit = -1);
+
+        // Score of one root move in analyzeColumns()
+        struct RootScore {
+            // Column (0 based) of the move
+            int column;
+            // Score for the player to move, exact or an upper bound
+            int score;
+            TranspositionTable::Bound bound;
+            // Columns (0 based) of the line from the move on, only the move
+            // for a bound
+            std::vector<int> pv;
+        };
+
+        /**
+         * @brief      Scores every legal move of the current position in one
+         * search (multi-PV). The root moves share the tables, so the later
+         * ones mostly find their subtrees stored.
+         *
+         * @param[in]  player        The player to move
+         * @param[in]  maxDepth      The depth of the search
+         * @param      scores        Set to the scores, best first
+         * @param[in]  exactColumns  Under the pruning drivers, moves that
+         * cannot reach the exactColumns best scores only get an upper bound.
+         * Minimax scores every move exactly.
+         *
+         * @return     Returns the column for the best move, -1 if no move exists
+         */
+        int analyzeColumns(Player player, int maxDepth, std::vector<RootScore>& scores,
+                           int exactColumns = INT_MAX);
+
+        /**
+         * @brief      Sets up the position after the moves, Red moving first.
+         * Nothing of the previous game is kept on the board.
+         *
+         * @param[in]  moves  The columns of the moves as 1 based digits
+         *
+         * @return     The number of moves played, -1 if a move is not legal
+         */
+        int setPosition(const char* moves);
+
+        /**
+         * @brief      Sets up a position slot by slot.
+         *
+         * @param[in]  slots  The slots (row major, top row first)
+         *
+         * @return     False if a piece floats above an empty slot
+         */
+        bool setPosition(const SlotStatus* slots);
+
+        // Column (0 based) the last solve() played, also when the move ended
+        // the game and solve() returned -1. -1 if no move was played.
+        int getLastColumn() { return _lastColumn; }
+
+        // Depth of the last completed search, the nodes it traversed and the
+        // score it found
+        int getSearchDepth() { return _searchDepth; }
+        uint64_t getNodesTraversed() { return _nodesTraversed; }
+        int getLastScore() { return _lastScore; }
+
         /**
          * @brief      Finds the best move.
          *
@@ -44,10 +129,12 @@ class SequentialSolver
          * @param[in]  player     The player
          * @param[in]  maxDepth   The maximum depth for the search
          * @param[in]  time_limit The maximum time limit for the search
+         * @param      bestScore  Set to the score of the best move if not null
          *
          * @return     Returns the index (row major) of the best move on the board
          */
-        int findBestMove(SlotStatus* board, Player player, int maxDepth, double time_limit);
+        int findBestMove(SlotStatus* board, Player player, int maxDepth, double time_limit,
+                         int* bestScore = nullptr);
 
         /**
          * @brief      Finds the opponent for the given player
@@ -74,10 +161,34 @@ class SequentialSolver
          * @param[in]  depth      The depth
          * @param[in]  player     The player
          * @param[in]  maximizer  The maximizer
+         * @param[in]  lastMove   The index of the move that led to this node
          *
          * @return     Returns the best possible score for the current player
          */
-        int minimax(SlotStatus* board, int depth, Player player, bool maximizer);
+        int minimax(SlotStatus* board, int depth, Player player, bool maximizer,
+                    int lastMove);
+
+        /**
+         * @brief      Alpha-beta search of the game tree, fail soft. Returns
+         * the minimax value when it lies inside the window, otherwise a bound
+         * on the wrong side of it.
+         *
+         * @param      board      The board
+         * @param[in]  depth      The depth
+         * @param[in]  player     The player
+         * @param[in]  maximizer  The maximizer
+         * @param[in]  lastMove   The index of the move that led to this node
+         * @param[in]  alpha      The score the maximizer is already sure of
+         * @param[in]  beta       The score the minimizer is already sure of
+         *
+         * @return     Returns the score of the node for the current player
+         */
+        int alphaBeta(SlotStatus* board, int depth, Player player, bool maximizer,
+                      int lastMove, int alpha, int beta);
+
+        // Evaluation of the board at the search horizon, through the eval
+        // cache when there is one
+        int evaluateLeaf(Player player);
 
         /**
          * @brief      Prints the board.
@@ -101,6 +212,19 @@ class SequentialSolver
          */
         uint64_t getTotalNodesTraversed();
 
+        /**
+         * @brief      Gets the winner of the current game.
+         */
+        Player getWinner() { return _boardSeq->DetermineWinner(); }
+
+        /**
+         * @brief      Gets the hit rate of the leaf evaluation cache since the
+         * last reset.
+         *
+         * @return     The hit rate in [0, 1], 0 when the cache is off.
+         */
+        double getEvalCacheHitRate();
+
         /**
          * @brief      Inserts a piece in the specified column
          *
@@ -125,8 +249,121 @@ class SequentialSolver
          */
         bool isTimeLeft(double seconds);
 
+        /**
+         * @brief      Searches in a background thread while the opponent
+         * thinks. The opponent's reply is predicted with a shorter search and
+         * the answer to it is searched with iterative deepening, which fills
+         * the transposition table and the evaluation cache. Every other call
+         * on the solver stops pondering first, so after a correct prediction
+         * solve() picks up the finished part of the search from the table.
+         *
+         * @param[in]  player    The player this solver plays
+         * @param[in]  maxDepth  The deepest search to ponder
+         */
+        void startPondering(Player player, int maxDepth);
+
+        /**
+         * @brief      Stops pondering and waits for the background search to
+         * unwind. Nothing the aborted search computed is stored.
+         */
+        void stopPondering();
+
+        /**
+         * @brief      Called by solve() and a timed analyze() after every completed depth with the
+         * depth, the score, the column (0 based) of the best move and the
+         * nodes of that depth. Returning false ends the iterative deepening
+         * with the move found so far.
+         */
+        using SearchInfo = std::function<bool(int depth, int score, int column, uint64_t nodes)>;
+        void setSearchInfo(SearchInfo info) { _searchInfo = std::move(info); }
+
+        /**
+         * @brief      Line of play that keeps the score after the move of a
+         * completed depth. Only valid from the SearchInfo callback, where the
+         * board is still the searched position. Its nodes are not counted.
+         *
+         * @param[in]  player  The player to move
+         * @param[in]  depth   The depth passed to the callback
+         * @param[in]  column  The column passed to the callback
+         * @param[in]  score   The score passed to the callback
+         *
+         * @return     The columns (0 based) of the line, starting with column
+         */
+        std::vector<int> bestLine(Player player, int depth, int column, int score);
+
+        /**
+         * @brief      Makes a solve() or a timed analyze() running on another
+         * thread return early with the move of the deepest completed search.
+         * A stop() stays in effect, also for searches that have not
+         * started yet, until clearStop() or resetSolver().
+         */
+        void stop();
+
+        /**
+         * @brief      Takes back a stop(). Called before a search is started on
+         * another thread, so that a stop() right after the start is not lost.
+         */
+        void clearStop();
+
+        // Moves played while pondering, and how many of them were predicted
+        uint64_t getPonderMoves() { return _ponderMoves; }
+        uint64_t getPonderHits() { return _ponderHits; }
+
     private:
+        // Body of the pondering thread
+        void ponder(Player player, int maxDepth);
+        // Searches the root moves with alpha-beta and the window, sets move to
+        // the best one and returns its score
+        int searchRoot(SlotStatus* board, Player player, int maxDepth, double time_limit,
+                       int alpha, int beta, int& move);
+        // Appends the line that keeps the score after the move at lastMove,
+        // searched to depth like a root move
+        void principalVariation(SlotStatus* board, int depth, Player player, int lastMove, int score,
+                                std::vector<int>& pv);
+        // Holds back stop() while defer is set, a stop() that came before or
+        // during the hold takes effect when it is released
+        void deferStop(bool defer);
+        // Runs the root searches of a pruning driver (EvalConfig::searchDriver)
+        int searchWithDriver(SlotStatus* board, Player player, int maxDepth, double time_limit,
+                             EvalConfig::SearchDriver driver, int& move);
+
+        // Half width of the first aspiration window
+        static constexpr int kAspirationDelta = 64;
+
     	BoardSequential* _boardSeq;
+        // Scores the last plies of the search as one block, null if the
+        // geometry does not fit in a bitboard
+        LeafBatch* _leafBatch;
+        // Horizon evaluations reused across transpositions, shared with the
+        // leaf batch. Null when turned off with --eval-cache off
+        EvalCache* _evalCache;
+        // Interior node values kept across moves, null when turned off with
+        // --tt off
+        TranspositionTable* _transpositions;
+        // Empty slots left on the searched board, kept up to date by the search
+        int _emptySlots;
+        // Depth of the last search solve() completed, pondering predicts
+        // replies two plies shallower
+        int _searchDepth;
+        // Score of the last completed search, the first guess of the
+        // aspiration and MTD(f) drivers
+        int _lastScore;
+        int _lastColumn;
+        std::thread _ponderThread;
+        // Set to make the pondering search or a stopped solve() unwind
+        std::atomic<bool> _stopSearch;
+        // Depth 2 of a deepening search runs to the end whatever the stop(),
+        // so it always has a move. _stopDeferred marks it, and the join of the
+        // pondering thread, and _stopPending keeps a stop() that came
+        // meanwhile.
+        std::mutex _stopMutex;
+        bool _stopDeferred;
+        bool _stopPending;
+        SearchInfo _searchInfo;
+        // Slot index of the reply being pondered on, -1 if none
+        int _ponderReply;
+        uint64_t _ponderMoves;
+        uint64_t _ponderHits;
     	uint64_t _nodesTraversed;
         uint64_t _totalNodesTraversed;
 		std::chrono::high_resolution_clock::time_point _start;
@@ -15,7 +15,27 @@
 #include "sequentialSolver/sequentialSolver.hpp"
 #include "gameTreeSearchSolver.hpp"
 #include "mpSolver/mpSolver.hpp"
+#include "mctsSolver/mctsSolver.hpp"
+#include "exactSolver/exactSolver.hpp"
+#include "exactSolver/solvedStore.hpp"
+#include "engine/engine.hpp"
+#include "connectFourAssets/evalKernel.hpp"
+#include "connectFourAssets/patternEval.hpp"
+#include "connectFourAssets/playoutKernel.hpp"
+#include "connectFourAssets/zobrist.hpp"
+#include "connectFourAssets/evalConfig.hpp"
+#include "connectFourAssets/gameRecord.hpp"
+#include "connectFourAssets/tablebase.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 using namespace std;
 
@@ -23,28 +43,95 @@ using namespace std;
 #define NOW std::chrono::high_resolution_clock::now
 typedef std::chrono::high_resolution_clock::time_point TimePoint;
 
+/**
+ * @brief      Records the games of a tournament to GameRecordWriter::shared()
+ * when --record is given. solve() stands in for the solver's own solve() and
+ * notes the move it played; without a record file it only forwards the call.
+ */
+class GameRecorder {
+	public:
+		GameRecorder(Player first) : _writer(GameRecordWriter::shared()) { _game.first = first; }
+
+		template <class Solver>
+		int solve(Solver& solver, Player player, int maxDepth, double time_limit) {
+			if(!_writer.isOpen()) return solver.solve(player, maxDepth, time_limit);
+			TimePoint start = NOW();
+			int move = solver.solve(player, maxDepth, time_limit);
+			double micros = std::chrono::duration<double, std::micro>(NOW() - start).count();
+			// The move that ends the game is played although solve() returns -1
+			if(solver.getLastColumn() >= 0) {
+				GameMove played;
+				played.column = solver.getLastColumn();
+				played.depth = searchDepth(solver);
+				played.score = lastScore(solver);
+				played.micros = (uint32_t)std::min(micros, 4e9);
+				played.nodes = solver.getNodesTraversed();
+				_game.moves.push_back(played);
+			}
+			if(move == -1) {
+				Player winner = solver.getWinner();
+				if(winner == Player::None) _game.result = GameRecord::Result::Draw;
+				else if(winner == _game.first) _game.result = GameRecord::Result::FirstWins;
+				else _game.result = GameRecord::Result::SecondWins;
+			}
+			return move;
+		}
+
+		// Writes the game and starts the next one
+		void finish() {
+			if(_writer.isOpen()) _writer.write(_game);
+			_game.moves.clear();
+			_game.result = GameRecord::Result::Unfinished;
+		}
+
+	private:
+		GameRecordWriter& _writer;
+		GameRecord _game;
+
+		// Only the minimax solvers keep a search depth and a score
+		static int searchDepth(SequentialSolver& solver) { return solver.getSearchDepth(); }
+		static int searchDepth(MpSolver& solver) { return solver.getSearchDepth(); }
+		template <class Solver>
+		static int searchDepth(Solver&) { return 0; }
+		static int lastScore(SequentialSolver& solver) { return solver.getLastScore(); }
+		static int lastScore(MpSolver& solver) { return solver.getLastScore(); }
+		template <class Solver>
+		static int lastScore(Solver&) { return 0; }
+};
+
 void tournament_seq_vs_seq(Player p1, double time_limit, int maxDepth,
 						   int width, int height, int winningStreakSize,
 						   int num_games) {
 	SequentialSolver* seq1 = new SequentialSolver(width, height, winningStreakSize);
 	SequentialSolver* seq2 = new SequentialSolver(width, height, winningStreakSize);
 	Player p2 = seq1->oppPlayer(p1);	
+	GameRecorder record(p1);
+	// Solvers search on the opponent's time, as deep as their own searches go.
+	// Pondering is stopped by the next call on the solver.
+	bool ponder = EvalConfig::ponder();
+	int ponderDepth = (time_limit > 0) ? width * height : maxDepth;
 	TimePoint start, end;
 	uint64_t totalNodes1, totalNodes2;
 	totalNodes2 = 0;
 	totalNodes1 = 0;
+	double hitRate1 = 0, hitRate2 = 0;
 	start = NOW();
 	for(int i = 0; i < num_games; i++) {
 		while(1) {
-			int move = seq1->solve(p1, maxDepth, time_limit);
+			int move = record.solve(*seq1, p1, maxDepth, time_limit);
 			if(move == -1) break;
+			if(ponder) seq1->startPondering(p1, ponderDepth);
 			seq2->playMove(move+1, p1); // add one because this uses 1-indexed col
-			move = seq2->solve(p2, maxDepth, time_limit);
+			move = record.solve(*seq2, p2, maxDepth, time_limit);
 			if(move == -1) break;
+			if(ponder) seq2->startPondering(p2, ponderDepth);
 			seq1->playMove(move+1, p2);
 		}
+		record.finish();
 		totalNodes1 += seq1->getTotalNodesTraversed();
 		totalNodes2 += seq2->getTotalNodesTraversed();
+		hitRate1 += seq1->getEvalCacheHitRate();
+		hitRate2 += seq2->getEvalCacheHitRate();
 		seq1->resetSolver();
 		seq2->resetSolver();
 	}
@@ -58,6 +145,10 @@ void tournament_seq_vs_seq(Player p1, double time_limit, int maxDepth,
 										totalNodes1 / num_games << endl;
 	cout << "[SLO-POKE1 VS SLO-POKE2] SLO-POKE2.AvgNodesTraversed = " << 
 										totalNodes2 / num_games << endl;
+	cout << "[SLO-POKE1 VS SLO-POKE2] SLO-POKE1.AvgEvalCacheHitRate = " <<
+										hitRate1 / num_games << endl;
+	cout << "[SLO-POKE1 VS SLO-POKE2] SLO-POKE2.AvgEvalCacheHitRate = " <<
+										hitRate2 / num_games << endl;
 }
 
 void tournament_seq_vs_cuda(Player p1, double time_limit, int maxDepth,
@@ -66,6 +157,9 @@ void tournament_seq_vs_cuda(Player p1, double time_limit, int maxDepth,
     SequentialSolver* seq = new SequentialSolver(width, height, winningStreakSize);
 	CudaSolver* cu = new CudaSolver(width, height, winningStreakSize);
 	Player p2 = seq->oppPlayer(p1);	
+	GameRecorder record(p1);
+	bool ponder = EvalConfig::ponder();
+	int ponderDepth = (time_limit > 0) ? width * height : maxDepth;
 	TimePoint start, end;
 	uint64_t totalNodes1, totalNodes2;
 	totalNodes2 = 0;
@@ -73,13 +167,15 @@ void tournament_seq_vs_cuda(Player p1, double time_limit, int maxDepth,
 	start = NOW();
 	for(int i = 0; i < num_games; i++) {
 		while(1) {
-			int move = seq->solve(p1, maxDepth, time_limit);
+			int move = record.solve(*seq, p1, maxDepth, time_limit);
 			if(move == -1) break;
+			if(ponder) seq->startPondering(p1, ponderDepth);
 			cu->playMove(move+1, p1); // add one because this uses 1-indexed col
-			move = cu->solve(p2, maxDepth, time_limit);
+			move = record.solve(*cu, p2, maxDepth, time_limit);
 			if(move == -1) break;
 			seq->playMove(move+1, p2);
 		}
+		record.finish();
 		totalNodes1 += seq->getTotalNodesTraversed();
 		totalNodes2 += cu->getTotalNodesTraversed();
 		seq->resetSolver();
@@ -103,6 +199,9 @@ void tournament_seq_vs_omp(Player p1, double time_limit, int maxDepth,
 	SequentialSolver* seq = new SequentialSolver(width, height, winningStreakSize);                        					   
 	MpSolver* 	  mp  = new MpSolver(width, height, winningStreakSize);                        					   
 	Player p2 = seq->oppPlayer(p1);	                                                                					   
+	GameRecorder record(p1);
+	bool ponder = EvalConfig::ponder();
+	int ponderDepth = (time_limit > 0) ? width * height : maxDepth;
 	TimePoint start, end;                                                                                   					   
 	uint64_t totalNodes1, totalNodes2;                                                                      					   
 	totalNodes2 = 0;                                                                                        					   
@@ -110,13 +209,16 @@ void tournament_seq_vs_omp(Player p1, double time_limit, int maxDepth,
 	start = NOW();                                                                                          					   
 	for(int i = 0; i < num_games; i++) {                                                                    					   
 		while(1) {                                                                                      					   
-			int move = seq->solve(p1, maxDepth, time_limit);                                       					   
+			int move = record.solve(*seq, p1, maxDepth, time_limit);                                       					   
 			if(move == -1) break;                                                                   					   
+			if(ponder) seq->startPondering(p1, ponderDepth);
 			mp->playMove(move+1, p1); // add one because this uses 1-indexed col                                                             					   
-			move = mp->solve(p2, maxDepth, time_limit);                                           					   
+			move = record.solve(*mp, p2, maxDepth, time_limit);                                           					   
 			if(move == -1) break;                                                                   					   
+			if(ponder) mp->startPondering(p2, ponderDepth);
 			seq->playMove(move+1, p2);                                                               					   
 		}                                                                                              					   
+		record.finish();
 		totalNodes1 += seq->getTotalNodesTraversed();                                                  					   
 		totalNodes2 += mp->getTotalNodesTraversed();                                                  					   
 		seq->resetSolver();                                                                            					   
@@ -167,28 +269,610 @@ int test_seq_timing(int width, int height, int winningStreakSize)
 {
     // Command line options parser
     // parser(argc, argv);
-    SequentialSolver* sol = new SequentialSolver(width, height, winningStreakSize);
+    // Every search driver deepens from the empty board on a fresh solver, the
+    // windowed drivers start each depth from the score and the table entries
+    // of the one before like in solve(). Times and nodes are cumulative.
+    const EvalConfig::SearchDriver configured = EvalConfig::searchDriver();
+    for(auto driver : {EvalConfig::SearchDriver::Minimax, EvalConfig::SearchDriver::AlphaBeta,
+                       EvalConfig::SearchDriver::Aspiration, EvalConfig::SearchDriver::Mtdf}) {
+        EvalConfig::setSearchDriver(driver);
+        SequentialSolver sol(width, height, winningStreakSize);
+        TimePoint start = NOW();
+        for(int i = 2; i <= 12; i+=2) {
+            int score;
+            int column = sol.analyze(Player::Red, i, &score);
+            TimePoint end = NOW();
+            cout << EvalConfig::searchDriverName(driver) << " depth " << i << " took "
+                 << DURATION(end - start).count() << " nodes " << sol.getTotalNodesTraversed()
+                 << " move " << column + 1 << " eval cache hit rate " << sol.getEvalCacheHitRate() << endl;
+        }
+    }
+    EvalConfig::setSearchDriver(configured);
+    return 0;
+}
+
+int test_omp_timing(int width, int height, int winningStreakSize) {
+    const EvalConfig::SearchDriver configured = EvalConfig::searchDriver();
+    for(auto driver : {EvalConfig::SearchDriver::Minimax, EvalConfig::SearchDriver::AlphaBeta,
+                       EvalConfig::SearchDriver::Aspiration, EvalConfig::SearchDriver::Mtdf}) {
+      EvalConfig::setSearchDriver(driver);
+      MpSolver sol(width, height, winningStreakSize);
+      TimePoint start = NOW();
+      for(int i = 2; i <= 6; i+=2) {
+        int score;
+        int column = sol.analyze(Player::Red, i, &score);
+        TimePoint end = NOW();
+        cout << EvalConfig::searchDriverName(driver) << " depth " << i << " took "
+             << DURATION(end - start).count() << " nodes " << sol.getTotalNodesTraversed()
+             << " move " << column + 1 << " eval cache hit rate " << sol.getEvalCacheHitRate() << endl;
+      }
+    }
+    EvalConfig::setSearchDriver(configured);
+    return 0;
+}
+
+int test_eval_kernel(int width, int height, int winningStreakSize, int num_positions) {
+    // Validates every compiled evaluation kernel against the scalar reference
+    // over random positions, then times the scalar and the active path.
+    Board* board = new Board(width, height, winningStreakSize);
+    std::mt19937 rng(759);
+    std::vector<SlotStatus> positions;
+    int numSlots = width * height;
+    for(int n = 0; n < num_positions; n++) {
+        randomPosition(*board, rng, rng() % (numSlots + 1));
+        positions.insert(positions.end(), board->getBoard(), board->getBoard() + numSlots);
+    }
+
+    int mismatches = 0;
+    const EvalKernel::Isa isas[] = {EvalKernel::Isa::Scalar, EvalKernel::Isa::SSE2,
+                                    EvalKernel::Isa::AVX2};
+    for(int n = 0; n < num_positions; n++) {
+        std::copy(positions.begin() + n * numSlots, positions.begin() + (n + 1) * numSlots,
+                  board->getBoard());
+        for(Player p : {Player::Red, Player::Yellow}) {
+            int expected = board->EvaluateBoardScalar(p);
+            for(auto isa : isas) {
+                if(!EvalKernel::isaSupported(isa)) continue;
+                int got = EvalKernel::evaluateWith(isa, board->getBoard(), width, height,
+                                                   winningStreakSize, p);
+                if(got != expected) {
+                    if(mismatches < 10) {
+                        cout << "[EVAL-KERNEL] " << EvalKernel::isaName(isa) << " scored "
+                             << got << " instead of " << expected << endl;
+                        board->printBoard();
+                    }
+                    mismatches++;
+                }
+            }
+        }
+    }
+
+    // The batch evaluator has to agree with the scalar version as well
+    if(BatchEvaluator::supportsGeometry(width, height, winningStreakSize)) {
+        BatchEvaluator batch(width, height, winningStreakSize);
+        std::vector<Position> batchPositions;
+        std::vector<int> expected;
+        for(int n = 0; n < num_positions; n++) {
+            std::copy(positions.begin() + n * numSlots, positions.begin() + (n + 1) * numSlots,
+                      board->getBoard());
+            for(Player p : {Player::Red, Player::Yellow}) {
+                batchPositions.push_back(PositionHelpers::fromBoard(board->getBoard(), numSlots, p));
+                expected.push_back(board->EvaluateBoardScalar(p));
+            }
+        }
+        std::vector<int> scores(batchPositions.size());
+        for(auto isa : isas) {
+            if(!EvalKernel::isaSupported(isa)) continue;
+            batch.evaluateBatchWith(isa, batchPositions.data(), batchPositions.size(), scores.data());
+            for(size_t n = 0; n < scores.size(); n++) {
+                if(scores[n] != expected[n]) {
+                    if(mismatches < 10) {
+                        cout << "[EVAL-KERNEL] batch " << EvalKernel::isaName(isa) << " scored "
+                             << scores[n] << " instead of " << expected[n] << endl;
+                    }
+                    mismatches++;
+                }
+            }
+        }
+        TimePoint start = NOW();
+        batch.evaluateBatch(batchPositions.data(), batchPositions.size(), scores.data());
+        TimePoint end = NOW();
+        cout << "[EVAL-KERNEL] batch " << EvalKernel::isaName(EvalKernel::activeIsa())
+             << " ns/eval = " << DURATION(end - start).count() * 1e6 / batchPositions.size() << endl;
+    }
+
     TimePoint start, end;
-    for(int i = 2; i <= 12; i+=2) {
+    volatile int sink = 0;
+    start = NOW();
+    for(int n = 0; n < num_positions; n++) {
+        std::copy(positions.begin() + n * numSlots, positions.begin() + (n + 1) * numSlots,
+                  board->getBoard());
+        sink += board->EvaluateBoardScalar(Player::Red);
+    }
+    end = NOW();
+    double scalar_ns = DURATION(end - start).count() * 1e6 / num_positions;
+    start = NOW();
+    for(int n = 0; n < num_positions; n++) {
+        std::copy(positions.begin() + n * numSlots, positions.begin() + (n + 1) * numSlots,
+                  board->getBoard());
+        sink += board->EvaluateBoard(Player::Red);
+    }
+    end = NOW();
+    double kernel_ns = DURATION(end - start).count() * 1e6 / num_positions;
+
+    // The pattern tables have to find the same winners as the scalar version,
+    // and the single and batch lookups have to agree
+    double pattern_ns = -1;
+    if(PositionHelpers::fitsBitboard(width, height) &&
+       PatternEvaluator::supportsGeometry(width, height, winningStreakSize)) {
+        PatternEvaluator pattern(width, height, winningStreakSize);
+        std::vector<Position> patternPositions;
+        for(int n = 0; n < num_positions; n++) {
+            const SlotStatus* slots = positions.data() + n * numSlots;
+            patternPositions.push_back(PositionHelpers::fromBoard(slots, numSlots, Player::Red));
+            std::copy(slots, slots + numSlots, board->getBoard());
+            int expected = board->EvaluateBoardScalar(Player::Red);
+            int got = pattern.evaluate(slots, Player::Red);
+            bool expectedWin = expected == INT_MAX || expected == INT_MIN;
+            bool gotWin = got == INT_MAX || got == INT_MIN;
+            if(expectedWin != gotWin || (expectedWin && got != expected)) {
+                if(mismatches < 10)
+                    cout << "[EVAL-KERNEL] pattern scored " << got << " for a board scored " << expected << endl;
+                mismatches++;
+            }
+        }
+        std::vector<int> scores(num_positions);
         start = NOW();
-        sol->solve(Player::Red, i, -1);
+        pattern.evaluateBatch(patternPositions.data(), patternPositions.size(), scores.data());
         end = NOW();
-        cout << "depth " << i << " took " << DURATION(end - start).count() << endl;
-        sol->resetSolver();
+        pattern_ns = DURATION(end - start).count() * 1e6 / num_positions;
+        for(int n = 0; n < num_positions; n++) {
+            if(scores[n] != pattern.evaluate(positions.data() + n * numSlots, Player::Red)) {
+                if(mismatches < 10) cout << "[EVAL-KERNEL] pattern batch disagrees at " << n << endl;
+                mismatches++;
+            }
+        }
+    }
+
+    cout << "[EVAL-KERNEL] positions = " << num_positions << " mismatches = " << mismatches << endl;
+    cout << "[EVAL-KERNEL] scalar ns/eval = " << scalar_ns << endl;
+    cout << "[EVAL-KERNEL] " << EvalKernel::isaName(EvalKernel::activeIsa())
+         << " ns/eval = " << kernel_ns << endl;
+    if(pattern_ns >= 0)
+        cout << "[EVAL-KERNEL] pattern batch ns/eval = " << pattern_ns << endl;
+    return mismatches;
+}
+
+int test_position_keys(int width, int height, int winningStreakSize, int num_games) {
+    // Plays random games and takes them back with undoMove, checks the
+    // incremental key and mirror key of every position against ones computed
+    // from scratch and counts positions that share a key.
+    // Collisions of the low 32 bits are printed next to the birthday bound
+    // n^2 / 2^33 of random keys, as a check of how well the keys are mixed.
+    Board* board = new Board(width, height, winningStreakSize);
+    std::mt19937 rng(759);
+    int numSlots = width * height;
+    std::unordered_map<uint64_t, std::string> seen;
+    std::unordered_map<uint32_t, std::string> seen32;
+    uint64_t positions = 0, collisions = 0, collisions32 = 0, mismatches = 0;
+
+    for(int g = 0; g < num_games; g++) {
+        std::string moves;
+        randomPosition(*board, rng, numSlots, &moves);
+        // Taking every move back has to give the empty board key again
+        for(; !moves.empty(); moves.pop_back()) {
+            uint64_t key = board->key();
+            if(key != Zobrist::positionKey(board->getBoard(), numSlots)) mismatches++;
+            if(board->mirrorKey() != Zobrist::mirrorPositionKey(board->getBoard(), width, height)) mismatches++;
+            std::string position((const char*)board->getBoard(), numSlots * sizeof(SlotStatus));
+            auto inserted = seen.emplace(key, position);
+            if(!inserted.second && inserted.first->second != position) collisions++;
+            if(inserted.second) {
+                auto inserted32 = seen32.emplace((uint32_t)key, position);
+                if(!inserted32.second) collisions32++;
+            }
+            positions++;
+            // The last piece of the column is its highest one
+            int index = moves.back() - '1';
+            while(board->getBoard()[index] == SlotStatus::Empty) index += width;
+            board->undoMove(index);
+        }
+        if(board->key() != Zobrist::kEmptyKey || board->mirrorKey() != Zobrist::kEmptyKey) mismatches++;
+    }
+
+    double expected32 = (double)seen32.size() * seen32.size() / 8589934592.0;
+    cout << "[POSITION-KEYS] games = " << num_games << " positions = " << positions
+         << " distinct = " << seen.size() << endl;
+    cout << "[POSITION-KEYS] incremental mismatches = " << mismatches << endl;
+    cout << "[POSITION-KEYS] 64 bit collisions = " << collisions << " rate = "
+         << (double)collisions / positions << endl;
+    cout << "[POSITION-KEYS] 32 bit collisions = " << collisions32 << " (birthday bound ~"
+         << expected32 << ")" << endl;
+    return mismatches + collisions;
+}
+
+int test_column_scores(int width, int height, int winningStreakSize, int maxDepth, int num_positions) {
+    // Scores every move of random positions with analyzeColumns on one solver
+    // that keeps its table across positions and search drivers, like the
+    // engine server, after an analyze that leaves bounds in it. Each score has
+    // to match a search of the same move without a table.
+    Board board(width, height, winningStreakSize);
+    std::mt19937 rng(4471);
+    const EvalConfig::SearchDriver configured = EvalConfig::searchDriver();
+    const bool keep = EvalConfig::keepTranspositions();
+    const int tableKb = EvalConfig::transpositionKb();
+    EvalConfig::setKeepTranspositions(true);
+    SequentialSolver warm(width, height, winningStreakSize);
+    EvalConfig::setTranspositionKb(0);
+    SequentialSolver cold(width, height, winningStreakSize);
+    EvalConfig::setTranspositionKb(tableKb);
+    const EvalConfig::SearchDriver drivers[] = {EvalConfig::SearchDriver::Minimax, EvalConfig::SearchDriver::AlphaBeta,
+                                                EvalConfig::SearchDriver::Aspiration, EvalConfig::SearchDriver::Mtdf};
+    int mismatches = 0;
+    for(int n = 0; n < num_positions; n++) {
+        std::string moves;
+        Player turn = randomPosition(board, rng, rng() % 12, &moves);
+        if(board.DetermineWinner() != Player::None || board.IsFull()) {
+            n--;
+            continue;
+        }
+
+        EvalConfig::setSearchDriver(drivers[n % 4]);
+        warm.resetSolver();
+        warm.setPosition(moves.c_str());
+        int score;
+        warm.analyze(turn, maxDepth, &score);
+        std::vector<SequentialSolver::RootScore> scores;
+        warm.analyzeColumns(turn, maxDepth, scores);
+
+        // Without a table the moves are searched independently of each other
+        EvalConfig::setSearchDriver(EvalConfig::SearchDriver::Minimax);
+        cold.resetSolver();
+        cold.setPosition(moves.c_str());
+        std::vector<SequentialSolver::RootScore> reference;
+        cold.analyzeColumns(turn, maxDepth, reference);
+        for(const SequentialSolver::RootScore& root : reference) {
+            auto found = std::find_if(scores.begin(), scores.end(), [&](const SequentialSolver::RootScore& other) {
+                return other.column == root.column;
+            });
+            if(found == scores.end() || found->score != root.score) {
+                if(mismatches++ < 10)
+                    cout << "[COLUMNS] " << (moves.empty() ? "-" : moves) << " "
+                         << EvalConfig::searchDriverName(drivers[n % 4]) << " column " << root.column + 1
+                         << " score " << (found == scores.end() ? 0 : found->score) << " expected "
+                         << root.score << endl;
+            }
+        }
+    }
+    EvalConfig::setSearchDriver(configured);
+    EvalConfig::setKeepTranspositions(keep);
+    cout << "[COLUMNS] positions = " << num_positions << " depth = " << maxDepth
+         << " mismatches = " << mismatches << endl;
+    return mismatches;
+}
+
+int test_tablebase(int width, int height, int winningStreakSize, int num_positions) {
+    // Looks random positions up in the open tablebase, once with Red and once
+    // with Yellow moving first, and compares the values and the best moves
+    // against the exact solver.
+    if(!Tablebase::shared().matches(width, height, winningStreakSize)) {
+        cout << "[TABLEBASE] Open a tablebase of this geometry with --tablebase" << endl;
+        return -1;
+    }
+    if(!ExactSolver::supportsGeometry(width, height, winningStreakSize)) {
+        cout << "[TABLEBASE] The exact solver needs width * (height + 1) <= 64" << endl;
+        return -1;
+    }
+    const Tablebase& tablebase = Tablebase::shared();
+    ExactSolver solver(width, height, winningStreakSize);
+    Board board(width, height, winningStreakSize);
+    std::mt19937 rng(3217);
+    int mismatches = 0;
+    for(int n = 0; n < num_positions; n++) {
+        std::string moves;
+        randomPosition(board, rng, rng() % (width * height), &moves);
+        if(board.DetermineWinner() != Player::None || board.IsFull()) {
+            n--;
+            continue;
+        }
+        BitBoard position;
+        solver.rules().fromMoves(moves.c_str(), position);
+        const int expected = solver.solve(position, ExactSolver::Method::AlphaBeta).value;
+
+        for(Player first : {Player::Red, Player::Yellow}) {
+            // Replays the moves with the first player's color
+            Player toMove = first;
+            board.Reset();
+            for(char move : moves) {
+                board.playMove(move - '0', toMove);
+                toMove = PlayerHelpers::OppositePlayer(toMove);
+            }
+            Tablebase::Value value;
+            const int index = tablebase.bestMove(board.getBoard(), toMove, &value);
+            bool correct = index >= 0 && (int)value - 2 == expected;
+            if(correct) {
+                // The move has to keep the value
+                const int column = index % width;
+                board.playMove(column + 1, toMove);
+                if(board.DetermineWinner() != Player::None) correct = expected == 1;
+                else {
+                    solver.rules().fromMoves((moves + (char)('1' + column)).c_str(), position);
+                    correct = solver.solve(position, ExactSolver::Method::AlphaBeta).value == -expected;
+                }
+            }
+            if(!correct && mismatches++ < 10)
+                cout << "[TABLEBASE] " << (moves.empty() ? "-" : moves) << " "
+                     << (first == Player::Red ? "red" : "yellow") << " first: value "
+                     << (int)value - 2 << " column " << index % width + 1 << " expected " << expected << endl;
+        }
     }
+    cout << "[TABLEBASE] positions = " << num_positions << " mismatches = " << mismatches << endl;
+    return mismatches;
+}
+
+int solve_exact(int width, int height, int winningStreakSize, const char* moves,
+                ExactSolver::Method method) {
+    // Prints the game theoretic value of the position after the moves
+    if(!ExactSolver::supportsGeometry(width, height, winningStreakSize)) {
+        cout << "[EXACT] The exact solvers need width * (height + 1) <= 64" << endl;
+        return -1;
+    }
+    ExactSolver solver(width, height, winningStreakSize);
+    BitBoard position;
+    if(!solver.rules().fromMoves(moves, position)) {
+        cout << "[EXACT] Invalid move sequence " << moves << endl;
+        return -1;
+    }
+    ExactSolver::Result result = solver.solve(position, method);
+    const char* values[] = {"loss", "draw", "win"};
+    cout << "[EXACT] " << moves << ": " << values[result.value + 1] << " for the player to move";
+    if(result.column >= 0) cout << ", best column " << result.column + 1;
+    cout << endl;
+    if(result.stored) cout << "[EXACT] read from the solved store in " << result.seconds << " s" << endl;
+    else cout << "[EXACT] solved by " << ExactSolver::methodName(result.method) << " in "
+              << result.seconds << " s, nodes = " << result.nodes << endl;
+    return result.value;
+}
+
+int bench_exact(int width, int height, int winningStreakSize, const char* path) {
+    // Solves every position of the file (one move sequence per line) with
+    // alpha-beta and with df-pn, each one capped at kBenchNodes nodes
+    const uint64_t kBenchNodes = ExactSolver::kStallNodes * 16;
+    if(!ExactSolver::supportsGeometry(width, height, winningStreakSize)) {
+        cout << "[EXACT] The exact solvers need width * (height + 1) <= 64" << endl;
+        return -1;
+    }
+    std::ifstream in(path);
+    if(!in) {
+        cout << "[EXACT] Cannot read " << path << endl;
+        return -1;
+    }
+    // The store would answer for the second solver
+    if(SolvedStore::shared().isOpen()) {
+        cout << "[EXACT] Benchmarking without the solved store" << endl;
+        SolvedStore::shared().close();
+    }
+    ExactSolver solver(width, height, winningStreakSize);
+    const ExactSolver::Method methods[] = {ExactSolver::Method::AlphaBeta, ExactSolver::Method::Dfpn};
+    double seconds[2] = {0, 0};
+    int solved[2] = {0, 0};
+    int positions = 0, disagreements = 0;
+    std::string line;
+    while(std::getline(in, line)) {
+        if(line.empty() || line[0] == '#') continue;
+        BitBoard position;
+        if(!solver.rules().fromMoves(line.c_str(), position)) {
+            cout << "[EXACT] Skipping invalid move sequence " << line << endl;
+            continue;
+        }
+        positions++;
+        ExactSolver::Result results[2];
+        cout << "[EXACT] " << line;
+        for(int m = 0; m < 2; m++) {
+            results[m] = solver.solve(position, methods[m], kBenchNodes);
+            seconds[m] += results[m].seconds;
+            solved[m] += results[m].solved;
+            cout << " | " << ExactSolver::methodName(methods[m]) << " ";
+            if(results[m].solved) cout << results[m].value << " in " << results[m].seconds << " s";
+            else cout << "stalled after " << results[m].seconds << " s";
+        }
+        cout << endl;
+        if(results[0].solved && results[1].solved && results[0].value != results[1].value)
+            disagreements++;
+    }
+    for(int m = 0; m < 2; m++) {
+        cout << "[EXACT] " << ExactSolver::methodName(methods[m]) << " solved " << solved[m]
+             << " of " << positions << " in " << seconds[m] << " s" << endl;
+    }
+    cout << "[EXACT] disagreements = " << disagreements << endl;
+    return disagreements;
+}
+
+int analyze_positions(int width, int height, int winningStreakSize, const char* path,
+                      int maxDepth, double time_limit, int num_threads) {
+    // Analyzes one move sequence per line of the file ("-" for stdin) and
+    // streams a tab separated line per position to stdout, in input order:
+    // moves, status, column (1 based, 0 if none), score, depth, nodes and
+    // milliseconds. Lines are read in blocks the threads share, so memory
+    // stays bounded however long the input is.
+    std::ifstream file;
+    if(strcmp(path, "-")) {
+        file.open(path);
+        if(!file) {
+            cerr << "[ANALYZE] Cannot read " << path << endl;
+            return -1;
+        }
+    }
+    std::istream& in = strcmp(path, "-") ? file : std::cin;
+    Engine::Limits limits;
+    limits.depth = maxDepth;
+    limits.seconds = time_limit;
+    const size_t kBlockSize = 256 * (size_t)std::max(num_threads, 1);
+    std::vector<std::string> lines;
+    std::vector<Engine::Result> results;
+    std::vector<double> millis;
+    std::string line;
+    long positions = 0;
+    TimePoint start = NOW();
+    bool more = true;
+    while(more) {
+        lines.clear();
+        while(lines.size() < kBlockSize && (more = (bool)std::getline(in, line))) {
+            if(!line.empty() && line.back() == '\r') line.pop_back();
+            if(line.empty() || line[0] == '#') continue;
+            lines.push_back(line);
+        }
+        results.resize(lines.size());
+        millis.resize(lines.size());
+        #pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+        for(long i = 0; i < (long)lines.size(); i++) {
+            TimePoint begin = NOW();
+            results[i] = Engine::search(width, height, winningStreakSize, lines[i].c_str(), limits);
+            millis[i] = DURATION(NOW() - begin).count();
+        }
+        for(size_t i = 0; i < lines.size(); i++) {
+            const Engine::Result& result = results[i];
+            cout << lines[i] << '\t' << Engine::statusName(result.status) << '\t' << result.column + 1
+                 << '\t' << result.score << '\t' << result.depth << '\t' << result.nodes << '\t'
+                 << millis[i] << '\n';
+        }
+        cout.flush();
+        positions += lines.size();
+    }
+    cerr << "[ANALYZE] " << positions << " positions in " << DURATION(NOW() - start).count() / 1000
+         << " s" << endl;
+    SolvedStore& store = SolvedStore::shared();
+    if(store.isOpen())
+        cerr << "[ANALYZE] solved store hit rate " << 100.0 * store.hitRate() << "% (" << store.hits() << "/"
+             << store.probes() << "), " << store.size() << " positions stored" << endl;
     return 0;
 }
 
-int test_omp_timing(int width, int height, int winningStreakSize) {
-    MpSolver* sol = new MpSolver(width, height, winningStreakSize);
-    TimePoint start, end;
-    for(int i = 2; i <= 6; i+=2) {
-      start = NOW();
-      sol->solve(Player::Red, i, -1);
-      end = NOW();
-      cout << "depth " << i << " took " << DURATION(end - start).count() << endl;
-      sol->resetSolver();
+int bench_cancel(int width, int height, int winningStreakSize, int num_positions) {
+    // Starts unbounded searches of random positions with solveAsync and
+    // cancels each after a random delay, the heuristic search and (where the
+    // geometry allows) the exact solver in turn. A cancelled heuristic search
+    // has to come back with the move of its deepest completed depth.
+    Board board(width, height, winningStreakSize);
+    std::mt19937 rng(2039);
+    const bool exact = ExactSolver::supportsGeometry(width, height, winningStreakSize);
+    std::vector<double> latencies[2];
+    int missing = 0;
+    for(int n = 0; n < num_positions; n++) {
+        std::string moves;
+        randomPosition(board, rng, 4 + rng() % 8, &moves);
+        if(board.DetermineWinner() != Player::None || board.IsFull()) {
+            n--;
+            continue;
+        }
+
+        Engine::Limits limits;
+        limits.depth = width * height;
+        limits.exact = exact && n % 2;
+        std::shared_ptr<Engine::SearchHandle> search =
+            Engine::solveAsync(width, height, winningStreakSize, moves.c_str(), limits);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20 + rng() % 80));
+        search->cancel();
+        Engine::Result result = search->wait();
+        // Searches that ended on their own before the cancel have no latency
+        if(search->cancelLatency() >= 0) latencies[limits.exact].push_back(search->cancelLatency());
+        if(!limits.exact && result.status != Engine::Status::Ok) missing++;
+    }
+
+    const char* names[2] = {"heuristic", "exact"};
+    for(int kind = 0; kind < 2; kind++) {
+        std::vector<double>& sorted = latencies[kind];
+        if(sorted.empty()) continue;
+        std::sort(sorted.begin(), sorted.end());
+        double mean = 0;
+        for(double latency : sorted) mean += latency;
+        mean /= sorted.size();
+        cout << "[CANCEL] " << names[kind] << " cancels = " << sorted.size() << " latency ms mean = " << mean
+             << " p50 = " << sorted[sorted.size() / 2]
+             << " p99 = " << sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)]
+             << " max = " << sorted.back() << endl;
+    }
+    cout << "[CANCEL] heuristic searches without a move = " << missing << endl;
+    return missing;
+}
+
+int replay_games(const char* path) {
+    // Prints the games of a --record file, one per line: the moves (1 based
+    // columns), the result, and the nodes and milliseconds of both sides
+    GameRecordReader reader;
+    if(!reader.open(path)) return 1;
+    const GameRecordHeader& header = reader.header();
+    cout << "[REPLAY] " << reader.size() << " games of " << (int)header.width << "x" << (int)header.height
+         << " with a streak of " << (int)header.winningStreakSize << endl;
+    GameRecord game;
+    int corrupt = 0;
+    for(size_t i = 0; i < reader.size(); i++) {
+        if(!reader.read(i, game)) {
+            cout << i << "\tcorrupt" << endl;
+            corrupt++;
+            continue;
+        }
+        std::string moves;
+        uint64_t nodes[2] = {0, 0};
+        double millis[2] = {0, 0};
+        for(size_t ply = 0; ply < game.moves.size(); ply++) {
+            const GameMove& move = game.moves[ply];
+            moves += (move.column < 9) ? std::to_string(move.column + 1) : "(" + std::to_string(move.column + 1) + ")";
+            nodes[ply % 2] += move.nodes;
+            millis[ply % 2] += move.micros / 1000.0;
+        }
+        cout << i << "\t" << moves << "\t" << GameRecord::resultName(game.result) << "\t" << game.moves.size()
+             << "\t" << nodes[0] << "/" << nodes[1] << "\t" << millis[0] << "/" << millis[1] << endl;
+    }
+    return corrupt;
+}
+
+int bench_playouts(int width, int height, int winningStreakSize, int num_positions) {
+    // Random playouts from random open positions on one core, for every
+    // instruction set. The counts have to be the same on all of them.
+    if(!PlayoutBatch::supportsGeometry(width, height, winningStreakSize)) {
+        cout << "[PLAYOUTS] The batched playouts need width * (height + 1) <= 64" << endl;
+        return 0;
+    }
+    const int playouts = 1000;
+    Board board(width, height, winningStreakSize);
+    std::mt19937 rng(1093);
+    int numSlots = width * height;
+    std::vector<Position> positions;
+    while((int)positions.size() < num_positions) {
+        Player turn = randomPosition(board, rng, rng() % numSlots);
+        if(board.DetermineWinner() != Player::None || board.IsFull()) continue;
+        positions.push_back(PositionHelpers::fromBoard(board.getBoard(), numSlots, turn));
+    }
+
+    PlayoutBatch batch(width, height, winningStreakSize);
+    std::vector<PlayoutCounts> expected(num_positions), counts(num_positions);
+    batch.runWith(EvalKernel::Isa::Scalar, positions.data(), num_positions, playouts, 1, expected.data());
+    int mismatches = 0;
+    const EvalKernel::Isa isas[] = {EvalKernel::Isa::Scalar, EvalKernel::Isa::SSE2,
+                                    EvalKernel::Isa::AVX2};
+    for(auto isa : isas) {
+        if(!EvalKernel::isaSupported(isa)) continue;
+        TimePoint start = NOW();
+        batch.runWith(isa, positions.data(), num_positions, playouts, 1, counts.data());
+        TimePoint end = NOW();
+        for(int n = 0; n < num_positions; n++) {
+            if(counts[n].wins != expected[n].wins || counts[n].draws != expected[n].draws ||
+               counts[n].losses != expected[n].losses) mismatches++;
+        }
+        cout << "[PLAYOUTS] " << EvalKernel::isaName(isa) << " playouts/s per core = "
+             << (double)num_positions * playouts * 1000 / DURATION(end - start).count() << endl;
     }
+
+    uint64_t wins = 0, draws = 0;
+    for(const PlayoutCounts& c : expected) {
+        wins += c.wins;
+        draws += c.draws;
+    }
+    cout << "[PLAYOUTS] positions = " << num_positions << " mismatches = " << mismatches << endl;
+    cout << "[PLAYOUTS] player to move wins " << (double)wins / ((uint64_t)num_positions * playouts)
+         << " draws " << (double)draws / ((uint64_t)num_positions * playouts) << endl;
+    return mismatches;
 }
 
 void tournament_cuda_vs_omp(Player p1, double time_limit, int maxDepth,
@@ -197,6 +881,9 @@ void tournament_cuda_vs_omp(Player p1, double time_limit, int maxDepth,
 	CudaSolver* cu = new CudaSolver(width, height, winningStreakSize);                        					   
 	MpSolver* 	  mp  = new MpSolver(width, height, winningStreakSize);         
 	Player p2 = PlayerHelpers::OppositePlayer(p1);	                                      						   
+	GameRecorder record(p1);
+	bool ponder = EvalConfig::ponder();
+	int ponderDepth = (time_limit > 0) ? width * height : maxDepth;
 	TimePoint start, end;                                                						   
 	uint64_t totalNodes1, totalNodes2;                                     					   						   
 	totalNodes2 = 0;                                                  					   						   
@@ -204,13 +891,15 @@ void tournament_cuda_vs_omp(Player p1, double time_limit, int maxDepth,
 	start = NOW();                                           					   						   
 	for(int i = 0; i < num_games; i++) {                                        
 		while(1) {                                                    						   
-			int move = cu->solve(p1, maxDepth, time_limit);      						   
+			int move = record.solve(*cu, p1, maxDepth, time_limit);      						   
 			if(move == -1) break;                             	   						   
 			mp->playMove(move+1, p1); // add one because this uses 1-indexed col                         						   
-			move = mp->solve(p2, maxDepth, time_limit);     	     						   
+			move = record.solve(*mp, p2, maxDepth, time_limit);     	     						   
 			if(move == -1) break;                          				   						   
+			if(ponder) mp->startPondering(p2, ponderDepth);
 			cu->playMove(move+1, p2);                      				    						   
 		}                                                     					   						   
+		record.finish();
 		totalNodes1 += cu->getTotalNodesTraversed();        					    						   
 		totalNodes2 += mp->getTotalNodesTraversed();        					     						   
 		cu->resetSolver();                                  					    						   
@@ -234,6 +923,8 @@ void tournament_human_vs_seq(Player p1, double time_limit, int maxDepth,
 						   int num_games, bool human_first) {
 	SequentialSolver* seq1 = new SequentialSolver(width, height, winningStreakSize);
 	Player p2 = seq1->oppPlayer(p1);	
+	bool ponder = EvalConfig::ponder();
+	int ponderDepth = (time_limit > 0) ? width * height : maxDepth;
 	uint64_t totalNodes1;
 	totalNodes1 = 0;
 	int move = -1;
@@ -252,6 +943,7 @@ void tournament_human_vs_seq(Player p1, double time_limit, int maxDepth,
 			if(move == -1) break;
 			cout << "AI plays in column: " << move + 1 << endl;
 			seq1->printBoard();
+			if(ponder) seq1->startPondering(p1, ponderDepth);
 			move = -1;
 			while(move == -1) {
 	            cout << "Enter the column where you want to play your move: ";
@@ -269,6 +961,9 @@ void tournament_human_vs_seq(Player p1, double time_limit, int maxDepth,
 	// Print stats of tournament
 	cout << "[SLO-POKE VS PUNY-MORTAL] AvgNodesTraversed = " << 
 										totalNodes1 / num_games << endl;
+	if(ponder)
+		cout << "[SLO-POKE VS PUNY-MORTAL] PonderHits = " << seq1->getPonderHits() << "/"
+			 << seq1->getPonderMoves() << endl;
 }
 
 void tournament_human_vs_cuda(Player p1, double time_limit, int maxDepth,
@@ -319,6 +1014,8 @@ void tournament_human_vs_omp(Player p1, double time_limit, int maxDepth,
 						   int num_games, bool human_first) {
 	MpSolver* mp1 = new MpSolver(width, height, winningStreakSize);    
 	Player p2 = mp1->oppPlayer(p1);	                          
+	bool ponder = EvalConfig::ponder();
+	int ponderDepth = (time_limit > 0) ? width * height : maxDepth;
 	uint64_t totalNodes1;                                            
 	totalNodes1 = 0;                                                
 	int move = -1;                                                 
@@ -337,6 +1034,7 @@ void tournament_human_vs_omp(Player p1, double time_limit, int maxDepth,
 			if(move == -1) break;                       
 			cout << "AI plays in column: " << move + 1 << endl; 
 			mp1->printBoard();                                
+			if(ponder) mp1->startPondering(p1, ponderDepth);
 			move = -1;                                        
 			while(move == -1) {                              
 	            cout << "Enter the column where you want to play your move: "; 
@@ -354,6 +1052,9 @@ void tournament_human_vs_omp(Player p1, double time_limit, int maxDepth,
 	// Print stats of tournament                                 
 	cout << "[SLO-POKE VS PUNY-MORTAL] AvgNodesTraversed = " << 
 										totalNodes1 / num_games << endl;
+	if(ponder)
+		cout << "[SLO-POKE VS PUNY-MORTAL] PonderHits = " << mp1->getPonderHits() << "/"
+			 << mp1->getPonderMoves() << endl;
 }
 
 void tournament_omp_vs_omp(Player p1, double time_limit, int maxDepth,
@@ -362,6 +1063,9 @@ void tournament_omp_vs_omp(Player p1, double time_limit, int maxDepth,
 	MpSolver* mp1  = new MpSolver(width, height, winningStreakSize);              
 	MpSolver* mp2  = new MpSolver(width, height, winningStreakSize);                                         					   
 	Player p2 = mp1->oppPlayer(p1);	                                      		 
+	GameRecorder record(p1);
+	bool ponder = EvalConfig::ponder();
+	int ponderDepth = (time_limit > 0) ? width * height : maxDepth;
 	TimePoint start, end;                                                	  					   
 	uint64_t totalNodes1, totalNodes2;                                     					   					   
 	totalNodes2 = 0;                                                  					   					   
@@ -369,13 +1073,16 @@ void tournament_omp_vs_omp(Player p1, double time_limit, int maxDepth,
 	start = NOW();                                           					       					   
 	for(int i = 0; i < num_games; i++) {                                                                                   					   
 		while(1) {                                                                    					   
-			int move = mp1->solve(p1, maxDepth, time_limit);      			                               					   
+			int move = record.solve(*mp1, p1, maxDepth, time_limit);      			                               					   
 			if(move == -1) break;                             	   	                          					   
+			if(ponder) mp1->startPondering(p1, ponderDepth);
 			mp2->playMove(move+1, p1); // add one because this uses 1-indexed col                              	                                 					   
-			move = mp2->solve(p2, maxDepth, time_limit);     			                              					   
+			move = record.solve(*mp2, p2, maxDepth, time_limit);     			                              					   
 			if(move == -1) break;                          				         					   
+			if(ponder) mp2->startPondering(p2, ponderDepth);
 			mp1->playMove(move+1, p2);                      					         					   
 		}                                                    						   					   
+		record.finish();
 		totalNodes1 += mp1->getTotalNodesTraversed();        						   					   
 		totalNodes2 += mp2->getTotalNodesTraversed();         						   					   
 		mp1->resetSolver();                                  						   					   
@@ -399,6 +1106,7 @@ void tournament_cuda_vs_cuda(Player p1, double time_limit, int maxDepth,
     CudaSolver* cu1 = new CudaSolver(width, height, winningStreakSize);
 	CudaSolver* cu2 = new CudaSolver(width, height, winningStreakSize);
 	Player p2 = PlayerHelpers::OppositePlayer(p1);	
+	GameRecorder record(p1);
 	TimePoint start, end;
 	uint64_t totalNodes1, totalNodes2;
 	totalNodes2 = 0;
@@ -406,13 +1114,14 @@ void tournament_cuda_vs_cuda(Player p1, double time_limit, int maxDepth,
 	start = NOW();
 	for(int i = 0; i < num_games; i++) {
 		while(1) {
-			int move = cu1->solve(p1, maxDepth, time_limit);
+			int move = record.solve(*cu1, p1, maxDepth, time_limit);
 			if(move == -1) break;
 			cu2->playMove(move+1, p1); // add one because this uses 1-indexed col
-			move = cu2->solve(p2, maxDepth, time_limit);
+			move = record.solve(*cu2, p2, maxDepth, time_limit);
 			if(move == -1) break;
 			cu1->playMove(move+1, p2);
 		}
+		record.finish();
         std::cout << "round " << i << " nodes traversed\n\tsolver1 " << cu1->getTotalNodesTraversed() << "\n\tsolver2 " << cu2->getTotalNodesTraversed() << std::endl;
 		totalNodes1 += cu1->getTotalNodesTraversed();
 		totalNodes2 += cu2->getTotalNodesTraversed();
@@ -431,4 +1140,79 @@ void tournament_cuda_vs_cuda(Player p1, double time_limit, int maxDepth,
 										totalNodes2 / num_games << endl;
 }
 
+
+/**
+ * @brief      Plays the MCTS solver against one of the minimax solvers. The
+ * solvers take turns at moving first, and the results are counted per solver.
+ */
+template <class Solver>
+void tournament_mcts_vs(const char* name, Player p1, double time_limit, int maxDepth,
+						int width, int height, int winningStreakSize, int num_games) {
+	if(!MctsSolver::supportsGeometry(width, height, winningStreakSize)) {
+		cout << "[ERROR] The MCTS solver does not support this board" << endl;
+		return;
+	}
+	MctsSolver* mcts = new MctsSolver(width, height, winningStreakSize);
+	Solver* other = new Solver(width, height, winningStreakSize);
+	Player p2 = PlayerHelpers::OppositePlayer(p1);
+	GameRecorder record(p1);
+	int mctsWins = 0, otherWins = 0, draws = 0;
+	uint64_t totalNodes1 = 0, totalNodes2 = 0;
+	TimePoint start = NOW();
+	for(int i = 0; i < num_games; i++) {
+		Player mctsPlayer = (i % 2 == 0) ? p1 : p2;
+		Player toMove = p1;
+		while(1) {
+			int move;
+			if(toMove == mctsPlayer) {
+				move = record.solve(*mcts, toMove, maxDepth, time_limit);
+				if(move == -1) break;
+				other->playMove(move + 1, toMove);
+			}
+			else {
+				move = record.solve(*other, toMove, maxDepth, time_limit);
+				if(move == -1) break;
+				mcts->playMove(move + 1, toMove);
+			}
+			toMove = PlayerHelpers::OppositePlayer(toMove);
+		}
+		record.finish();
+		// The solver that ended the game holds the final position
+		Player winner = (toMove == mctsPlayer) ? mcts->getWinner() : other->getWinner();
+		if(winner == Player::None) ++draws;
+		else if(winner == mctsPlayer) ++mctsWins;
+		else ++otherWins;
+		totalNodes1 += mcts->getTotalNodesTraversed();
+		totalNodes2 += other->getTotalNodesTraversed();
+		mcts->resetSolver();
+		other->resetSolver();
+	}
+	double time = DURATION(NOW() - start).count() / num_games;
+
+	// Print stats of tournament
+	cout << "[MCTS VS " << name << "] AvgTime = " << time << endl;
+	cout << "[MCTS VS " << name << "] MCTS.Wins = " << mctsWins << endl;
+	cout << "[MCTS VS " << name << "] " << name << ".Wins = " << otherWins << endl;
+	cout << "[MCTS VS " << name << "] Draws = " << draws << endl;
+	cout << "[MCTS VS " << name << "] MCTS.AvgPlayouts = " << totalNodes1 / num_games << endl;
+	cout << "[MCTS VS " << name << "] " << name << ".AvgNodesTraversed = " <<
+										totalNodes2 / num_games << endl;
+	delete mcts;
+	delete other;
+}
+
+void tournament_mcts_vs_seq(Player p1, double time_limit, int maxDepth,
+							int width, int height, int winningStreakSize,
+							int num_games) {
+	tournament_mcts_vs<SequentialSolver>("SLO-POKE", p1, time_limit, maxDepth, width, height,
+										 winningStreakSize, num_games);
+}
+
+void tournament_mcts_vs_omp(Player p1, double time_limit, int maxDepth,
+							int width, int height, int winningStreakSize,
+							int num_games) {
+	tournament_mcts_vs<MpSolver>("OMP", p1, time_limit, maxDepth, width, height,
+								 winningStreakSize, num_games);
+}
+
 #endif